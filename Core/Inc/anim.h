@@ -0,0 +1,62 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 表示演出エンジン =====
+   演出は区間（anim_seg_t）の並びで、const 表としてフラッシュに置く。
+   anim_poll() を本体ループから呼ぶとコマ時刻が来た分だけ描画して戻る（ブロックしない）。
+   コマ間隔は区間内で per0_ms → per1_ms へイージング付きで変化する */
+
+typedef enum {
+    ANIM_SHUFFLE = 0,   /* 全桁ランダム */
+    ANIM_ROLL    = 1,   /* 全桁を数え上げ、左から lag_ms ずつ遅れて目標で停止（スロット） */
+    ANIM_CASCADE = 2,   /* 左から lag_ms ずつ遅れて乱数化 → 目標へ（波） */
+    ANIM_XFADE   = 3    /* PWM スロットの時分割で現在 → 目標へクロスフェード */
+} anim_kind_t;
+
+typedef enum {
+    EASE_LINEAR = 0,
+    EASE_IN     = 1,    /* 始め緩やか */
+    EASE_OUT    = 2,    /* 終わり緩やか */
+    EASE_INOUT  = 3
+} anim_ease_t;
+
+typedef struct {
+    uint8_t  kind;      /* anim_kind_t */
+    uint8_t  ease;      /* anim_ease_t */
+    uint16_t dur_ms;    /* 区間長 */
+    uint16_t per0_ms;   /* 区間開始時のコマ間隔 */
+    uint16_t per1_ms;   /* 区間終了時のコマ間隔 */
+    uint16_t lag_ms;    /* 桁ごとの遅れ（ROLL/CASCADE） */
+} anim_seg_t;
+
+typedef struct {
+    const anim_seg_t *seg;
+    uint8_t           nseg;
+} anim_t;
+
+/* anim_poll の返値 */
+#define ANIM_IDLE   0U
+#define ANIM_RUN    1U   /* 実行中（今回は描画なし） */
+#define ANIM_FRAME  2U   /* 1コマ描画した */
+#define ANIM_END    3U   /* 終了（目標を表示済み） */
+
+/* 組込み演出 */
+extern const anim_t ANIM_FX_SHUFFLE;   /* 従来のシャッフル（加速→減速） */
+extern const anim_t ANIM_FX_SLOT;      /* スロットマシン */
+extern const anim_t ANIM_FX_CASCADE;
+extern const anim_t ANIM_FX_DISSOLVE;  /* シャッフル → クロスフェード */
+
+/* target は最後に表示するコード（左→右）。NULL なら開始時の表示へ戻る */
+void    anim_start(const anim_t *fx, const uint16_t target[8]);
+void    anim_set_target(const uint16_t target[8]);   /* 実行中に目標を差し替え（秒の更新など） */
+uint8_t anim_poll(void);
+uint8_t anim_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
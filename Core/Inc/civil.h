@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 暦計算（1970-01-01 からの通日を軸にする） =====
+   通日⇔年月日は閏年の規則を 400年周期の中の位置で解く定数時間の式で、
+   日を1日ずつ進める繰り返しを持たない。時差は分単位（+5:45、-9:30 なども可）。
+   日付・時刻の導出はすべて utc_to_local() を通す。
+   通日は負（1970年より前）も扱う。エポック秒は 64bit（2038年を越える） */
+
+typedef struct {
+    int32_t  days;       /* 1970-01-01 からの通日 */
+    int16_t  YYYY;
+    int8_t   MM, DD;     /* 1..12, 1..31 */
+    int8_t   hh, mm, ss;
+    uint8_t  wday;       /* 0=日 … 6=土 */
+} civil_t;
+
+int32_t civil_to_days(int y, int m, int d);           /* 年月日 → 通日（検査なし） */
+void    civil_from_days(int32_t days, civil_t *out);  /* 通日 → 年月日・曜日（時分秒は触らない） */
+uint8_t civil_wday(int32_t days);                     /* 通日 → 曜日（0=日） */
+int64_t civil_epoch(int y, int m, int d, int hh, int mm, int ss);   /* UTC → エポック秒 */
+void    utc_to_local(int64_t epoch_s, int16_t offset_min, civil_t *out);
+
+uint8_t civil_is_leap(int y);
+uint8_t civil_dim(int y, int m);                      /* 月の日数（m=1..12） */
+uint16_t civil_yday(const civil_t *c);                /* 1月1日=0 */
+uint8_t civil_iso_week(const civil_t *c, int16_t *iso_year);   /* ISO 8601 週番号 1..53 */
+
+#ifdef __cplusplus
+}
+#endif
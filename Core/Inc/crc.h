@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== CRC16-CCITT-FALSE（多項式 0x1021、初期値 0xFFFF、反転なし） =====
+   テレメトリのフレーム（telem.c）とフラッシュの記録（kv.c）で共用する。
+   表を持たないビット単位の計算（フラッシュを食わない。どちらも数十バイトしか掛けない） */
+
+uint16_t crc16_ccitt(const uint8_t *p, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,51 +2,239 @@
 #include "main.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <math.h>
+#include "tz.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* ===== UTC 時刻 ===== */
-extern volatile int g_UTC_hh;  /* 0..23 or -1 */
-extern volatile int g_UTC_mm;  /* 0..59 or -1 */
-extern volatile int g_UTC_ss;  /* 0..59 or -1 */
+/* ===== 固定小数点の位置（strtof/float丸めを通さない、NMEA桁まで厳密） ===== */
+#define GPS_FX_INVALID  INT32_MIN   /* 未取得 */
+typedef struct {
+    int16_t deg;    /* 整数度 */
+    int32_t umin;   /* 分×1e6（0..59999999）。deg と同符号、未取得は GPS_FX_INVALID */
+} gps_dm_t;
 
-/* ===== UTC 日付（RMCのddmmyy → 2000+yy） ===== */
-extern volatile int g_UTC_YYYY; /* 4桁 or -1 */
-extern volatile int g_UTC_MM;   /* 1..12 or -1 */
-extern volatile int g_UTC_DD;   /* 1..31 or -1 */
+/* ===== 測位スナップショット ===== */
+/* gps_parser_poll() が1回の解析分をまとめて公開する。gps_parser_snapshot() で
+   丸ごと複写するので、時・分・秒や日付が別々の秒から混ざることはない。
+   整数の未取得値は -1（DOP含む）、固定小数点は GPS_FX_INVALID */
+typedef struct {
+    uint32_t gen;        /* 公開世代（1,2,…）。0=未公開 */
+    uint32_t tick;       /* 公開時の HAL_GetTick() [ms] */
+    gps_dm_t lat;        /* 緯度 北+ 南- */
+    gps_dm_t lon;        /* 経度 東+ 西- */
+    int32_t  alt_mm;     /* 高度[mm] (GGA) */
+    int32_t  spd_mms;    /* 速度[mm/s]（RMC、VTGがあればkm/h側で上書き） */
+    int32_t  cog_cdeg;   /* 対地針路[0.01deg] 真北基準 (VTG) */
+    int16_t  utc_YYYY;   /* UTC 日付（RMCは2000+yy、ZDAは4桁年） */
+    int8_t   utc_MM, utc_DD;
+    int8_t   utc_hh, utc_mm, utc_ss;
+    int16_t  lcl_YYYY;   /* 現地日付（UTC日付＋時差で日跨ぎ補正） */
+    int8_t   lcl_MM, lcl_DD;
+    int8_t   lcl_hh, lcl_mm, lcl_ss;   /* 現地時刻（utc_to_local()、時差は分単位） */
+    int16_t  tz_min;     /* 現地−UTC [分]（位置の時差表と夏時間、tz.h） */
+    int8_t   fix_type;   /* 1=なし 2=2D 3=3D (GSA) */
+    int8_t   sat_used;   /* 測位使用衛星数（連続GSAの合計。連続が切れたところで確定） */
+    int8_t   sat_view;   /* 可視衛星数（GP/GL/GA/GB 各GSVの合計） */
+    int16_t  pdop_c, hdop_c, vdop_c;   /* DOP×100 */
+    uint8_t  upd;        /* この世代で受理した GPS_UPD_* */
+} gps_fix_t;
 
-/* ===== 現地時間（分・秒はUTC、時のみ経度で補正） ===== */
-extern volatile int g_LCL_hh;   /* 0..23 or -1 */
-extern volatile int g_LCL_mm;   /* = g_UTC_mm */
-extern volatile int g_LCL_ss;   /* = g_UTC_ss */
+/* 度＋マイクロ分 → 度（float、表示用）。未取得は NAN */
+static inline float gps_dm_deg(const gps_dm_t *dm)
+{
+    if(dm->umin == GPS_FX_INVALID) return NAN;
+    return (float)dm->deg + (float)dm->umin * (1.0f/60000000.0f);
+}
+
+/* ===== NMEA 文ID ===== */
+/* 話者2字＋文種別3字を 'A'..'Z' → 1..26 の5bitずつに詰める（25bit）。
+   下位15bitが文種別（ディスパッチ表のキー）、上位10bitが話者 */
+#define GPS_NMEA_ID3(a,b,c)      ((uint16_t)((((a)-'@')<<10) | (((b)-'@')<<5) | ((c)-'@')))
+#define GPS_NMEA_TALKER(a,b)     ((uint32_t)((((a)-'@')<<5) | ((b)-'@')))
+#define GPS_NMEA_ID(t0,t1,a,b,c) ((GPS_NMEA_TALKER(t0,t1) << 15) | GPS_NMEA_ID3(a,b,c))
+
+/* gps_parser_poll() / gps_poll_line() の返値ビット */
+#define GPS_UPD_RMC  0x01U
+#define GPS_UPD_GGA  0x02U
+#define GPS_UPD_ZDA  0x04U
+#define GPS_UPD_VTG  0x08U
+#define GPS_UPD_GSA  0x10U
+#define GPS_UPD_GSV  0x20U
+#define GPS_UPD_GLL  0x40U
+#define GPS_UPD_USER 0x80U   /* gps_parser_set_handler() / gps_set_handler() で追加した文 */
+
+/* ===== 解析器の設定 ===== */
+/* 受信リング（2の冪サイズ）。解析器ごとに1本持つ */
+#ifndef GPS_RX_BUF_SZ
+#define GPS_RX_BUF_SZ 256
+#endif
+#if (GPS_RX_BUF_SZ & (GPS_RX_BUF_SZ-1)) != 0
+#error "GPS_RX_BUF_SZ は 2の冪(256/512/1024等)にしてください"
+#endif
+/* DMA循環受信（1=有効）。hdmarx 未リンク時は自動で1バイト割込みへ戻る */
+#ifndef GPS_RX_USE_DMA
+#define GPS_RX_USE_DMA 1
+#endif
+#ifndef GPS_LINE_MAX
+#define GPS_LINE_MAX 128              /* NMEA規定は82字。余裕を見て128 */
+#endif
+#if GPS_LINE_MAX > 255
+#error "GPS_LINE_MAX は 255 以下にしてください（オフセットは uint8_t）"
+#endif
+#define GPS_MAX_FIELDS  24
+#define GPS_ROUTE_SLOTS 16            /* 文ディスパッチ表（2の冪） */
+#ifndef GPS_MAX_UARTS
+#define GPS_MAX_UARTS   2             /* gps_parser_attach() できる UART の数 */
+#endif
 
-/* ===== 現地日付（UTC日付＋経度由来の時差で日跨ぎ補正） ===== */
-extern volatile int g_LCL_YYYY; /* 4桁 or -1 */
-extern volatile int g_LCL_MM;   /* 1..12 or -1 */
-extern volatile int g_LCL_DD;   /* 1..31 or -1 */
+#define GPS_RX_OVF_LOG 4
+#define GPS_LAST_SENTENCE_MAX 82
+
+/* 組込み文種別の添字（gps_stats_t の ok[] / bad[]） */
+enum { GPS_ST_RMC = 0, GPS_ST_GGA, GPS_ST_ZDA, GPS_ST_VTG, GPS_ST_GSA, GPS_ST_GSV, GPS_ST_GLL, GPS_ST_N };
+
+/* ===== 解析器（受信機1台ぶんの状態） ===== */
+/* 受信リング・トークナイザ・ディスパッチ表・作業中の測位と公開側・カウンタを全部持つ。
+   静的な状態は HAL コールバックが UART から解析器を引く表だけなので、解析器どうしは
+   独立に（ホストでは別スレッドから）動かせる。中身は gps.c 専用で、外からは API で触る */
+typedef struct gps_parser gps_parser_t;
+
+/* 文ハンドラ。チェックサムOKの文で呼ばれ、1=受理 0=不正 を返す。
+   フィールドは gps_parser_field(p, i)（0="$GPxxx"）で参照 */
+typedef int  (*gps_parser_handler_t)(gps_parser_t *p);
+/* 旧形式の文ハンドラ（既定の解析器用）。フィールドは gps_nmea_field(i) で参照 */
+typedef int  (*gps_nmea_handler_t)(void);
+/* 公開の通知（gps_parser_poll()/feed() の中から、公開した測位を渡す） */
+typedef void (*gps_fix_cb_t)(const gps_fix_t *fix, void *ctx);
+
+typedef struct {
+    volatile uint32_t rx_bytes;
+    volatile uint32_t rx_lines;
+    /* 受信リングのあふれ（本体ループの遅れ）。bad[] は回線側の誤りだけを数える */
+    volatile uint32_t rx_dropped;      /* あふれで捨てたバイト */
+    volatile uint32_t rx_overflows;    /* あふれの発生回数（連続分は1回） */
+    volatile uint32_t rx_resync;       /* 欠落のため途中で捨てた文 */
+    volatile uint32_t rx_ckerr;        /* チェックサム不一致・形の崩れた文（文種別を問わず） */
+    volatile uint16_t rx_hwm;          /* リング使用量の最大 [byte] */
+    volatile uint32_t rx_ovf_tick[GPS_RX_OVF_LOG]; /* 直近の発生時刻 HAL_GetTick（rx_overflows % LOG 番目が次） */
+    volatile uint32_t ok[GPS_ST_N], bad[GPS_ST_N];
+} gps_stats_t;
 
-/* ===== 位置・高度・速度（float 32bit） ===== */
-extern volatile float g_LTT;    /* 緯度[deg], 北+ 南- */
-extern volatile float g_LGT;    /* 経度[deg], 東+ 西- */
-extern volatile float g_ALT;    /* 高度[m] (GGA) */
-extern volatile float g_SPD;    /* 速度[m/s] (RMC knots→m/s) */
+typedef struct {
+    uint16_t id;                      /* GPS_NMEA_ID3、0=空き */
+    uint8_t  upd;                     /* poll の返値ビット */
+    uint8_t  st;                      /* gps_stats_t の添字、0xFF=数えない */
+    gps_parser_handler_t fn;
+    gps_nmea_handler_t   legacy;      /* gps_set_handler() で登録した旧形式 */
+} gps_route_t;
 
-/* ===== API ===== */
+struct gps_parser {
+    /* 受信（割込みが書き、本体が読む） */
+    UART_HandleTypeDef *hu;
+    volatile uint8_t  rx_byte;
+    volatile uint8_t  ring[GPS_RX_BUF_SZ];
+    volatile uint16_t w, r;
+    volatile uint8_t  rx_skip, rx_gap, ovf_on;
+    volatile uint16_t skip_to;
+    uint8_t           dma_on;
+    uint16_t          dma_pos;
+    /* NMEA 逐次トークナイザ */
+    struct {
+        char     line[GPS_LINE_MAX];
+        uint8_t  fo[GPS_MAX_FIELDS];
+        uint8_t  L, nf, star, ck, ck_rx, st, route, seq;
+        uint32_t id;
+    } nm;
+    gps_route_t route[GPS_ROUTE_SLOTS];
+    /* 文を跨いで持つもの（連続GSAの合計、系ごとの可視衛星数） */
+    uint8_t  gsa_seq, gsa_used, gsa_open;   /* gsa_open: 合計を未確定の連続GSAがある */
+    uint8_t  gsv_view[4];
+    /* 測位：作業中と二重バッファの公開側 */
+    gps_fix_t         wk;
+    gps_fix_t         fix[2];
+    volatile uint32_t fix_gen;
+    gps_fix_cb_t      on_fix;
+    void             *on_fix_ctx;
+    /* 時差の状態。tz は既定で tz_own、既定の解析器は tz_default() を指す */
+    tz_ctx_t  tz_own;
+    tz_ctx_t *tz;
+    gps_stats_t st;
+    volatile char last[GPS_LAST_SENTENCE_MAX];   /* 直近の受理文 */
+};
+
+/* ===== 解析器 API ===== */
+void     gps_parser_init(gps_parser_t *p);                             /* 全部を初期化（UART は繋がない） */
+/* UART からの受信を始める（GPS_RX_USE_DMA と hdmarx の有無で DMA循環か1バイト割込み）。
+   返値: 1=開始 0=表が満杯（GPS_MAX_UARTS） */
+uint8_t  gps_parser_attach(gps_parser_t *p, UART_HandleTypeDef *huart);
+/* リングに溜まった分を解析して公開。返値: 受理した文の GPS_UPD_* の論理和 */
+uint8_t  gps_parser_poll(gps_parser_t *p);
+/* リングを通さずバイト列を直接解析して公開（ホストのログ解析など）。返値は poll と同じ */
+uint8_t  gps_parser_feed(gps_parser_t *p, const void *buf, uint32_t n);
+uint32_t gps_parser_snapshot(const gps_parser_t *p, gps_fix_t *out);   /* 返値: 世代（0=未公開） */
+void     gps_parser_on_fix(gps_parser_t *p, gps_fix_cb_t cb, void *ctx);
+/* 文種別ハンドラの追加・置換。fn=NULL で無効化。返値: 1=成功, 0=表が満杯/不正ID */
+int      gps_parser_set_handler(gps_parser_t *p, const char *id3, gps_parser_handler_t fn);
+/* ハンドラ内でのみ有効：現在の文の GPS_NMEA_ID / フィールド数 / i番目のフィールド */
+uint32_t    gps_parser_id(const gps_parser_t *p);
+uint8_t     gps_parser_nfields(const gps_parser_t *p);
+const char *gps_parser_field(const gps_parser_t *p, uint8_t i);
+uint16_t    gps_parser_pending(const gps_parser_t *p);                 /* リングの未解析バイト数 */
+
+/* 数値欄の解析を直接呼ぶ（状態を持たない。試験用）。返値: 1=受理 0=不正 */
+int gps_fx_parse(const char *s, uint8_t frac, int32_t *out);           /* "[-]iii.fff" → 値×10^frac */
+int gps_dm_parse(const char *s, char hemi_neg, char hemi, uint16_t deg_max, gps_dm_t *out);   /* ddmm.mmmm → 度＋マイクロ分 */
+
+/* ===== 既定の解析器（従来の API） ===== */
+/* 以下は gps_default への薄い包みで、本体ループと割込みの使い方は従来どおり */
+extern gps_parser_t gps_default;
+
+/* 受信開始。GPS_RX_USE_DMA=1(既定)かつ huart->hdmarx がリンク済みなら
+   DMA循環＋IDLE検出で受信、そうでなければ1バイト割込みで受信 */
 void    gps_init(UART_HandleTypeDef *huart);
-/* NMEAを1行ずつ解析。RMC/GGAで上記グローバルを更新。
-   返値: 0=更新なし, 1=RMC更新, 2=GGA更新, 3=両方 */
+/* 受信済みNMEAを解析し、文種別ごとのハンドラで測位を更新・公開。
+   返値: 受理した文の GPS_UPD_* の論理和（0=更新なし） */
 uint8_t gps_poll_line(void);
+/* 最新の公開測位を *out へ複写（割込み・本体どちらからでも可）。
+   返値: 世代（out->gen と同じ、0=未公開） */
+uint32_t gps_get_snapshot(gps_fix_t *out);
 
-/* ===== デバッグ指標 ===== */
-extern volatile uint32_t gps_rx_bytes;
-extern volatile uint32_t gps_rx_lines;
-extern volatile uint32_t gps_rmc_ok, gps_rmc_bad;
-extern volatile uint32_t gps_gga_ok, gps_gga_bad;
+/* 文種別ハンドラの追加・置換（gps_init() 後）。id3="ZDA" 等、fn=NULL で無効化。
+   返値: 1=成功, 0=表が満杯/不正ID */
+int         gps_set_handler(const char *id3, gps_nmea_handler_t fn);
+/* ハンドラ内でのみ有効：現在の文の GPS_NMEA_ID / フィールド数 / i番目のフィールド */
+uint32_t    gps_nmea_id(void);
+uint8_t     gps_nmea_nfields(void);
+const char *gps_nmea_field(uint8_t i);
 
-#define GPS_LAST_SENTENCE_MAX 82
-extern volatile char     gps_last_sentence[GPS_LAST_SENTENCE_MAX];
+/* ===== デバッグ指標（既定の解析器） ===== */
+uint16_t gps_rx_pending(void);    /* リングの未解析バイト数 */
+uint16_t gps_rx_capacity(void);   /* GPS_RX_BUF_SZ */
+#define gps_rx_bytes      (gps_default.st.rx_bytes)
+#define gps_rx_lines      (gps_default.st.rx_lines)
+#define gps_rx_dropped    (gps_default.st.rx_dropped)
+#define gps_rx_overflows  (gps_default.st.rx_overflows)
+#define gps_rx_resync     (gps_default.st.rx_resync)
+#define gps_rx_hwm        (gps_default.st.rx_hwm)
+#define gps_rx_ovf_tick   (gps_default.st.rx_ovf_tick)
+#define gps_rmc_ok        (gps_default.st.ok [GPS_ST_RMC])
+#define gps_rmc_bad       (gps_default.st.bad[GPS_ST_RMC])
+#define gps_gga_ok        (gps_default.st.ok [GPS_ST_GGA])
+#define gps_gga_bad       (gps_default.st.bad[GPS_ST_GGA])
+#define gps_zda_ok        (gps_default.st.ok [GPS_ST_ZDA])
+#define gps_zda_bad       (gps_default.st.bad[GPS_ST_ZDA])
+#define gps_vtg_ok        (gps_default.st.ok [GPS_ST_VTG])
+#define gps_vtg_bad       (gps_default.st.bad[GPS_ST_VTG])
+#define gps_gsa_ok        (gps_default.st.ok [GPS_ST_GSA])
+#define gps_gsa_bad       (gps_default.st.bad[GPS_ST_GSA])
+#define gps_gsv_ok        (gps_default.st.ok [GPS_ST_GSV])
+#define gps_gsv_bad       (gps_default.st.bad[GPS_ST_GSV])
+#define gps_gll_ok        (gps_default.st.ok [GPS_ST_GLL])
+#define gps_gll_bad       (gps_default.st.bad[GPS_ST_GLL])
+#define gps_last_sentence (gps_default.last)
 
 #ifdef __cplusplus
 }
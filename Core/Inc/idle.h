@@ -0,0 +1,38 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 本体ループの休止（Sleep モード） =====
+   本体ループは1周の終わりに idle_wait() を呼び、次の仕事まで WFI でコアを止める。
+   起こすのは、割込み側が idle_event() で知らせる仕事（GPS 受信の区切り・PPS・ボタン）と
+   SysTick の 1ms 境界（演出のコマ・秒境界の外挿・定期送出はミリ秒で判定するため）。
+   TIM6（PWM リフレッシュ）や送信 DMA の割込みだけで起きたときは、そのまま眠り直す。
+   判定から WFI までは割込みを禁止しておき、その間に来た割込みは WFI を素通りさせる
+   （PRIMASK=1 でも保留中の割込みで WFI は戻る）。
+   STOP は HSE/PLL ごと TIM・USART を止めるので、表示の点灯中（TIM6/TIM1 と GPS 受信が
+   常に動く）には使えない。ここでは Sleep のみ */
+
+#ifndef IDLE_ENABLE
+#define IDLE_ENABLE 1
+#endif
+
+#if IDLE_ENABLE
+extern volatile uint32_t idle_wakeups;   /* WFI から戻った回数（眠り直しを含む） */
+extern volatile uint16_t idle_busy_pm;   /* 直近1秒の起きていた割合 [‰]（TIM2 で測る） */
+
+void idle_init(void);                    /* tk_init() の後（TIM2 を時間軸に使う） */
+void idle_wait(void);                    /* 本体ループの末尾から */
+void idle_event(void);                   /* 割込みから：本体ループに仕事がある */
+#else
+#define idle_init()     ((void)0)
+#define idle_wait()     ((void)0)
+#define idle_event()    ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 設定の不揮発保存（フラッシュ末尾 2ページのログ形式キー／値） =====
+   2KB のページ2枚を交互に使う。書込みは有効ページの末尾へ記録を足していくだけで、
+   満杯になったら生きている値だけを空きページへ写し（詰め直し）、最後にページ見出しを
+   書いて切替える。見出しのないページは無効なので、どこで電源が落ちても旧ページが残る。
+   記録は CRC16 つきで、書きかけの記録は起動時の走査で捨てる。
+   2枚を交互に消すので消去回数は両ページで揃う（値の更新ごとには消さない）。
+
+   kv_set() は RAM の写しを書き換えるだけで、フラッシュへは kv_poll() が本体ループの
+   1周ごとに KV_PROG_PER_POLL 半語ずつ書く（1半語 ≒ 50us、その間は割込みも待たされる）。
+   ページ消去（20〜40ms、割込みが止まる）は may_erase=1 の周にだけ行う。表示の PWM が
+   止まっても見た目の変わらない時（全桁フル輝度・演出なし）に本体側が許す。
+   起動時の kv_init() は記録数に比例する1回の走査で、ヒープは使わない */
+
+#ifndef KV_ENABLE
+#define KV_ENABLE 1
+#endif
+#ifndef KV_MAX_KEYS
+#define KV_MAX_KEYS       8U        /* RAM に持つキーの数 */
+#endif
+#ifndef KV_MAX_LEN
+#define KV_MAX_LEN        20U       /* 値の最大長 [byte]（偶数） */
+#endif
+#ifndef KV_PROG_PER_POLL
+#define KV_PROG_PER_POLL  4U        /* kv_poll() 1回で書く半語の数 */
+#endif
+#define KV_PAGE_SIZE      2048U     /* STM32F303x8 のページ */
+
+/* ==== キー（追加はここへ。番号は変えない、0 と 0xFFFF は使わない） ==== */
+#define KV_DISP_MODE    0x0001U     /* uint8_t  0=現地 1=UTC */
+#define KV_FX_NEXT      0x0002U     /* uint8_t  次に使う演出 */
+#define KV_ENABLE_MASK  0x0003U     /* uint8_t  桁の表示許可 */
+#define KV_LAST_FIX     0x0004U     /* kv_fix_t 最後の測位（起動直後の時差と推定時刻の確かめ） */
+
+typedef struct {
+    int32_t  lat_e5, lon_e5;        /* [1e-5 度] 北+ 東+。INT32_MIN=位置なし */
+    uint32_t utc_s;                 /* 保存した時点の UTC エポック秒（0=時刻なし） */
+    int16_t  tz_min;                /* その時の現地−UTC [分] */
+    uint16_t rsv;
+} kv_fix_t;
+
+#if KV_ENABLE
+extern volatile uint32_t kv_erases;     /* この起動以降のページ消去回数 */
+extern volatile uint32_t kv_seq;        /* 有効ページの世代（累計の詰め直し回数） */
+
+void    kv_init(void);                                        /* 起動時、表示の開始前に */
+uint8_t kv_get(uint16_t key, void *buf, uint8_t len);         /* 返値: 読めた長さ（0=未保存） */
+uint8_t kv_set(uint16_t key, const void *buf, uint8_t len);   /* 1=受理（同じ値なら書かない） 0=長すぎ・表が満杯 */
+void    kv_poll(uint8_t may_erase);                           /* 本体ループから */
+uint8_t kv_pending(void);                                     /* 1=書き残しがある */
+void    kv_flush(void);                                       /* 書き残しを全部書く（止まる。リセット前・試験用） */
+#else
+#define kv_init()              ((void)0)
+#define kv_get(k, b, n)        ((void)(k), (void)(b), (void)(n), (uint8_t)0)
+#define kv_set(k, b, n)        ((void)(k), (void)(b), (void)(n), (uint8_t)0)
+#define kv_poll(e)             ((void)(e))
+#define kv_pending()           ((uint8_t)0)
+#define kv_flush()             ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
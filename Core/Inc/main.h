@@ -54,6 +54,8 @@ void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
 void user_main(void);
+void user_setup(void);
+void user_loop(void);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
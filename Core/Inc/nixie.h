@@ -9,17 +9,74 @@ extern "C" {
 /* --- アクティブLow駆動なら有効化（必要ならビルド設定で -DNIXIE_ACTIVE_LOW ）--- */
 /* // #define NIXIE_ACTIVE_LOW */
 
+/* --- 1=TIM1＋DMA1(Ch2/Ch3)でフレームを送出（CPUは起動のみ）、0=CPUでBSRR直書き --- */
+#ifndef NIXIE_USE_DMA
+#define NIXIE_USE_DMA 1
+#endif
+
+/* --- PWM リフレッシュ：フレーム周波数 [Hz] と 1フレームの輝度段数 --- */
+#ifndef NIXIE_PWM_FRAME_HZ
+#define NIXIE_PWM_FRAME_HZ 100U
+#endif
+#ifndef NIXIE_PWM_STEPS
+#define NIXIE_PWM_STEPS    16U      /* 8の倍数 */
+#endif
+
 void nixie_init(void);                         /* 内部状態の初期化（有効マスク=0xFF） */
 void nixie_set_enable_mask(uint8_t mask);      /* 1=表示許可(桁単位) 左→右でbit7..bit0 */
 
 void nixie_show_integer8_str(const char *s8);  /* '0'..'9' と先頭 '-' を解釈（'-'=左右ドット1桁） */
 void nixie_show_decimal_str(const char *s8);   /* '0'..'9' と '.' を解釈（'.'=左ドット1桁） */
 void nixie_show_time_hms(uint8_t hh, uint8_t mm, uint8_t ss); /* "HH.MM.SS" 形式表示 */
+void nixie_time_codes(uint8_t hh, uint8_t mm, uint8_t ss, uint16_t codes_lr[8]); /* 同じ表示のコードだけ作る */
 
 /* 直接8桁の数字（0-9）を左→右で指定して表示（演出用） */
 void nixie_show_digits_lr(uint8_t d0,uint8_t d1,uint8_t d2,uint8_t d3,
                           uint8_t d4,uint8_t d5,uint8_t d6,uint8_t d7);
 
+/* 1桁ぶんの12bit表示コード（digit>9 で数字なし）。下のコード指定APIへ渡す用 */
+uint16_t nixie_code(uint8_t digit, uint8_t dotL, uint8_t dotR);
+void     nixie_show_codes(const uint16_t codes_lr[8]);   /* 8桁の表示コード（左→右）を表示 */
+void     nixie_get_codes(uint16_t codes_lr[8]);          /* 表示中（巡回中は保持中）のコード */
+
+/* ===== 輝度とカソード保護（TIM6 割込みで駆動） =====
+   enable マスクを点滅させて桁ごとの duty を作る。nixie_pwm_start 以降有効 */
+void    nixie_pwm_start(void);                         /* TIM6 を NIXIE_PWM_FRAME_HZ×STEPS で起動 */
+void    nixie_set_duty(uint8_t pos, uint8_t duty);     /* pos=左→右 0..7、duty=0..NIXIE_PWM_STEPS */
+void    nixie_set_brightness(uint8_t duty);            /* 全桁同じ duty */
+uint8_t nixie_get_duty(uint8_t pos);                   /* pos=左→右 0..7 */
+uint8_t nixie_acp_start(uint8_t cycles, uint16_t step_ms); /* 全カソードを cycles 周巡回。1=開始 */
+uint8_t nixie_acp_active(void);                        /* 巡回中は表示要求を保持だけする */
+void    nixie_xfade(const uint16_t to_lr[8], uint8_t level); /* 各フレームの level スロットだけ to を表示。NULL=解除 */
+void    nixie_pwm_irq(void);                           /* TIM6_DAC1_IRQHandler から呼ぶ */
+
+#if NIXIE_USE_DMA
+/* 8桁の表示コード（左→右）を送出して即座に戻る。cb は STCP ラッチ後に
+   割込み文脈で呼ばれる（NULL可）。送出中なら最新の1枚を予約し、前の予約は捨てる。
+   返値: 1=送出開始, 2=予約, 0=カソード巡回中（保持のみ、cb は呼ばれない） */
+typedef void (*nixie_done_cb_t)(void);
+uint8_t nixie_show_codes_async(const uint16_t codes_lr[8], nixie_done_cb_t cb);
+uint8_t nixie_busy(void);
+void    nixie_dma_irq(void);   /* DMA1_Channel3_IRQHandler から呼ぶ */
+
+/* 次の秒の先送り：フレームをシフトレジスタへ送るだけで STCP は叩かず、秒境界（PPS の
+   捕捉割込み）で nixie_latch_armed() が STCP を1回叩いて切替える。表示が変わるのは
+   割込みの入口からの一定の遅れだけで、整形・シフトの時間は前の秒のうちに済む。
+   リフレッシュの送出で上書きされたら、その後で今のマスクで送り直す。
+   他の表示（nixie_show_codes など）・巡回・クロスフェードで取消し */
+#ifndef NIXIE_PPS_LATCH
+#define NIXIE_PPS_LATCH 1
+#endif
+#define NIXIE_ARM_NONE   0U
+#define NIXIE_ARM_WANT   1U     /* 送出待ち（DMA が空けば送る） */
+#define NIXIE_ARM_SHIFT  2U     /* シフトレジスタへ送出中 */
+#define NIXIE_ARM_READY  3U     /* ラッチ待ち */
+#define NIXIE_ARM_SHOWN  4U     /* ラッチ済み（表示中） */
+uint8_t nixie_arm_codes(const uint16_t codes_lr[8]);   /* 1=受理、0=巡回・クロスフェード中 */
+void    nixie_latch_armed(void);                        /* PPS 割込みから。READY でなければ何もしない */
+uint8_t nixie_arm_state(void);                          /* NIXIE_ARM_* */
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,68 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== DWT サイクルカウンタによる区間計測 =====
+   PROF_BEGIN(id) 〜 PROF_END(id) を同じブロック内に置くと、その区間のサイクル数を
+   プローブ id の回数・最小・最大・平均として静的表へ積む。
+   PROF_ENABLE=0（既定）ではマクロごと消え、コードも RAM も使わない。
+   本体ループ側の区間は、その間に入った割込みの時間も含む（最大値＝予算の見積り用）。
+   入れ子にした外側の区間も内側の計測の手間（数十サイクル）を含む */
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+typedef enum {
+    PROF_LOOP = 0,        /* user_main の1周 */
+    PROF_GPS_POLL,        /* gps_poll_line() 全体 */
+    PROF_NMEA_SENT,       /* 1文の振り分け＋解析（チェックサム照合済み） */
+    PROF_NIXIE_EMIT,      /* 1フレームの送出（CPU シフト、または DMA 起動） */
+    PROF_ANIM_POLL,       /* anim_poll() */
+    PROF_USART1_ISR,      /* GPS 受信割込み（1バイト割込み／IDLE） */
+    PROF_DMA1_CH5_ISR,    /* GPS 受信 DMA 半分・満了 */
+    PROF_TIM6_ISR,        /* PWM リフレッシュ */
+    PROF_TIM3_ISR,        /* PPS キャプチャ */
+    PROF_DMA1_CH3_ISR,    /* 表示フレーム送出完了 */
+    PROF_WAKE,            /* WFI から本体の仕事へ戻るまで（起こした割込みの処理を含む） */
+    PROF_N
+} prof_id_t;
+
+#if PROF_ENABLE
+typedef struct {
+    uint32_t n;           /* 回数 */
+    uint32_t min, max;    /* [cycle]（計測自体の手間は差し引き済み） */
+    uint64_t sum;
+} prof_stat_t;
+
+void     prof_init(void);                      /* DWT を有効化し、計測の手間を較正 */
+void     prof_reset(void);
+void     prof_get(prof_id_t id, prof_stat_t *out);
+void     prof_add(prof_id_t id, uint32_t cyc);
+const char *prof_name(prof_id_t id);
+void     prof_dump(UART_HandleTypeDef *hu);    /* 表を文字で送る（ブロッキング。TELEM_ENABLE 時は TM_TEXT で） */
+void     prof_console(UART_HandleTypeDef *hu); /* 本体ループから：'p'=表示, 'r'=消去 */
+
+/* 時刻源の差し替え口（ホストビルドは実時間を SYSCLK 換算で返す） */
+#ifndef PROF_CYCCNT
+#define PROF_CYCCNT()  (DWT->CYCCNT)
+#endif
+static inline uint32_t prof_now(void){ return PROF_CYCCNT(); }
+
+#define PROF_BEGIN(id)  const uint32_t prof_t0_##id = prof_now()
+#define PROF_END(id)    prof_add((id), prof_now() - prof_t0_##id)
+#else
+#define prof_init()         ((void)0)
+#define prof_reset()        ((void)0)
+#define prof_console(hu)    ((void)0)
+#define PROF_BEGIN(id)      ((void)0)
+#define PROF_END(id)        ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
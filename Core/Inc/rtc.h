@@ -0,0 +1,37 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 内蔵 RTC（バックアップ領域）による時刻の持越し =====
+   RTC の暦とバックアップレジスタはシステムリセット（ウォッチドッグ・書換え・リセット
+   ボタン）では消えず、VBAT に電池があれば電源断も越える。GPS に同期している間に
+   時刻を書いておき、起動直後に読んで「推定時刻」として表示する（tk_seed()）。
+   VBAT が VDD 直結の基板では電源断で消えるので、rtc_get() は 0 を返す。
+   クロックは既定で LSI（±数%、リセットを跨ぐ数秒の間なら十分）。32.768kHz の
+   水晶があれば RTC_USE_LSE=1 で電源断中も ppm 級で進む。
+   暦の書換えは INIT モードの出入りで RTCCLK 数周期（LSI で ~100µs）止まる */
+
+#ifndef RTC_ENABLE
+#define RTC_ENABLE   1
+#endif
+#ifndef RTC_USE_LSE
+#define RTC_USE_LSE  0
+#endif
+
+#if RTC_ENABLE
+void    rtc_init(void);                  /* 起動時。動いていればそのまま、止まっていれば設定し直す */
+uint8_t rtc_get(int64_t *utc_s);         /* 1=書いた時刻から数え続けている（UTC エポック秒） */
+void    rtc_set(int64_t utc_s);          /* 秒境界で呼ぶ（2000〜2099年） */
+#else
+#define rtc_init()    ((void)0)
+#define rtc_get(t)    ((void)(t), (uint8_t)0)
+#define rtc_set(t)    ((void)(t))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -58,9 +58,14 @@ void SysTick_Handler(void);
 void EXTI0_IRQHandler(void);
 void EXTI1_IRQHandler(void);
 void EXTI4_IRQHandler(void);
+void DMA1_Channel5_IRQHandler(void);
 void USART1_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM3_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void TIM6_DAC1_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
 
 /* USER CODE END EFP */
 
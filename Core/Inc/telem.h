@@ -0,0 +1,66 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== USART2（VCP）へのバイナリテレメトリ =====
+   1フレーム = COBS( type | seq | 本文 | CRC16 ) + 0x00。
+   CRC16 は CCITT-FALSE（多項式 0x1021、初期値 0xFFFF）を type〜本文に掛け、下位から置く。
+   本文の数値はすべてリトルエンディアン、符号付きは2の補数。seq は送出ごとに+1（欠落検出用）。
+   送出は DMA1 Ch7 → USART2.TDR。符号化済みフレームを送信リングへ積み、DMA が連続区間ごとに送る。
+   リングに入らないフレームは捨てて telem_drops に数える（本体ループは待たせない）。
+   復号は Host/tools/telem_dump.c */
+
+#ifndef TELEM_ENABLE
+#define TELEM_ENABLE 1
+#endif
+#ifndef TELEM_TX_BUF
+#define TELEM_TX_BUF 512U          /* 送信リング [byte]（2の冪） */
+#endif
+#ifndef TELEM_SLOW_EVERY_S
+#define TELEM_SLOW_EVERY_S 5U      /* 受信カウンタ・直近の文を送る間隔 [s] */
+#endif
+#define TELEM_BODY_MAX 96U
+
+/* 種別と本文（オフセット:型） */
+#define TM_FIX   0x01U  /* 0:gen u32  4:tick u32  8:lat_deg i16  10:lat_umin i32  14:lon_deg i16
+                           16:lon_umin i32  20:alt_mm i32  24:spd_mms i32  28:cog_cdeg i32
+                           32:YYYY i16  34:MM 35:DD 36:hh 37:mm 38:ss i8  39:tz_min i16
+                           41:fix_type 42:sat_used 43:sat_view i8  44:hdop_c i16  46:upd u8（47） */
+#define TM_GPS   0x02U  /* 0:rx_bytes 4:rx_lines 8:dropped 12:overflows 16:resync u32  20:hwm u16
+                           22〜:RMC GGA ZDA VTG GSA GSV GLL の順に ok u32, bad u32（78） */
+#define TM_TIME  0x03U  /* 0:tick u32  4:tk_state u8  5:utc_sod i32  9:sub_us u32  13:freq_err_ppb i32
+                           17:pps_count 21:pps_reject 25:relabel u32
+                           29:busy_pm u16（起きていた割合‰、休止なしは 1000）  31:wakeups u32（35） */
+#define TM_DISP  0x04U  /* 0〜:表示コード u16×8（左→右） 16〜:duty u8×8  24:flags u8（25）
+                           flags: bit0=UTC表示 bit1=演出中 bit2=カソード巡回中 */
+#define TM_NMEA  0x05U  /* 直近に受理した NMEA 文（文字列、終端なし） */
+#define TM_TEXT  0x06U  /* 文字列（計測表の表示など） */
+#define TM_PROF  0x07U  /* 0:id u8  1:n 5:min 9:mean 13:max u32 [cycle]  17〜:名前
+                           （PROF_ENABLE 時、毎秒1プローブずつ巡回） */
+
+#define TM_DISP_UTC   0x01U
+#define TM_DISP_ANIM  0x02U
+#define TM_DISP_ACP   0x04U
+
+#if TELEM_ENABLE
+extern volatile uint32_t telem_frames;   /* 送信リングへ積んだフレーム */
+extern volatile uint32_t telem_drops;    /* 空き不足で捨てたフレーム */
+
+void    telem_init(UART_HandleTypeDef *hu);   /* 初期化済みの UART（送信有効）に DMA 送信を足す */
+uint8_t telem_send(uint8_t type, const void *body, uint16_t n);  /* 1=積んだ 0=捨てた */
+uint8_t telem_text(const char *s, uint16_t n);   /* 空きが出るまで待つ（最大でリング1周の送出時間） */
+void    telem_poll(uint8_t flip, uint8_t disp_flags);  /* 本体ループから：秒ごとの定期送出 */
+uint8_t telem_busy(void);                     /* 1=送出中／未送出あり */
+void    telem_dma_irq(void);                  /* DMA1_Channel7_IRQHandler から呼ぶ */
+#else
+#define telem_init(hu)          ((void)0)
+#define telem_poll(flip, fl)    ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include "main.h"
+#include "gps.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== PPS 同期の時刻保持 =====
+   TIM2（32bit、タイマクロック直結）を時間軸とし、PPS(PB5) の立下りを
+   TIM3_CH2 のインプットキャプチャで刻む。直後に届く RMC/ZDA/GLL の時刻を
+   その PPS のラベルとし、以後は PPS ごとに1秒進める。
+   PPS 周期から発振器の周波数誤差を推定し、PPS 喪失時はその推定値で秒境界を外挿。
+   PPS が無い構成では NMEA 到着時刻を秒境界とみなす（従来相当の精度）
+   起動直後は RTC などの推定時刻で始められる（tk_seed()、TK_ESTIMATE）。最初のラベルとの
+   差が TK_SLEW_MAX_S 以内なら表示を跳ばさずに寄せる：遅れは半秒ごとに1つ進め、
+   進みは2秒に1度同じ秒を繰り返す。寄せ終わるまで tk_unsynced()=1 */
+
+typedef enum {
+    TK_UNSYNC   = 0,   /* 時刻ラベル未取得 */
+    TK_NMEA     = 1,   /* NMEA 到着時刻で秒境界を推定（PPSなし） */
+    TK_PPS      = 2,   /* PPS に同期 */
+    TK_HOLDOVER = 3,   /* PPS 喪失、推定周波数で外挿中 */
+    TK_ESTIMATE = 4    /* GPS の時刻を待つ間、起動時の推定時刻で数えている */
+} tk_state_t;
+
+/* NMEA の時刻が「直前の PPS」を指す受信機なら 0（u-blox 等）、
+   「次の PPS」を指す受信機なら 1 */
+#ifndef TK_NMEA_LABELS_NEXT_PPS
+#define TK_NMEA_LABELS_NEXT_PPS 0
+#endif
+
+void       tk_init(void);                    /* TIM2/TIM3 と PB5 のキャプチャ設定 */
+void       tk_capture_irq(void);             /* TIM3_IRQHandler から呼ぶ */
+void       tk_on_fix(const gps_fix_t *fx);   /* 時刻を含む文の公開直後に呼ぶ */
+uint8_t    tk_poll(void);                    /* 1=秒境界を跨いだ（表示更新の合図） */
+void       tk_seed(int64_t utc_s);           /* tk_init() の後、GPS より前の推定時刻で始める */
+
+/* PPS に同期中（TK_PPS）、次の PPS が1秒±許容の窓に来たら捕捉割込みの先頭で呼ぶ。
+   周期の推定などより前なので、割込みの入口から一定の遅れで走る（表示のラッチ用） */
+typedef void (*tk_pps_hook_t)(void);
+void       tk_set_pps_hook(tk_pps_hook_t fn);   /* NULL=外す */
+
+int32_t    tk_utc_sod(void);                 /* 現在の UTC 通日秒 0..86399、-1=未同期（寄せている間は表示側の値） */
+uint32_t   tk_sub_us(void);                  /* 現在秒内の経過[µs] */
+tk_state_t tk_state(void);
+uint8_t    tk_unsynced(void);                /* 1=推定時刻か、GPS の時刻へ寄せている途中 */
+int32_t    tk_freq_err_ppb(void);            /* タイマクロックの周波数誤差[ppb]（+ = 速い） */
+
+/* ===== デバッグ指標 ===== */
+extern volatile uint32_t tk_pps_count;       /* 受理した PPS */
+extern volatile uint32_t tk_pps_reject;      /* 周期外れで捨てた PPS */
+extern volatile uint32_t tk_relabel;         /* NMEA と食い違って秒を付け直した回数 */
+
+#ifdef __cplusplus
+}
+#endif
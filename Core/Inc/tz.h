@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 時差と夏時間（位置から引く） =====
+   地域は国境を矩形で近似した表（TZ_BOXES、先頭から照合）で引き、規則は POSIX TZ 形式
+   （標準時差・夏時間の時差・始まりと終わりの「m月第n週のw曜日 現地h時」）で持つ。
+   表は Host/tools/tzgen.py が tzdata から生成した tz_table.c（数 KB、flash 上の const）。
+   矩形の照合は位置が TZ_MOVE_CDEG 以上動いたときだけ行い、夏時間の切替時刻は
+   年ごとに1度だけ計算して持つので、測位のたびに呼んでも軽い。
+   どの矩形にも入らない海上は経度15度ごとの航海時（夏時間なし）。
+   位置が一度も来ていなければ UTC（時差0）。
+   引いた結果は tz_ctx_t に持つ。tz_update() などは既定の1つ（tz_default()）を使い、
+   受信機ごとの解析器（gps_parser_t）はそれぞれ自分の tz_ctx_t を持てる */
+
+#ifndef TZ_MOVE_CDEG
+#define TZ_MOVE_CDEG  5         /* 引き直す移動量（緯度差＋経度差）[0.01度]（緯度方向で約5.5km） */
+#endif
+#ifndef TZ_WITH_NAMES
+#define TZ_WITH_NAMES 1         /* 規則ごとの代表の区域名（tz_name()）を持つ */
+#endif
+
+#define TZ_NONE  0xFFU          /* 規則番号：該当なし（航海時・位置未取得） */
+
+typedef struct {
+    uint8_t  mon, week, wday;   /* 月(0=夏時間なし), 第n週(5=最終), 曜日(0=日) */
+    int16_t  min;               /* 現地時刻 [分]（負や 24時以降もある） */
+} tz_when_t;
+
+typedef struct {
+    int16_t   std_min, dst_min; /* UTC からの時差 [分、東+] */
+    tz_when_t start, end;       /* start は標準時、end は夏時間の現地時刻で数える */
+} tz_rule_t;
+
+typedef struct {
+    int16_t  lat0, lat1, lon0, lon1;   /* [0.01度]、南端 北端 西端 東端（境界を含む） */
+    uint8_t  rule;
+} tz_box_t;
+
+extern const tz_rule_t TZ_RULES[];
+extern const tz_box_t  TZ_BOXES[];
+extern const uint8_t   TZ_N_RULES;
+extern const uint16_t  TZ_N_BOXES;
+#if TZ_WITH_NAMES
+extern const char *const TZ_NAMES[];
+#endif
+
+typedef struct {
+    uint8_t  have;              /* 位置を一度でも引いたか */
+    uint8_t  rule;              /* 今の規則番号（TZ_NONE=航海時） */
+    int16_t  naut;              /* 航海時 [分]（rule==TZ_NONE のとき） */
+    int32_t  lat, lon;          /* 最後に表を引いた位置 [0.01度] */
+    uint8_t  c_rule;            /* 夏時間の切替時刻（規則と年が変わったときだけ計算し直す） */
+    int32_t  c_year;
+    int64_t  c_start, c_end;    /* UTC エポック秒 */
+} tz_ctx_t;
+
+void      tz_ctx_init(tz_ctx_t *z);
+void      tz_ctx_update(tz_ctx_t *z, int32_t lat_cdeg, int32_t lon_cdeg);
+int16_t   tz_ctx_offset(tz_ctx_t *z, int64_t utc_s);
+int16_t   tz_ctx_std_offset(const tz_ctx_t *z);
+tz_ctx_t *tz_default(void);                     /* 下の関数が使う実体 */
+
+/* 位置から（本体ループ、測位のたび） */
+void        tz_update(int32_t lat_cdeg, int32_t lon_cdeg);
+int16_t     tz_offset(int64_t utc_s);           /* その時刻の時差 [分]（夏時間込み） */
+int16_t     tz_std_offset(void);                /* 標準時差 [分]（日付が無いとき用） */
+uint8_t     tz_rule(void);                      /* 今の規則番号（TZ_NONE=航海時） */
+const char *tz_name(void);                      /* 代表の区域名（航海時は "" ） */
+
+/* 表を直接引く（状態を持たない。試験用） */
+uint8_t     tz_lookup(int32_t lat_cdeg, int32_t lon_cdeg);
+int16_t     tz_rule_offset(uint8_t rule, int64_t utc_s);
+int64_t     tz_when_utc(const tz_when_t *w, int year, int16_t off_min);   /* 切替の UTC エポック秒 */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,147 @@
+#include "anim.h"
+#include "nixie.h"
+#include <stdlib.h>
+
+/* ==== 組込み演出（フラッシュ） ======================================= */
+/* 従来の shuffle_effect 相当：1000/div ms で div=3→20（約2.1s）、20→10（約0.7s） */
+static const anim_seg_t SEG_SHUFFLE[] = {
+    { ANIM_SHUFFLE, EASE_OUT, 2100U, 333U,  50U,   0U },
+    { ANIM_SHUFFLE, EASE_IN,   720U,  50U, 100U,   0U },
+};
+static const anim_seg_t SEG_SLOT[] = {
+    { ANIM_ROLL,    EASE_IN,  2600U,  40U, 140U, 250U },
+};
+static const anim_seg_t SEG_CASCADE[] = {
+    { ANIM_CASCADE, EASE_LINEAR, 1500U, 40U, 40U, 120U },
+};
+static const anim_seg_t SEG_DISSOLVE[] = {
+    { ANIM_SHUFFLE, EASE_LINEAR,  600U,  60U,  60U,   0U },
+    { ANIM_XFADE,   EASE_INOUT,   900U,  20U,  20U,   0U },
+};
+
+#define FX(tbl) { tbl, (uint8_t)(sizeof(tbl) / sizeof(tbl[0])) }
+const anim_t ANIM_FX_SHUFFLE  = FX(SEG_SHUFFLE);
+const anim_t ANIM_FX_SLOT     = FX(SEG_SLOT);
+const anim_t ANIM_FX_CASCADE  = FX(SEG_CASCADE);
+const anim_t ANIM_FX_DISSOLVE = FX(SEG_DISSOLVE);
+
+/* ==== 状態 =========================================================== */
+static const anim_t *s_fx = NULL;
+static uint8_t   s_seg;
+static uint32_t  s_t0;         /* 区間開始 tick */
+static uint32_t  s_next;       /* 次のコマ tick */
+static uint16_t  s_from[8];    /* 区間開始時の表示 */
+static uint16_t  s_to[8];      /* 目標 */
+static uint16_t  s_out[8];     /* 直近に描いたコマ */
+static uint8_t   s_roll[8];    /* ROLL の各桁の数字 */
+
+/* ==== 内部 =========================================================== */
+/* 進み p（Q8、0..256）→ イージング後（Q8） */
+static uint32_t ease_q8(uint8_t e, uint32_t p)
+{
+    switch(e){
+    case EASE_IN:    return (p * p) >> 8;
+    case EASE_OUT:   return 256U - (((256U - p) * (256U - p)) >> 8);
+    case EASE_INOUT: return (p * p * (768U - 2U * p)) >> 16;   /* 3p^2 - 2p^3 */
+    default:         return p;
+    }
+}
+
+static inline uint16_t rand_code(void){ return nixie_code((uint8_t)(rand() % 10U), 0, 0); }
+
+static void seg_begin(void)
+{
+    for(uint8_t i=0;i<8;i++){ s_from[i] = s_out[i]; s_roll[i] = (uint8_t)(rand() % 10U); }
+}
+
+/* 区間の終わり：XFADE は目標を本表示にしてから解除 */
+static void seg_end(const anim_seg_t *g)
+{
+    if(g->kind == ANIM_XFADE){
+        nixie_show_codes(s_to);
+        nixie_xfade(NULL, 0);
+        for(uint8_t i=0;i<8;i++) s_out[i] = s_to[i];
+    }
+}
+
+static void render(const anim_seg_t *g, uint32_t t, uint32_t e)
+{
+    uint32_t hold = (g->dur_ms > 7U * g->lag_ms) ? g->dur_ms - 7U * g->lag_ms : 0U;
+
+    switch(g->kind){
+    case ANIM_SHUFFLE:
+        for(uint8_t i=0;i<8;i++) s_out[i] = rand_code();
+        break;
+    case ANIM_ROLL:
+        for(uint8_t i=0;i<8;i++){
+            if(t >= hold + (uint32_t)i * g->lag_ms){ s_out[i] = s_to[i]; continue; }
+            if(++s_roll[i] >= 10U) s_roll[i] = 0;
+            s_out[i] = nixie_code(s_roll[i], 0, 0);
+        }
+        break;
+    case ANIM_CASCADE:
+        for(uint8_t i=0;i<8;i++){
+            uint32_t on = (uint32_t)i * g->lag_ms;
+            s_out[i] = (t < on) ? s_from[i] : (t < on + hold) ? rand_code() : s_to[i];
+        }
+        break;
+    case ANIM_XFADE:
+        nixie_xfade(s_to, (uint8_t)((e * NIXIE_PWM_STEPS) >> 8));
+        return;
+    default:
+        return;
+    }
+    nixie_show_codes(s_out);
+}
+
+/* ==== API ============================================================ */
+void anim_start(const anim_t *fx, const uint16_t target[8])
+{
+    if(!fx || fx->nseg == 0U) return;
+    nixie_get_codes(s_out);
+    for(uint8_t i=0;i<8;i++) s_to[i] = target ? target[i] : s_out[i];
+    s_fx   = fx;
+    s_seg  = 0;
+    s_t0   = HAL_GetTick();
+    s_next = s_t0;
+    seg_begin();
+}
+
+void anim_set_target(const uint16_t target[8])
+{
+    if(!s_fx || !target) return;
+    for(uint8_t i=0;i<8;i++) s_to[i] = target[i];
+}
+
+uint8_t anim_busy(void){ return s_fx ? 1U : 0U; }
+
+uint8_t anim_poll(void)
+{
+    if(!s_fx) return ANIM_IDLE;
+
+    uint32_t now = HAL_GetTick();
+    const anim_seg_t *g = &s_fx->seg[s_seg];
+
+    /* 区間の切替（ループが遅れて複数区間を跨いでも tick 基準で追いつく） */
+    while((now - s_t0) >= g->dur_ms){
+        seg_end(g);
+        s_t0 += g->dur_ms;
+        if(++s_seg >= s_fx->nseg){
+            nixie_show_codes(s_to);
+            s_fx = NULL;
+            return ANIM_END;
+        }
+        g = &s_fx->seg[s_seg];
+        s_next = now;
+        seg_begin();
+    }
+    if((int32_t)(now - s_next) < 0) return ANIM_RUN;
+
+    uint32_t t = now - s_t0;
+    uint32_t e = ease_q8(g->ease, (t * 256U) / g->dur_ms);
+    int32_t  d = (int32_t)g->per1_ms - (int32_t)g->per0_ms;
+    s_next = now + (uint32_t)((int32_t)g->per0_ms + (d * (int32_t)e) / 256);
+
+    render(g, t, e);
+    return ANIM_FRAME;
+}
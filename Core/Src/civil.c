@@ -0,0 +1,75 @@
+#include "civil.h"
+
+/* 年は3月始まりに読み替える（閏日が年末に来るので、月の日数は 153日/5か月 の式で済む）。
+   era = 400年周期、doe = 周期内の通日 0..146096、yoe = 周期内の年 0..399 */
+#define DAYS_0000_03_01_TO_1970  719468
+#define DAYS_PER_ERA             146097
+
+static int32_t floor_div(int32_t a, int32_t b){ return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+
+int32_t civil_to_days(int y, int m, int d)
+{
+    y -= (m <= 2);
+    int32_t  era = floor_div(y, 400);
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153U * (uint32_t)(m > 2 ? m - 3 : m + 9) + 2U) / 5U + (uint32_t)d - 1U;
+    uint32_t doe = yoe * 365U + yoe / 4U - yoe / 100U + doy;
+    return era * DAYS_PER_ERA + (int32_t)doe - DAYS_0000_03_01_TO_1970;
+}
+
+void civil_from_days(int32_t days, civil_t *out)
+{
+    int32_t  z   = days + DAYS_0000_03_01_TO_1970;
+    int32_t  era = floor_div(z, DAYS_PER_ERA);
+    uint32_t doe = (uint32_t)(z - era * DAYS_PER_ERA);
+    uint32_t yoe = (doe - doe / 1460U + doe / 36524U - doe / 146096U) / 365U;
+    uint32_t doy = doe - (365U * yoe + yoe / 4U - yoe / 100U);
+    uint32_t mp  = (5U * doy + 2U) / 153U;
+    int      m   = (int)(mp < 10U ? mp + 3U : mp - 9U);
+
+    out->days = days;
+    out->YYYY = (int16_t)((int32_t)yoe + era * 400 + (m <= 2));
+    out->MM   = (int8_t)m;
+    out->DD   = (int8_t)(doy - (153U * mp + 2U) / 5U + 1U);
+    out->wday = civil_wday(days);
+}
+
+uint8_t civil_wday(int32_t days){ return (uint8_t)(days + 4 - floor_div(days + 4, 7) * 7); }   /* 1970-01-01 は木曜 */
+
+int64_t civil_epoch(int y, int m, int d, int hh, int mm, int ss)
+{
+    return (int64_t)civil_to_days(y, m, d) * 86400 + hh * 3600 + mm * 60 + ss;
+}
+
+void utc_to_local(int64_t epoch_s, int16_t offset_min, civil_t *out)
+{
+    int64_t t    = epoch_s + (int64_t)offset_min * 60;
+    int32_t days = (int32_t)(t / 86400);
+    int32_t sod  = (int32_t)(t - (int64_t)days * 86400);
+    if(sod < 0){ sod += 86400; days--; }
+
+    civil_from_days(days, out);
+    out->hh = (int8_t)(sod / 3600);
+    out->mm = (int8_t)((sod / 60) % 60);
+    out->ss = (int8_t)(sod % 60);
+}
+
+uint8_t civil_is_leap(int y){ return (uint8_t)((y % 4 == 0) && (y % 100 != 0 || y % 400 == 0)); }
+
+uint8_t civil_dim(int y, int m)
+{
+    if(m == 2) return (uint8_t)(28U + civil_is_leap(y));
+    return (uint8_t)(30 + ((m + (m >> 3)) & 1));      /* 1,3,5,7,8,10,12 が 31 */
+}
+
+uint16_t civil_yday(const civil_t *c){ return (uint16_t)(c->days - civil_to_days(c->YYYY, 1, 1)); }
+
+/* その週の木曜が属する年の、何番目の木曜か */
+uint8_t civil_iso_week(const civil_t *c, int16_t *iso_year)
+{
+    int32_t th = c->days - (int32_t)((c->wday + 6U) % 7U) + 3;
+    civil_t t;
+    civil_from_days(th, &t);
+    if(iso_year) *iso_year = t.YYYY;
+    return (uint8_t)((th - civil_to_days(t.YYYY, 1, 1)) / 7 + 1);
+}
@@ -0,0 +1,11 @@
+#include "crc.h"
+
+uint16_t crc16_ccitt(const uint8_t *p, uint16_t n)
+{
+    uint16_t c = 0xFFFFU;
+    while(n--){
+        c ^= (uint16_t)(*p++ << 8);
+        for(uint8_t b=0;b<8;b++) c = (c & 0x8000U) ? (uint16_t)((c << 1) ^ 0x1021U) : (uint16_t)(c << 1);
+    }
+    return c;
+}
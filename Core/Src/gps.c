@@ -1,93 +1,326 @@
 #include "gps.h"
-#include <string.h>
-#include <stdlib.h>
+#include "prof.h"
+#include "idle.h"
+#include "civil.h"
+#include "tz.h"
 #include <ctype.h>
-#include <math.h>
-
-/* ==== グローバル定義 ================================================== */
-/* UTC 時刻 */
-volatile int g_UTC_hh = -1, g_UTC_mm = -1, g_UTC_ss = -1;
-/* UTC 日付（RMCのddmmyy→2000+yy） */
-volatile int g_UTC_YYYY = -1, g_UTC_MM = -1, g_UTC_DD = -1;
-
-/* 現地時間（分・秒はUTC、時は経度で補正） */
-volatile int g_LCL_hh = -1, g_LCL_mm = -1, g_LCL_ss = -1;
-/* 現地日付（UTC日付＋時差で繰上げ/繰下げ） */
-volatile int g_LCL_YYYY = -1, g_LCL_MM = -1, g_LCL_DD = -1;
-
-/* 位置・高度・速度（float 32bit） */
-volatile float g_LTT = NAN;   /* 緯度 */
-volatile float g_LGT = NAN;   /* 経度 */
-volatile float g_ALT = NAN;   /* 高度[m] */
-volatile float g_SPD = NAN;   /* 速度[m/s] */
-
-/* デバッグ指標 */
-volatile uint32_t gps_rx_bytes = 0;
-volatile uint32_t gps_rx_lines = 0;
-volatile uint32_t gps_rmc_ok   = 0, gps_rmc_bad = 0;
-volatile uint32_t gps_gga_ok   = 0, gps_gga_bad = 0;
-
-volatile char     gps_last_sentence[GPS_LAST_SENTENCE_MAX] = {0};
-
-/* ==== 受信リング（2の冪サイズ） ===================================== */
-#ifndef GPS_RX_BUF_SZ
-#define GPS_RX_BUF_SZ 256
-#endif
-#if (GPS_RX_BUF_SZ & (GPS_RX_BUF_SZ-1)) != 0
-#error "GPS_RX_BUF_SZ は 2の冪(256/512/1024等)にしてください"
+#include <string.h>
+
+/* ==== 測位結果 ======================================================== */
+/* ハンドラは p->wk を更新し、解析1回の末尾で p->fix[] の空き側へ
+   まとめて公開する（二重バッファ＋世代番号）。読み手は gps_parser_snapshot() */
+#define GPS_FIX_INIT { .lat = { 0, GPS_FX_INVALID }, .lon = { 0, GPS_FX_INVALID },          \
+    .alt_mm = GPS_FX_INVALID, .spd_mms = GPS_FX_INVALID, .cog_cdeg = GPS_FX_INVALID,      \
+    .utc_YYYY = -1, .utc_MM = -1, .utc_DD = -1, .utc_hh = -1, .utc_mm = -1, .utc_ss = -1, \
+    .lcl_YYYY = -1, .lcl_MM = -1, .lcl_DD = -1, .lcl_hh = -1, .lcl_mm = -1, .lcl_ss = -1, \
+    .fix_type = -1, .sat_used = -1, .sat_view = -1, .pdop_c = -1, .hdop_c = -1, .vdop_c = -1 }
+
+gps_parser_t gps_default;
+
+/* UART → 解析器（HAL コールバックの振り分け）。静的に持つのはこの表だけ */
+static gps_parser_t *s_att[GPS_MAX_UARTS];
+
+/* ==== 受信リング ===================================================== */
+/* リングあふれ時の方針（1バイト割込み受信時。DMA は常に古い側を捨てる）
+   GPS_RX_DROP_NEWEST: 入ってきたバイトを捨てる。欠落位置に '\0' を置き、解析は次の '$' から
+   GPS_RX_DROP_OLDEST: 最古のバイトを上書き。読み手は残った中の次の '$' から再開 */
+#define GPS_RX_DROP_NEWEST 0
+#define GPS_RX_DROP_OLDEST 1
+#ifndef GPS_RX_OVF_POLICY
+#define GPS_RX_OVF_POLICY GPS_RX_DROP_OLDEST
 #endif
+/* 読み飛ばし要求：書き手（割込み）が rx_skip を立て、読み手が r = skip_to として解析を再同期する。
+   あふれ（古い側を捨てる）と DMA 再起動で使う。立っている間の実効読み位置は skip_to。
+   rx_gap は新しい側を捨てた直後（次の書込み前に '\0'）、ovf_on はあふれ継続中
+  （読み手が欠落を受け取るまで1回と数える） */
+
+/* ==== NMEA 逐次トークナイザ状態 ===================================== */
+/* 受信バイトごとに XOR・フィールド境界・文種別を確定させる（1パス）。
+   ',' と '*' は line[] 内で '\0' に置換し、各フィールドは fo[] で参照。
+   fo[0]=0 は "$GPRMC"、L=line 使用長、nf=フィールド数（'*'以降は数えない）、star='*' の位置、
+   ck/ck_rx=計算XOR/受信値、route=ディスパッチ表の添字、seq=完了文の通し番号（連続判定用）、
+   id=GPS_NMEA_ID（話者2字＋文種別3字） */
+enum { NM_IDLE = 0, NM_BODY, NM_CK1, NM_CK2, NM_END, NM_BAD };
+
+/* ==== 文ディスパッチ表 ============================================== */
+/* 文種別3字（GPS_NMEA_ID3）を乗算ハッシュで16スロットへ。衝突は線形探索。
+   組込み7種（RMC/GGA/ZDA/VTG/GSA/GSV/GLL）は 0x9E3779B1 で衝突なし＝1回で確定 */
+#define GPS_ROUTE_NONE  0xFFU
+#define GPS_ST_NONE     0xFFU
 
-static UART_HandleTypeDef *s_hu = NULL;
-static volatile uint8_t  s_rx_byte;
-static volatile uint8_t  s_ring[GPS_RX_BUF_SZ];
-static volatile uint16_t s_w = 0, s_r = 0;
+static inline uint8_t route_hash(uint16_t id){ return (uint8_t)(((uint32_t)id * 0x9E3779B1U) >> 28); }
 
 /* ==== 内部プロトタイプ =============================================== */
-static void   rx_restart(void);
-static inline int  ring_avail(void){ return (int)((uint16_t)(s_w - s_r)); }
-static inline int  ring_get(void){ if(s_r==s_w) return -1; uint8_t b=s_ring[s_r++&(GPS_RX_BUF_SZ-1)]; return (int)b; }
-static int    nmea_ck_ok(const char *p, size_t n);
+static void   rx_restart(gps_parser_t *p);
+#if GPS_RX_USE_DMA
+static void   rx_dma_sync(gps_parser_t *p);
+#endif
+#define RING_GAP  (-2)                     /* ring_get: 欠落あり（解析を再同期） */
+static inline uint16_t ring_rpos(const gps_parser_t *p){ return p->rx_skip ? p->skip_to : p->r; }
+static inline int  ring_avail(const gps_parser_t *p){ return (int)((uint16_t)(p->w - ring_rpos(p))); }
+static int         ring_get(gps_parser_t *p);
+static void        rx_overflow(gps_parser_t *p, uint16_t n);
+static gps_parser_t *att_find(const UART_HandleTypeDef *huart);
 static int    hexval(char c);
-static float  dm_to_deg(const char *s);
-static int    wrap24(int h){ int x=h%24; if(x<0)x+=24; return x; }
-static int    tz_from_longitude(float lon_deg);
-static int    is_leap(int y);
-static int    dim(int y,int m);
-static void   inc_day(int *y,int *m,int *d);
-static void   dec_day(int *y,int *m,int *d);
-
-/* ==== API ============================================================ */
+static int    nmea_feed(gps_parser_t *p, char ch);
+static uint8_t nmea_classify(gps_parser_t *p);
+static inline const char *nm_fld(const gps_parser_t *p, uint8_t i){ return (i < p->nm.nf) ? &p->nm.line[p->nm.fo[i]] : ""; }
+static uint8_t nm_byte(gps_parser_t *p, char ch);
+static void   nm_copy_last(gps_parser_t *p);
+static gps_route_t *route_add(gps_parser_t *p, uint16_t id, uint8_t upd, gps_parser_handler_t fn, uint8_t st);
+static int    route_set(gps_parser_t *p, const char *id3, gps_parser_handler_t fn, gps_nmea_handler_t legacy);
+static int    nmea_on_legacy(gps_parser_t *p);
+static int    nmea_on_rmc(gps_parser_t *p);
+static int    nmea_on_gga(gps_parser_t *p);
+static int    nmea_on_zda(gps_parser_t *p);
+static int    nmea_on_vtg(gps_parser_t *p);
+static int    nmea_on_gsa(gps_parser_t *p);
+static int    nmea_on_gsv(gps_parser_t *p);
+static int    nmea_on_gll(gps_parser_t *p);
+static int    hms_parse(gps_parser_t *p, const char *t);
+static void   derive_local(gps_parser_t *p);
+static void   fix_publish(gps_parser_t *p, uint8_t upd);
+static int    fx_parse(const char *s, uint8_t frac, int32_t *out);
+static int    dm_parse(const char *s, char hemi_neg, char hemi, uint16_t deg_max, gps_dm_t *out);
+
+/* ==== 解析器 API ===================================================== */
+void gps_parser_init(gps_parser_t *p)
+{
+    for(uint8_t i=0;i<GPS_MAX_UARTS;i++){ if(s_att[i] == p) s_att[i] = NULL; }   /* 付いていれば外す */
+    memset(p, 0, sizeof *p);
+    p->nm.st = NM_IDLE;
+    p->wk = (gps_fix_t)GPS_FIX_INIT;
+    p->fix[0] = p->fix[1] = p->wk;
+    p->gsa_seq = 0xFFU;
+    for(uint8_t i=0;i<4;i++) p->gsv_view[i] = 0xFFU;   /* GP/GL/GA/GB(BD)、0xFF=未取得 */
+    tz_ctx_init(&p->tz_own);
+    p->tz = &p->tz_own;
+
+    route_add(p, GPS_NMEA_ID3('R','M','C'), GPS_UPD_RMC, nmea_on_rmc, GPS_ST_RMC);
+    route_add(p, GPS_NMEA_ID3('G','G','A'), GPS_UPD_GGA, nmea_on_gga, GPS_ST_GGA);
+    route_add(p, GPS_NMEA_ID3('Z','D','A'), GPS_UPD_ZDA, nmea_on_zda, GPS_ST_ZDA);
+    route_add(p, GPS_NMEA_ID3('V','T','G'), GPS_UPD_VTG, nmea_on_vtg, GPS_ST_VTG);
+    route_add(p, GPS_NMEA_ID3('G','S','A'), GPS_UPD_GSA, nmea_on_gsa, GPS_ST_GSA);
+    route_add(p, GPS_NMEA_ID3('G','S','V'), GPS_UPD_GSV, nmea_on_gsv, GPS_ST_GSV);
+    route_add(p, GPS_NMEA_ID3('G','L','L'), GPS_UPD_GLL, nmea_on_gll, GPS_ST_GLL);
+}
+
+/* 同じ UART に付け直すと前の解析器は外れる。別の UART へ付け替えてもよい */
+uint8_t gps_parser_attach(gps_parser_t *p, UART_HandleTypeDef *huart)
+{
+    uint8_t k = GPS_MAX_UARTS;
+    for(uint8_t i=0;i<GPS_MAX_UARTS;i++){
+        if(s_att[i] == p) s_att[i] = NULL;
+    }
+    for(uint8_t i=0;i<GPS_MAX_UARTS;i++){
+        if(s_att[i] && s_att[i]->hu == huart){ k = i; break; }
+        if(!s_att[i] && k == GPS_MAX_UARTS) k = i;
+    }
+    if(k == GPS_MAX_UARTS) return 0;
+    p->hu = huart;
+    p->w = p->r = 0;
+    p->rx_skip = 0; p->rx_gap = 0; p->ovf_on = 0;
+    p->dma_on = 0;
+    s_att[k] = p;
+    rx_restart(p);
+    return 1;
+}
+
+void gps_parser_on_fix(gps_parser_t *p, gps_fix_cb_t cb, void *ctx)
+{
+    p->on_fix = cb;
+    p->on_fix_ctx = ctx;
+}
+
+int gps_parser_set_handler(gps_parser_t *p, const char *id3, gps_parser_handler_t fn)
+{
+    return route_set(p, id3, fn, NULL);
+}
+
+/* 最新の公開測位を *out へ複写。返値: 世代（0=未公開）。
+   コピー中に公開が割り込んだ場合のみやり直す（公開は本体ループのみ、
+   割込みからの読出しは公開処理を追い越さないので1回で終わる） */
+uint32_t gps_parser_snapshot(const gps_parser_t *p, gps_fix_t *out)
+{
+    uint32_t g;
+    do{
+        g = p->fix_gen;
+        __DMB();
+        *out = p->fix[g & 1U];
+        __DMB();
+    }while(g != p->fix_gen);
+    return g;
+}
+
+/* 受信済み・未解析のバイト数（あふれ処理後なので GPS_RX_BUF_SZ 以下） */
+uint16_t gps_parser_pending(const gps_parser_t *p){ return (uint16_t)ring_avail(p); }
+
+/* ハンドラ内から現在の文を参照（ハンドラ呼出し中のみ有効） */
+uint32_t    gps_parser_id(const gps_parser_t *p){ return p->nm.id; }
+uint8_t     gps_parser_nfields(const gps_parser_t *p){ return p->nm.nf; }
+const char *gps_parser_field(const gps_parser_t *p, uint8_t i){ return nm_fld(p, i); }
+
+/* 数値欄の解析を直接呼ぶ（状態を持たない。試験用） */
+int gps_fx_parse(const char *s, uint8_t frac, int32_t *out){ return fx_parse(s, frac, out); }
+int gps_dm_parse(const char *s, char hemi_neg, char hemi, uint16_t deg_max, gps_dm_t *out)
+{
+    return dm_parse(s, hemi_neg, hemi, deg_max, out);
+}
+
+/* ==== 既定の解析器（従来の API） ===================================== */
+/* 時差は tz_default() を共有し、tz_update()/tz_name() などから見えるようにする */
 void gps_init(UART_HandleTypeDef *huart)
 {
-    s_hu = huart;
-    s_w = s_r = 0;
-    gps_rx_bytes = gps_rx_lines = gps_rmc_ok = gps_rmc_bad = 0;
-    gps_gga_ok = gps_gga_bad = 0;
-    gps_last_sentence[0] = '\0';
-    rx_restart();
+    gps_parser_init(&gps_default);
+    gps_default.tz = tz_default();
+    (void)gps_parser_attach(&gps_default, huart);
+}
+
+uint8_t  gps_poll_line(void){ return gps_parser_poll(&gps_default); }
+uint32_t gps_get_snapshot(gps_fix_t *out){ return gps_parser_snapshot(&gps_default, out); }
+
+/* 文種別ハンドラの追加・置換（gps_init() の後で呼ぶ）。fn=NULL で削除 */
+int gps_set_handler(const char *id3, gps_nmea_handler_t fn)
+{
+    return route_set(&gps_default, id3, fn ? nmea_on_legacy : NULL, fn);
 }
 
-/* HALコールバック（多重定義に注意） */
+uint32_t    gps_nmea_id(void){ return gps_default.nm.id; }
+uint8_t     gps_nmea_nfields(void){ return gps_default.nm.nf; }
+const char *gps_nmea_field(uint8_t i){ return nm_fld(&gps_default, i); }
+
+uint16_t gps_rx_pending(void){ return gps_parser_pending(&gps_default); }
+uint16_t gps_rx_capacity(void){ return GPS_RX_BUF_SZ; }
+
+/* HALコールバック（多重定義に注意）。UART から解析器を引いて振り分ける */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if(huart == s_hu){
-        s_ring[s_w++ & (GPS_RX_BUF_SZ-1)] = s_rx_byte;
-        gps_rx_bytes++;
-        rx_restart();
+    gps_parser_t *p = att_find(huart);
+    if(p){
+        p->st.rx_bytes++;
+        uint16_t used = (uint16_t)(p->w - ring_rpos(p));
+#if GPS_RX_OVF_POLICY == GPS_RX_DROP_NEWEST
+        if(used + (p->rx_gap ? 2U : 1U) > GPS_RX_BUF_SZ){ rx_overflow(p, 1); p->rx_gap = 1; rx_restart(p); return; }
+        if(p->rx_gap){ p->ring[p->w++ & (GPS_RX_BUF_SZ-1)] = 0; p->rx_gap = 0; used++; }
+#else
+        if(used >= GPS_RX_BUF_SZ){
+            rx_overflow(p, 1);
+            p->skip_to = (uint16_t)(p->w - GPS_RX_BUF_SZ + 1U);   /* 上書きされる最古の1バイトを捨てる */
+            p->rx_skip = 1;
+            used--;
+        }
+#endif
+        p->ring[p->w++ & (GPS_RX_BUF_SZ-1)] = p->rx_byte;
+        if(++used > p->st.rx_hwm) p->st.rx_hwm = used;
+        if(p->rx_byte == '\n') idle_event();     /* 行が揃ったときだけ本体を起こす */
+        rx_restart(p);
     }
 }
+#if GPS_RX_USE_DMA
+/* DMA半分/満了/IDLE で呼ばれる。Size は使わずNDTRから位置を読む */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    (void)Size;
+    gps_parser_t *p = att_find(huart);
+    if(p && p->dma_on){ rx_dma_sync(p); idle_event(); }
+}
+#endif
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-    if(huart == s_hu){ rx_restart(); }
+    gps_parser_t *p = att_find(huart);
+    if(p){ rx_restart(p); }
 }
 
 /* ==== 内部実装 ======================================================= */
-static void rx_restart(void)
+static gps_parser_t *att_find(const UART_HandleTypeDef *huart)
+{
+    for(uint8_t i=0;i<GPS_MAX_UARTS;i++){
+        if(s_att[i] && s_att[i]->hu == huart) return s_att[i];
+    }
+    return NULL;
+}
+
+static void rx_restart(gps_parser_t *p)
+{
+#if GPS_RX_USE_DMA
+    if(p->hu->hdmarx != NULL){
+        /* HALはエラー時にDMAを止めるので、再起動時は先頭から書き直される。
+           w をバッファ境界へ進めて位置を合わせ、未読分は読み捨てる */
+        if(p->dma_on){
+            p->w = (uint16_t)((p->w + (GPS_RX_BUF_SZ-1)) & ~(uint16_t)(GPS_RX_BUF_SZ-1));
+            p->skip_to = p->w;
+            p->rx_skip = 1;
+        }
+        p->dma_pos = 0;
+        p->dma_on  = 1;
+        if(HAL_UARTEx_ReceiveToIdle_DMA(p->hu, (uint8_t*)p->ring, GPS_RX_BUF_SZ) == HAL_OK) return;
+        p->dma_on  = 0;
+    }
+#endif
+    (void)HAL_UART_Receive_IT(p->hu, (uint8_t*)&p->rx_byte, 1);
+}
+
+#if GPS_RX_USE_DMA
+/* DMA書込位置(NDTR)まで w を進める。ISRと本体の両方から呼ぶので割込み禁止で */
+static void rx_dma_sync(gps_parser_t *p)
 {
-    (void)HAL_UART_Receive_IT(s_hu, (uint8_t*)&s_rx_byte, 1);
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint16_t pos = (uint16_t)(GPS_RX_BUF_SZ - __HAL_DMA_GET_COUNTER(p->hu->hdmarx));
+    pos &= (GPS_RX_BUF_SZ-1);
+    uint16_t n = (uint16_t)((pos - p->dma_pos) & (GPS_RX_BUF_SZ-1));
+    p->dma_pos = pos;
+    p->w = (uint16_t)(p->w + n);
+    p->st.rx_bytes += n;
+
+    /* DMA は止まらないので、周回されたら新しい半分だけ残す（最古側は書込み中の恐れ） */
+    uint16_t used = (uint16_t)(p->w - ring_rpos(p));
+    if(used > GPS_RX_BUF_SZ){
+        uint16_t to = (uint16_t)(p->w - GPS_RX_BUF_SZ/2U);
+        rx_overflow(p, (uint16_t)(to - ring_rpos(p)));
+        p->skip_to = to;
+        p->rx_skip = 1;
+        used = GPS_RX_BUF_SZ/2U;
+    }
+    if(used > p->st.rx_hwm) p->st.rx_hwm = used;
+    __set_PRIMASK(pm);
+}
+#endif
+
+/* あふれの記録（書き手側＝割込み文脈）。読み手が追いつくまでのあふれは1回と数え、発生時刻を残す */
+static void rx_overflow(gps_parser_t *p, uint16_t n)
+{
+    p->st.rx_dropped += n;
+    if(p->ovf_on) return;
+    p->ovf_on = 1;
+    p->st.rx_ovf_tick[p->st.rx_overflows % GPS_RX_OVF_LOG] = HAL_GetTick();
+    p->st.rx_overflows++;
+}
+
+/* 1バイト取り出し。-1=空、RING_GAP=欠落（読み飛ばし要求か '\0' の印） */
+static int ring_get(gps_parser_t *p)
+{
+    for(;;){
+        if(p->rx_skip){
+            uint32_t pm = __get_PRIMASK();
+            __disable_irq();
+            p->r = p->skip_to;
+            p->rx_skip = 0;
+            p->ovf_on  = 0;
+            __set_PRIMASK(pm);
+            return RING_GAP;
+        }
+        if(p->r == p->w) return -1;
+        uint8_t b = p->ring[p->r & (GPS_RX_BUF_SZ-1)];
+        if(p->rx_skip) continue;                  /* 読む間に上書きされた */
+        p->r++;
+        if(b) return (int)b;
+        p->ovf_on = 0;
+        return RING_GAP;
+    }
 }
 
-/* '$' と '*' を除外して XOR、'*'後2桁HEXと一致でOK */
+/* 16進1桁 → 0..15、不正は -1 */
 static int hexval(char c)
 {
     if (c >= '0' && c <= '9') return c - '0';
@@ -95,198 +328,458 @@ static int hexval(char c)
     if (c >= 'A' && c <= 'F') return c - 'A' + 10;
     return -1;
 }
-static int nmea_ck_ok(const char *p, size_t n)
+
+/* 10進固定小数点： "[-]iii.fff" → 値×10^frac（frac桁を超える分は四捨五入）。
+   数字が1つも無い／桁あふれ／数字の後に余計な字があれば 0 を返す */
+static int fx_parse(const char *s, uint8_t frac, int32_t *out)
+{
+    uint8_t neg = 0, nd = 0;
+    uint32_t v = 0;
+    if(*s == '-'){ neg = 1; ++s; }
+    else if(*s == '+'){ ++s; }
+    for(; *s >= '0' && *s <= '9'; ++s, ++nd){
+        if(v > 214748364U) return 0;
+        v = v*10U + (uint32_t)(*s - '0');
+    }
+    uint8_t k = 0;
+    if(*s == '.'){
+        for(++s; *s >= '0' && *s <= '9'; ++s, ++nd){
+            if(k < frac){
+                if(v > 214748364U) return 0;
+                v = v*10U + (uint32_t)(*s - '0'); ++k;
+            }else if(k == frac){
+                if(*s >= '5') ++v;   /* 最初の切り捨て桁で丸め */
+                ++k;
+            }
+        }
+    }
+    if(nd == 0 || *s != '\0') return 0;
+    for(; k < frac; ++k){ if(v > 214748364U) return 0; v *= 10U; }
+    if(v > 2147483647U) return 0;
+    *out = neg ? -(int32_t)v : (int32_t)v;
+    return 1;
+}
+
+/* ddmm.mmmmmm / dddmm.mmmmmm → 度＋マイクロ分（hemi==hemi_neg で負）。
+   deg_max は緯度 90・経度 180。整数部はそれぞれ4桁・5桁まで、deg_max を超える値（9000.1 なども）は不正 */
+static int dm_parse(const char *s, char hemi_neg, char hemi, uint16_t deg_max, gps_dm_t *out)
+{
+    uint32_t ip = 0;
+    uint8_t  nd = 0;
+    const uint8_t nd_max = (deg_max > 99U) ? 5U : 4U;
+    for(; *s >= '0' && *s <= '9' && nd < nd_max; ++s, ++nd) ip = ip*10U + (uint32_t)(*s - '0');
+    if(nd < 3 || (*s != '.' && *s != '\0')) return 0;
+
+    int32_t fr = 0;   /* 分の小数部 ×1e6 */
+    if(*s == '.' && s[1] != '\0'){ if(!fx_parse(s, 6, &fr) || fr < 0) return 0; }
+    uint32_t mm = ip % 100U;
+    if(mm >= 60U || fr >= 1000000) return 0;   /* 59.9999995分の丸め上がりも不正扱い */
+    if(ip / 100U > deg_max || (ip / 100U == deg_max && (mm || fr))) return 0;
+
+    int16_t deg  = (int16_t)(ip / 100U);
+    int32_t umin = (int32_t)(mm * 1000000U) + fr;
+    if(hemi == hemi_neg){ deg = (int16_t)-deg; umin = -umin; }
+    out->deg = deg; out->umin = umin;
+    return 1;
+}
+
+/* 度＋マイクロ分 → 0.01度（0.6分 = 600000µ分）。返値: 0=未取得 */
+static int dm_cdeg(const gps_dm_t *dm, int32_t *out)
+{
+    if(dm->umin == GPS_FX_INVALID) return 0;
+    *out = (int32_t)dm->deg * 100 + dm->umin / 600000;
+    return 1;
+}
+
+/* ==== 逐次トークナイザ ============================================== */
+/* 1バイト投入。返値: 0=継続中, 1=チェックサムOKで1文完了, -1=不正文で完了 */
+static int nmea_feed(gps_parser_t *p, char ch)
+{
+    if(ch == '$'){                               /* どの状態からでも再同期 */
+        p->nm.line[0] = '$'; p->nm.L = 1;
+        p->nm.fo[0] = 0;     p->nm.nf = 1;
+        p->nm.ck = 0;        p->nm.route = GPS_ROUTE_NONE;
+        p->nm.st = NM_BODY;
+        return 0;
+    }
+    if(ch == '\r') return 0;
+    if(ch == '\n'){
+        uint8_t st = p->nm.st;
+        p->nm.st = NM_IDLE;
+        if(st == NM_IDLE) return 0;
+        return (st == NM_END && p->nm.ck == p->nm.ck_rx) ? 1 : -1;
+    }
+
+    switch(p->nm.st){
+    case NM_BODY:
+        if(p->nm.L >= GPS_LINE_MAX-4){ p->nm.st = NM_BAD; return 0; }   /* '*hh\0' 分を残す */
+        if(ch == '*'){
+            p->nm.star = p->nm.L;
+            p->nm.line[p->nm.L++] = '\0';
+            p->nm.st = NM_CK1;
+            return 0;
+        }
+        p->nm.ck ^= (uint8_t)ch;
+        if(ch == ','){
+            if(p->nm.nf == 1) p->nm.route = nmea_classify(p);
+            p->nm.line[p->nm.L++] = '\0';
+            if(p->nm.nf < GPS_MAX_FIELDS) p->nm.fo[p->nm.nf++] = p->nm.L;
+        }else{
+            p->nm.line[p->nm.L++] = ch;
+        }
+        return 0;
+    case NM_CK1:
+    case NM_CK2: {
+        int v = hexval(ch);
+        if(v < 0){ p->nm.st = NM_BAD; return 0; }
+        p->nm.line[p->nm.L++] = ch;
+        if(p->nm.st == NM_CK1){ p->nm.ck_rx = (uint8_t)(v << 4); p->nm.st = NM_CK2; }
+        else                 { p->nm.ck_rx |= (uint8_t)v;       p->nm.st = NM_END; p->nm.line[p->nm.L] = '\0'; }
+        return 0;
+    }
+    default:                                     /* NM_IDLE / NM_END / NM_BAD は行末まで読み流す */
+        return 0;
+    }
+}
+
+/* 先頭フィールド確定時（最初の ','）に "$GPRMC" 等を GPS_NMEA_ID へ詰めて表引き。
+   話者は GNSS 系（G?, BD）のみ受理 */
+static uint8_t nmea_classify(gps_parser_t *p)
+{
+    const char *c = p->nm.line;
+    if(p->nm.L != 6) return GPS_ROUTE_NONE;
+    for(uint8_t i=1;i<6;i++){ if(c[i] < 'A' || c[i] > 'Z') return GPS_ROUTE_NONE; }
+    if(c[1] != 'G' && !(c[1] == 'B' && c[2] == 'D')) return GPS_ROUTE_NONE;
+
+    p->nm.id = GPS_NMEA_ID(c[1], c[2], c[3], c[4], c[5]);
+    uint16_t id = (uint16_t)(p->nm.id & 0x7FFFU);
+    uint8_t  h  = route_hash(id);
+    for(uint8_t n=0;n<GPS_ROUTE_SLOTS;n++){
+        uint8_t k = (uint8_t)((h + n) & (GPS_ROUTE_SLOTS-1));
+        if(p->route[k].id == id) return p->route[k].fn ? k : GPS_ROUTE_NONE;
+        if(p->route[k].id == 0) break;
+    }
+    return GPS_ROUTE_NONE;
+}
+
+static gps_route_t *route_add(gps_parser_t *p, uint16_t id, uint8_t upd, gps_parser_handler_t fn, uint8_t st)
+{
+    uint8_t h = route_hash(id);
+    for(uint8_t n=0;n<GPS_ROUTE_SLOTS;n++){
+        gps_route_t *r = &p->route[(h + n) & (GPS_ROUTE_SLOTS-1)];
+        if(r->id != 0) continue;
+        r->upd = upd; r->fn = fn; r->legacy = NULL; r->st = st;
+        r->id  = id;
+        return r;
+    }
+    return NULL;
+}
+
+/* 文種別ハンドラの追加・置換。fn=NULL で削除。返値: 1=登録, 0=表が満杯/不正ID */
+static int route_set(gps_parser_t *p, const char *id3, gps_parser_handler_t fn, gps_nmea_handler_t legacy)
+{
+    if(!id3) return 0;
+    for(uint8_t i=0;i<3;i++){ if(id3[i] < 'A' || id3[i] > 'Z') return 0; }
+    uint16_t id = GPS_NMEA_ID3(id3[0], id3[1], id3[2]);
+
+    uint8_t h = route_hash(id);
+    for(uint8_t n=0;n<GPS_ROUTE_SLOTS;n++){
+        gps_route_t *r = &p->route[(h + n) & (GPS_ROUTE_SLOTS-1)];
+        if(r->id != id) continue;
+        r->fn = fn; r->legacy = legacy;   /* 削除時も探索鎖を切らないようスロットは残す */
+        return 1;
+    }
+    if(!fn) return 1;
+    gps_route_t *r = route_add(p, id, GPS_UPD_USER, fn, GPS_ST_NONE);
+    if(!r) return 0;
+    r->legacy = legacy;
+    return 1;
+}
+
+/* 旧形式のハンドラ（引数なし、gps_nmea_field() で参照）を呼ぶ */
+static int nmea_on_legacy(gps_parser_t *p)
+{
+    return p->route[p->nm.route].legacy();
+}
+
+/* デバッグ用に直近の受理文を復元コピー（'\0' を ',' / '*' へ戻す） */
+static void nm_copy_last(gps_parser_t *p)
 {
-    if (!p || n < 4) return 0;
-    size_t i = (p[0] == '$') ? 1 : 0;
-    uint8_t sum = 0; size_t k=i;
-    for(; k<n && p[k] && p[k] != '*'; ++k) sum ^= (uint8_t)p[k];
-    if (k>=n || p[k] != '*') return 0;
-    if (k+2 >= n) return 0;
-    int hi = hexval(p[k+1]), lo = hexval(p[k+2]);
-    if (hi<0 || lo<0) return 0;
-    return (sum == (uint8_t)((hi<<4)|lo));
+    uint8_t n = p->nm.L;
+    if(n >= GPS_LAST_SENTENCE_MAX) n = GPS_LAST_SENTENCE_MAX-1;
+    for(uint8_t i=0;i<n;i++){
+        char c = p->nm.line[i];
+        if(c == '\0') c = (i == p->nm.star) ? '*' : ',';
+        p->last[i] = c;
+    }
+    p->last[n] = '\0';
 }
 
-/* ddmm.mmmm / dddmm.mmmm → 度（float） */
-static float dm_to_deg(const char *s)
+static inline int is_d(char c){ return (c >= '0' && c <= '9'); }
+
+/* RMC: 0:$G?RMC,1:time,2:A/V,3:lat,4:N/S,5:lon,6:E/W,7:knots,8:cog,9:date(ddmmyy),... */
+static int nmea_on_rmc(gps_parser_t *p)
 {
-    if(!s || !*s) return NAN;
-    char *endp = NULL;
-    float v = strtof(s, &endp);
-    if (endp == s) return NAN;
-    int d = (int)(v / 100.0f);
-    float m = v - d * 100.0f;
-    return d + m / 60.0f;
+    if(p->nm.nf < 10) return 0;
+
+    const char *t   = nm_fld(p, 1); /* hhmmss.sss */
+    const char *lat = nm_fld(p, 3); const char *ns = nm_fld(p, 4);
+    const char *lon = nm_fld(p, 5); const char *ew = nm_fld(p, 6);
+    const char *spk = nm_fld(p, 7); /* knots */
+    const char *dmy = nm_fld(p, 9); /* ddmmyy */
+
+    /* UTC時刻。空（測位前・途絶中の受信機）なら前の時刻を残さない：残すと timekeep が
+       ホールドオーバ中の秒を毎秒その古い時刻へラベルし直し、表示が止まる。現地時刻も同じく消す */
+    if(!hms_parse(p, t)){
+        p->wk.utc_hh = p->wk.utc_mm = p->wk.utc_ss = -1;
+        p->wk.lcl_hh = p->wk.lcl_mm = p->wk.lcl_ss = -1;
+    }
+
+    /* UTC日付（2000+yy）。暦に無い日付は据え置く（ZDA と同じ検査） */
+    if(is_d(dmy[0]) && is_d(dmy[1]) && is_d(dmy[2]) &&
+       is_d(dmy[3]) && is_d(dmy[4]) && is_d(dmy[5]) && dmy[6] == '\0')
+    {
+        int d = (dmy[0]-'0')*10 + (dmy[1]-'0');
+        int m = (dmy[2]-'0')*10 + (dmy[3]-'0');
+        int y = 2000 + (dmy[4]-'0')*10 + (dmy[5]-'0');
+        if(m >= 1 && m <= 12 && d >= 1 && d <= civil_dim(y,m)){
+            p->wk.utc_YYYY = (int16_t)y; p->wk.utc_MM = (int8_t)m; p->wk.utc_DD = (int8_t)d;
+        }
+    }
+
+    /* 位置（固定小数点） */
+    (void)dm_parse(lat, 'S', *ns, 90U, &p->wk.lat);
+    (void)dm_parse(lon, 'W', *ew, 180U, &p->wk.lon);
+
+    /* 速度：ミリノット → mm/s（1kn = 1852/3600 m/s、四捨五入）。2000kn 上限で32bit内に収める */
+    int32_t mkn;
+    if(fx_parse(spk, 3, &mkn) && mkn >= 0 && mkn <= 2000000){
+        p->wk.spd_mms = (int32_t)(((uint32_t)mkn * 1852U + 1800U) / 3600U);
+    }
+
+    derive_local(p);
+    return 1;
 }
 
-/* 経度→時差(時間)。15度=1時間、中央7.5°で丸め（float版） */
-static int tz_from_longitude(float lon_deg)
+/* p->wk を読み手の見ていない側へ複写し、世代を進めて切替える */
+static void fix_publish(gps_parser_t *p, uint8_t upd)
 {
-    if (isnan(lon_deg)) return 0;
-    float tzf = floorf((lon_deg + 7.5f) / 15.0f);
-    if (tzf < -12.0f) tzf = -12.0f;
-    if (tzf >  14.0f) tzf =  14.0f;
-    return (int)tzf;
+    uint32_t g = p->fix_gen + 1U;
+    gps_fix_t *f = &p->fix[g & 1U];
+    p->wk.gen  = g;
+    p->wk.tick = HAL_GetTick();
+    p->wk.upd  = upd;
+    *f = p->wk;
+    __DMB();
+    p->fix_gen = g;
+    if(p->on_fix) p->on_fix(f, p->on_fix_ctx);
 }
 
-/* 日付ユーティリティ */
-static int is_leap(int y){ return ( (y%4==0 && y%100!=0) || (y%400==0) ); }
-static int dim(int y,int m){
-    static const int d[12]={31,28,31,30,31,30,31,31,30,31,30,31};
-    if(m==2) return d[m-1] + (is_leap(y)?1:0);
-    return d[m-1];
+/* 現地時間・現地日付（UTCとUTC日付が揃っていれば）。RMC/ZDA/GLL から呼ぶ */
+static void derive_local(gps_parser_t *p)
+{
+    if(p->wk.utc_hh>=0 && p->wk.utc_mm>=0 && p->wk.utc_ss>=0){
+        int32_t lat, lon;
+        if(dm_cdeg(&p->wk.lat, &lat) && dm_cdeg(&p->wk.lon, &lon)) tz_ctx_update(p->tz, lat, lon);   /* 動いたときだけ表を引く */
+
+        /* UTC日付が未取得なら時刻だけ（1970-01-01 として換算し、夏時間は見ない。現地日付は据え置き） */
+        uint8_t dated = (p->wk.utc_YYYY >= 0 && p->wk.utc_MM >= 1 && p->wk.utc_DD >= 1);
+        int64_t t = civil_epoch(dated ? p->wk.utc_YYYY : 1970, dated ? p->wk.utc_MM : 1, dated ? p->wk.utc_DD : 1,
+                                p->wk.utc_hh, p->wk.utc_mm, p->wk.utc_ss);
+        p->wk.tz_min = dated ? tz_ctx_offset(p->tz, t) : tz_ctx_std_offset(p->tz);
+        civil_t lc;
+        utc_to_local(t, p->wk.tz_min, &lc);
+        p->wk.lcl_hh = lc.hh; p->wk.lcl_mm = lc.mm; p->wk.lcl_ss = lc.ss;
+        if(dated){ p->wk.lcl_YYYY = lc.YYYY; p->wk.lcl_MM = lc.MM; p->wk.lcl_DD = lc.DD; }
+    }
 }
-static void inc_day(int *y,int *m,int *d){
-    if(*y<0||*m<1||*d<1) return;
-    (*d)++;
-    int md = dim(*y,*m);
-    if(*d>md){ *d=1; (*m)++; if(*m>12){ *m=1; (*y)++; } }
+
+/* hhmmss[.sss] → utc_hh/mm/ss。返値: 1=更新 */
+static int hms_parse(gps_parser_t *p, const char *t)
+{
+    for(uint8_t i=0;i<6;i++){ if(!is_d(t[i])) return 0; }
+    int hh = (t[0]-'0')*10 + (t[1]-'0');
+    int mm = (t[2]-'0')*10 + (t[3]-'0');
+    int ss = (t[4]-'0')*10 + (t[5]-'0');
+    if(hh > 23 || mm > 59 || ss > 60) return 0;
+    p->wk.utc_hh = (int8_t)hh; p->wk.utc_mm = (int8_t)mm; p->wk.utc_ss = (int8_t)ss;
+    return 1;
 }
-static void dec_day(int *y,int *m,int *d){
-    if(*y<0||*m<1||*d<1) return;
-    (*d)--;
-    if(*d<1){ (*m)--; if(*m<1){ *m=12; (*y)--; } *d = dim(*y,*m); }
+
+/* GGA: 9:alt(m) */
+static int nmea_on_gga(gps_parser_t *p)
+{
+    if(p->nm.nf < 11) return 0;
+    int32_t mm;
+    if(fx_parse(nm_fld(p, 9), 3, &mm)) p->wk.alt_mm = mm;
+    return 1;
 }
 
-/* ==== RMC/GNRMC と GGA を解析してグローバル更新 ===================== */
-uint8_t gps_poll_line(void)
+/* ZDA: 1:time,2:dd,3:mm,4:yyyy,5:zone hh,6:zone mm。4桁年の日付を正とする */
+static int nmea_on_zda(gps_parser_t *p)
 {
-    static char     line[GPS_RX_BUF_SZ];
-    static uint16_t L = 0;
+    if(p->nm.nf < 5) return 0;
+    const char *dd = nm_fld(p, 2), *mo = nm_fld(p, 3), *yy = nm_fld(p, 4);
+    if(!hms_parse(p, nm_fld(p, 1))) return 0;
+    if(is_d(dd[0]) && is_d(dd[1]) && dd[2] == '\0' &&
+       is_d(mo[0]) && is_d(mo[1]) && mo[2] == '\0' &&
+       is_d(yy[0]) && is_d(yy[1]) && is_d(yy[2]) && is_d(yy[3]) && yy[4] == '\0')
+    {
+        int d = (dd[0]-'0')*10 + (dd[1]-'0');
+        int m = (mo[0]-'0')*10 + (mo[1]-'0');
+        int y = (yy[0]-'0')*1000 + (yy[1]-'0')*100 + (yy[2]-'0')*10 + (yy[3]-'0');
+        if(m >= 1 && m <= 12 && d >= 1 && d <= civil_dim(y,m)){
+            p->wk.utc_YYYY = (int16_t)y; p->wk.utc_MM = (int8_t)m; p->wk.utc_DD = (int8_t)d;
+        }
+    }
+    derive_local(p);
+    return 1;
+}
+
+/* VTG: 1:cog(T),2:'T',3:cog(M),4:'M',5:knots,6:'N',7:km/h,8:'K' */
+static int nmea_on_vtg(gps_parser_t *p)
+{
+    if(p->nm.nf < 9) return 0;
+    int32_t v;
+    if(fx_parse(nm_fld(p, 1), 2, &v) && v >= 0 && v < 36000) p->wk.cog_cdeg = v;
+    /* km/h は m/h 単位で読み、÷3.6 → mm/s。2000kn 相当（3704km/h）上限 */
+    if(fx_parse(nm_fld(p, 7), 3, &v) && v >= 0 && v <= 3704000){
+        p->wk.spd_mms = (int32_t)(((uint32_t)v * 10U + 18U) / 36U);
+    }
+    return 1;
+}
+
+/* GSA: 1:A/M,2:fix(1..3),3..14:使用衛星,15:PDOP,16:HDOP,17:VDOP。
+   複数系の受信機は系ごとにGSAを連続で出すので、使用衛星数は連続分を合算し、
+   GSA 以外の文が来て連続が切れたところで sat_used へ確定する（nm_byte） */
+static int nmea_on_gsa(gps_parser_t *p)
+{
+    if(p->nm.nf < 18) return 0;
+    const char *f = nm_fld(p, 2);
+    if(f[0] < '1' || f[0] > '3' || f[1] != '\0') return 0;
+
+    int used = 0;
+    for(uint8_t i=3;i<=14;i++){ if(*nm_fld(p, i)) used++; }
+    if((uint8_t)(p->gsa_seq + 1U) == p->nm.seq) p->gsa_used = (uint8_t)(p->gsa_used + used);   /* 直前の文もGSA */
+    else                                         p->gsa_used = (uint8_t)used;
+    p->gsa_seq = p->nm.seq;
+
+    p->gsa_open = 1U;
+
+    p->wk.fix_type = (int8_t)(f[0] - '0');
+    int32_t v;
+    if(fx_parse(nm_fld(p, 15), 2, &v) && v >= 0 && v <= 9999) p->wk.pdop_c = (int16_t)v;
+    if(fx_parse(nm_fld(p, 16), 2, &v) && v >= 0 && v <= 9999) p->wk.hdop_c = (int16_t)v;
+    if(fx_parse(nm_fld(p, 17), 2, &v) && v >= 0 && v <= 9999) p->wk.vdop_c = (int16_t)v;
+    return 1;
+}
+
+/* GSV: 1:総文数,2:文番号,3:可視衛星数,...。話者（系）ごとに保持して合計 */
+static int nmea_on_gsv(gps_parser_t *p)
+{
+    uint8_t *view = p->gsv_view;
+    if(p->nm.nf < 4) return 0;
+    const char *n = nm_fld(p, 3);
+    if(!is_d(n[0]) || (n[1] && (!is_d(n[1]) || n[2]))) return 0;
+
+    uint8_t k;
+    switch(p->nm.id >> 15){
+    case GPS_NMEA_TALKER('G','P'): k = 0; break;
+    case GPS_NMEA_TALKER('G','L'): k = 1; break;
+    case GPS_NMEA_TALKER('G','A'): k = 2; break;
+    case GPS_NMEA_TALKER('G','B'):
+    case GPS_NMEA_TALKER('B','D'): k = 3; break;
+    default: return 1;              /* GN 等は系が特定できないので数えない */
+    }
+    view[k] = (uint8_t)(n[1] ? (n[0]-'0')*10 + (n[1]-'0') : (n[0]-'0'));
+
+    int sum = 0;
+    for(uint8_t i=0;i<4;i++){ if(view[i] != 0xFF) sum += view[i]; }
+    p->wk.sat_view = (int8_t)(sum > 127 ? 127 : sum);
+    return 1;
+}
+
+/* GLL: 1:lat,2:N/S,3:lon,4:E/W,5:time,6:A/V */
+static int nmea_on_gll(gps_parser_t *p)
+{
+    if(p->nm.nf < 7) return 0;
+    if(*nm_fld(p, 6) != 'A') return 1;   /* 無効測位は受理のみ */
+    (void)dm_parse(nm_fld(p, 1), 'S', *nm_fld(p, 2), 90U, &p->wk.lat);
+    (void)dm_parse(nm_fld(p, 3), 'W', *nm_fld(p, 4), 180U, &p->wk.lon);
+    if(hms_parse(p, nm_fld(p, 5))) derive_local(p);
+    return 1;
+}
+
+/* ==== NMEA を解析し、文種別ごとのハンドラへ振り分け ================= */
+/* 1バイト解析。文が完了したらハンドラを呼び、受理した GPS_UPD_* を返す */
+static uint8_t nm_byte(gps_parser_t *p, char ch)
+{
+    if(ch == '\n') p->st.rx_lines++;
+
+    int r = nmea_feed(p, ch);
+    if(r == 0) return 0;
+    p->nm.seq++;
+    if(r < 0) p->st.rx_ckerr++;
+
+    uint8_t upd = 0;
+    if(p->nm.route != GPS_ROUTE_NONE){
+        PROF_BEGIN(PROF_NMEA_SENT);
+        const gps_route_t *rt = &p->route[p->nm.route];
+        if(r > 0) nm_copy_last(p);
+        if(r > 0 && rt->fn(p)){ if(rt->st != GPS_ST_NONE) p->st.ok[rt->st]++;  upd = rt->upd; }
+        else                  { if(rt->st != GPS_ST_NONE) p->st.bad[rt->st]++; }
+        PROF_END(PROF_NMEA_SENT);
+    }
+
+    /* 連続GSAが切れた（この文は受理したGSAでない）：合計を確定。途中で公開すると
+       系ごとの GSA の間で使用衛星数が 12→24→36 と跳ねる */
+    if(p->gsa_open && p->gsa_seq != p->nm.seq){
+        p->gsa_open = 0U;
+        p->wk.sat_used = (int8_t)(p->gsa_used > 127U ? 127U : p->gsa_used);
+        upd |= GPS_UPD_GSA;
+    }
+    return upd;
+}
+
+uint8_t gps_parser_poll(gps_parser_t *p)
+{
+    PROF_BEGIN(PROF_GPS_POLL);
     uint8_t updated = 0;
 
-    while(ring_avail() > 0){
-        int ci = ring_get();
-        if(ci < 0) break;
-        char ch = (char)ci;
-        if(ch == '\r') continue;
-
-        if(ch == '\n'){
-            line[L] = '\0';
-            gps_rx_lines++;
-            size_t len = (size_t)L;
-
-            /* ---- RMC ---- */
-            if(L>=6 &&
-               (strncmp(line,"$GPRMC",6)==0 || strncmp(line,"$GNRMC",6)==0) &&
-               nmea_ck_ok(line,len))
-            {
-                size_t n = strlen(line);
-                if(n >= GPS_LAST_SENTENCE_MAX) n = GPS_LAST_SENTENCE_MAX-1;
-                for(size_t i=0;i<n;i++) gps_last_sentence[i]=line[i];
-                gps_last_sentence[n]='\0';
-
-                /* トークン化 */
-                char tmp[GPS_RX_BUF_SZ];
-                strncpy(tmp,line,sizeof(tmp)-1); tmp[sizeof(tmp)-1]='\0';
-                char *fld[20]={0}; int nf=0; fld[nf++]=tmp;
-                for(char *p=tmp; *p && nf<20; ++p){
-                    if(*p==',' || *p=='*'){ *p='\0'; if(*(p+1)) fld[nf++]=p+1; }
-                }
-                /* RMC: 0:$G?RMC,1:time,2:A/V,3:lat,4:N/S,5:lon,6:E/W,7:knots,8:cog,9:date(ddmmyy),... */
-                if(nf>=10){
-                    const char *t   = fld[1]; /* hhmmss.sss */
-                    const char *lat = fld[3]; const char *ns = fld[4];
-                    const char *lon = fld[5]; const char *ew = fld[6];
-                    const char *spk = fld[7]; /* knots */
-                    const char *dmy = fld[9]; /* ddmmyy */
-
-                    /* UTC時刻 */
-                    if(t && strlen(t)>=6 && isdigit((unsigned char)t[0])){
-                        g_UTC_hh = (t[0]-'0')*10 + (t[1]-'0');
-                        g_UTC_mm = (t[2]-'0')*10 + (t[3]-'0');
-                        g_UTC_ss = (t[4]-'0')*10 + (t[5]-'0');
-                    }
-
-                    /* UTC日付（2000+yy） */
-                    if(dmy && strlen(dmy)==6 &&
-                       isdigit((unsigned char)dmy[0]) && isdigit((unsigned char)dmy[1]) &&
-                       isdigit((unsigned char)dmy[2]) && isdigit((unsigned char)dmy[3]) &&
-                       isdigit((unsigned char)dmy[4]) && isdigit((unsigned char)dmy[5]))
-                    {
-                        g_UTC_DD  = (dmy[0]-'0')*10 + (dmy[1]-'0');
-                        g_UTC_MM  = (dmy[2]-'0')*10 + (dmy[3]-'0');
-                        int yy    = (dmy[4]-'0')*10 + (dmy[5]-'0');
-                        g_UTC_YYYY = 2000 + yy;
-                    }
-
-                    /* 位置（float） */
-                    float latd = dm_to_deg(lat);
-                    float lond = dm_to_deg(lon);
-                    if(!isnan(latd)){ if(ns && *ns=='S') latd = -latd; g_LTT = latd; }
-                    if(!isnan(lond)){ if(ew && *ew=='W') lond = -lond; g_LGT = lond; }
-
-                    /* 速度：knots→m/s（float） */
-                    if(spk && *spk){
-                        char *ep=NULL; float kn = strtof(spk,&ep);
-                        if(ep!=spk) g_SPD = kn * 0.514444f;
-                    }
-
-                    /* === 現地時間・現地日付（UTCとUTC日付が揃っていれば） ==== */
-                    if(g_UTC_hh>=0 && g_UTC_mm>=0 && g_UTC_ss>=0){
-                        /* 分・秒はUTCのまま */
-                        g_LCL_mm = g_UTC_mm;
-                        g_LCL_ss = g_UTC_ss;
-
-                        int tz  = tz_from_longitude(g_LGT);
-                        int lhh = g_UTC_hh + tz;
-
-                        /* UTC日付が未取得なら時だけ正規化（現地日付は据え置き） */
-                        if(g_UTC_YYYY<0 || g_UTC_MM<1 || g_UTC_DD<1){
-                            g_LCL_hh = wrap24(lhh);
-                        }else{
-                            int y=g_UTC_YYYY, m=g_UTC_MM, d=g_UTC_DD;
-                            while(lhh < 0){ lhh += 24; dec_day(&y,&m,&d); }
-                            while(lhh >= 24){ lhh -= 24; inc_day(&y,&m,&d); }
-                            g_LCL_hh = lhh;
-                            g_LCL_YYYY = y; g_LCL_MM = m; g_LCL_DD = d;  /* ← 現地日付確定 */
-                        }
-                    }
-
-                    gps_rmc_ok++; updated |= 1;
-                }else{
-                    gps_rmc_bad++;
-                }
-            }
-            /* ---- GGA ---- */
-            else if(L>=6 &&
-                    (strncmp(line,"$GPGGA",6)==0 || strncmp(line,"$GNGGA",6)==0) &&
-                    nmea_ck_ok(line,len))
-            {
-                size_t n = strlen(line);
-                if(n >= GPS_LAST_SENTENCE_MAX) n = GPS_LAST_SENTENCE_MAX-1;
-                for(size_t i=0;i<n;i++) gps_last_sentence[i]=line[i];
-                gps_last_sentence[n]='\0';
-
-                char tmp[GPS_RX_BUF_SZ];
-                strncpy(tmp,line,sizeof(tmp)-1); tmp[sizeof(tmp)-1]='\0';
-                char *fld[20]={0}; int nf=0; fld[nf++]=tmp;
-                for(char *p=tmp; *p && nf<20; ++p){
-                    if(*p==',' || *p=='*'){ *p='\0'; if(*(p+1)) fld[nf++]=p+1; }
-                }
-                /* 9: alt(m) */
-                if(nf>=11){
-                    const char *alt = fld[9];
-                    if(alt && *alt){
-                        char *ep=NULL; float a = strtof(alt,&ep);
-                        if(ep!=alt) g_ALT = a;
-                    }
-                    gps_gga_ok++; updated |= 2;
-                }else{
-                    gps_gga_bad++;
-                }
-            }else{
-                if(L>=6 && (strncmp(line,"$GPRMC",6)==0 || strncmp(line,"$GNRMC",6)==0)) gps_rmc_bad++;
-                else if(L>=6 && (strncmp(line,"$GPGGA",6)==0 || strncmp(line,"$GNGGA",6)==0)) gps_gga_bad++;
-            }
+#if GPS_RX_USE_DMA
+    if(p->dma_on) rx_dma_sync(p);   /* IDLE待ちせず到着済み分をまとめて取り込む */
+#endif
 
-            L = 0;
-        }else{
-            if(L < GPS_RX_BUF_SZ-1) line[L++] = ch;
-            else L = 0;
+    while(ring_avail(p) > 0){
+        int ci = ring_get(p);
+        if(ci == RING_GAP){                    /* 途中の文は捨てて次の '$' を待つ */
+            if(p->nm.st != NM_IDLE) p->st.rx_resync++;
+            p->nm.st = NM_IDLE;
+            continue;
         }
+        if(ci < 0) break;
+        updated |= nm_byte(p, (char)ci);
     }
 
+    if(updated) fix_publish(p, updated);
+    PROF_END(PROF_GPS_POLL);
+    return updated;
+}
+
+/* リングを通さない。'\0' は欠落の印として扱う（リングと同じ） */
+uint8_t gps_parser_feed(gps_parser_t *p, const void *buf, uint32_t n)
+{
+    const uint8_t *b = (const uint8_t *)buf;
+    uint8_t updated = 0;
+    p->st.rx_bytes += n;
+    for(uint32_t i=0;i<n;i++){
+        if(!b[i]){
+            if(p->nm.st != NM_IDLE) p->st.rx_resync++;
+            p->nm.st = NM_IDLE;
+            continue;
+        }
+        updated |= nm_byte(p, (char)b[i]);
+    }
+    if(updated) fix_publish(p, updated);
     return updated;
 }
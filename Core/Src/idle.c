@@ -0,0 +1,64 @@
+#include "idle.h"
+
+#if IDLE_ENABLE
+#include "prof.h"
+
+volatile uint32_t idle_wakeups = 0;
+volatile uint16_t idle_busy_pm = 1000U;
+
+static volatile uint8_t s_ev = 0;        /* 割込みからの仕事の知らせ */
+static uint32_t s_sleep = 0;             /* 今の窓で眠っていた [TIM2 tick] */
+static uint32_t s_win_cnt = 0;           /* 窓の始まり（TIM2） */
+static uint32_t s_win_ms = 0;
+
+void idle_init(void)
+{
+    SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk | SCB_SCR_SLEEPONEXIT_Msk);   /* WFI = Sleep */
+    s_ev = 0; s_sleep = 0;
+    s_win_cnt = TIM2->CNT;
+    s_win_ms = HAL_GetTick();
+    idle_wakeups = 0;
+    idle_busy_pm = 1000U;
+}
+
+void idle_event(void){ s_ev = 1U; }
+
+void idle_wait(void)
+{
+    const uint32_t ms = HAL_GetTick();
+    uint8_t slept = 0;
+#if PROF_ENABLE
+    uint32_t t_wake = 0;
+#endif
+
+    __disable_irq();
+    while(!s_ev && HAL_GetTick() == ms){
+        uint32_t c0 = TIM2->CNT;
+        __WFI();
+#if PROF_ENABLE
+        t_wake = prof_now();
+#endif
+        s_sleep += TIM2->CNT - c0;
+        idle_wakeups++;
+        slept = 1U;
+        __enable_irq();                  /* 起こした割込みはここで走る */
+        __disable_irq();
+    }
+    s_ev = 0;
+    __enable_irq();
+
+#if PROF_ENABLE
+    if(slept) prof_add(PROF_WAKE, prof_now() - t_wake);
+#else
+    (void)slept;
+#endif
+
+    uint32_t now = HAL_GetTick();
+    if(now - s_win_ms >= 1000U){
+        uint32_t cnt = TIM2->CNT, total = cnt - s_win_cnt;
+        uint32_t sl  = (s_sleep < total) ? s_sleep : total;
+        idle_busy_pm = total ? (uint16_t)(1000U - (uint32_t)(((uint64_t)sl * 1000U) / total)) : 1000U;
+        s_win_cnt = cnt; s_win_ms = now; s_sleep = 0;
+    }
+}
+#endif /* IDLE_ENABLE */
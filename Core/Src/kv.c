@@ -0,0 +1,338 @@
+#include "kv.h"
+
+#if KV_ENABLE
+#include "crc.h"
+#include <string.h>
+
+volatile uint32_t kv_erases = 0;
+volatile uint32_t kv_seq    = 0;
+
+/* ==== フラッシュ上の形式 ============================================== */
+/* ページ: [seq u32][magic u16][crc u16][記録…]。見出しは詰め直しの最後に seq → magic → crc の順で書き、
+           crc まで揃ったページだけを有効とする（消去が途中で切れて seq が化けたページも弾く）。
+   記録:   [key u16][len u16][値（偶数へ 0xFF で詰める）][crc u16]。crc は key から値の詰めまで。
+   未書込みの半語は 0xFFFF で、key=0xFFFF が記録の終わり */
+#define KV_MAGIC     0x564BU                 /* "KV" */
+#define HDR_SIZE     8U
+#define REC_HDR      4U
+#define REC_MAX      (REC_HDR + KV_MAX_LEN + 2U)
+#define ERASED16     0xFFFFU
+#define REC_SIZE(n)  ((uint16_t)(REC_HDR + (((n) + 1U) & ~1U) + 2U))
+
+#if (KV_MAX_LEN & 1U) || KV_MAX_KEYS > 32U || KV_MAX_KEYS * REC_MAX + HDR_SIZE > KV_PAGE_SIZE
+#error "kv: KV_MAX_LEN must be even and all keys must fit in one page"
+#endif
+
+#ifndef KV_FLASH_BASE
+extern const uint16_t _kv_start[];           /* リンカスクリプトの KVSTORE（2ページ） */
+#define KV_FLASH_BASE  ((uint32_t)(uintptr_t)_kv_start)
+#endif
+
+/* ==== フラッシュ操作（ホストビルドでは hal_fake のフラッシュ模型に差し替わる） ==== */
+#ifndef KV_FLASH_PROG16
+static void flash_begin(void)
+{
+    while(FLASH->SR & FLASH_SR_BSY){}
+    if(FLASH->CR & FLASH_CR_LOCK){ FLASH->KEYR = FLASH_KEY1; FLASH->KEYR = FLASH_KEY2; }
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPERR;
+}
+
+static uint8_t flash_end(uint32_t cr_bit)
+{
+    while(FLASH->SR & FLASH_SR_BSY){}
+    FLASH->CR &= ~cr_bit;
+    FLASH->CR |= FLASH_CR_LOCK;
+    return (uint8_t)!(FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPERR));
+}
+
+/* 半語の書込み（約 50us、その間フラッシュからの命令読出しは待たされる）。返値: 1=書けた */
+static uint8_t flash_prog16(uint32_t addr, uint16_t v)
+{
+    flash_begin();
+    FLASH->CR |= FLASH_CR_PG;
+    *(volatile uint16_t*)(uintptr_t)addr = v;
+    return (uint8_t)(flash_end(FLASH_CR_PG) && *(volatile uint16_t*)(uintptr_t)addr == v);
+}
+
+/* ページ消去（20〜40ms） */
+static uint8_t flash_erase(uint32_t addr)
+{
+    flash_begin();
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR = addr;
+    FLASH->CR |= FLASH_CR_STRT;
+    return flash_end(FLASH_CR_PER);
+}
+#define KV_FLASH_PROG16(a, v)  flash_prog16((a), (v))
+#define KV_FLASH_ERASE(a)      flash_erase(a)
+#endif
+
+/* ==== RAM の写し ======================================================= */
+typedef struct {
+    uint16_t key;              /* 0=空き */
+    uint16_t ver, ver_fl;      /* 更新ごとに ver++、フラッシュにある版が ver_fl（違えば書き残し） */
+    uint8_t  len;
+    uint8_t  val[KV_MAX_LEN];
+} kv_ent_t;
+
+static kv_ent_t s_ent[KV_MAX_KEYS];
+static uint8_t  s_act = 0;           /* 有効ページ 0/1 */
+static uint16_t s_wr  = HDR_SIZE;    /* 有効ページの次の書込み位置 [byte] */
+static uint8_t  s_spare_blank = 0;   /* 1=もう1枚は消去済み */
+
+/* 書込み中の記録（半語の並び）と、その行き先 */
+enum { M_APPEND, M_COPY, M_HDR };
+static uint16_t s_rec[REC_MAX / 2U];
+static uint8_t  s_rec_n = 0, s_rec_i = 0, s_rec_mode, s_rec_ent;
+static uint16_t s_rec_ver;
+static uint32_t s_rec_at;
+
+/* 詰め直し（有効ページの生きた値 → 空きページ） */
+static uint8_t  s_cp = 0;            /* 1=実行中 */
+static uint8_t  s_cp_i;              /* 次に写す s_ent の番号 */
+static uint16_t s_cp_wr;
+static uint32_t s_cp_mask;           /* 写した s_ent */
+static uint16_t s_cp_ver[KV_MAX_KEYS];
+
+static uint32_t page_base(uint8_t p){ return KV_FLASH_BASE + (uint32_t)p * KV_PAGE_SIZE; }
+static uint16_t rd16(uint32_t a){ return *(const volatile uint16_t*)(uintptr_t)a; }
+
+static void hdr_image(uint32_t seq, uint8_t b[HDR_SIZE])
+{
+    b[0] = (uint8_t)seq; b[1] = (uint8_t)(seq >> 8); b[2] = (uint8_t)(seq >> 16); b[3] = (uint8_t)(seq >> 24);
+    b[4] = (uint8_t)KV_MAGIC; b[5] = (uint8_t)(KV_MAGIC >> 8);
+    uint16_t c = crc16_ccitt(b, 6U);
+    b[6] = (uint8_t)c; b[7] = (uint8_t)(c >> 8);
+}
+
+/* 返値: 1=有効（*seq に世代） */
+static uint8_t page_valid(uint8_t p, uint32_t *seq)
+{
+    const uint8_t *h = (const uint8_t*)(uintptr_t)page_base(p);
+    uint32_t q = (uint32_t)h[0] | ((uint32_t)h[1] << 8) | ((uint32_t)h[2] << 16) | ((uint32_t)h[3] << 24);
+    uint8_t b[HDR_SIZE];
+    hdr_image(q, b);
+    if(memcmp(b, h, HDR_SIZE) != 0) return 0;
+    *seq = q;
+    return 1U;
+}
+
+static uint8_t page_blank(uint8_t p)
+{
+    for(uint32_t a = page_base(p); a < page_base(p) + KV_PAGE_SIZE; a += 2U){
+        if(rd16(a) != ERASED16) return 0;
+    }
+    return 1U;
+}
+
+static uint8_t erase_page(uint8_t p)
+{
+    uint8_t ok = KV_FLASH_ERASE(page_base(p));
+    kv_erases++;
+    return (uint8_t)(ok && page_blank(p));
+}
+
+static kv_ent_t *find(uint16_t key)
+{
+    for(uint8_t i=0;i<KV_MAX_KEYS;i++){ if(s_ent[i].key == key) return &s_ent[i]; }
+    return NULL;
+}
+
+/* 有効ページを頭から読み、キーごとに最後の正しい記録を残す */
+static void scan(uint8_t p)
+{
+    const uint32_t base = page_base(p);
+    uint16_t off = HDR_SIZE;
+
+    while((uint32_t)off + REC_SIZE(0) <= KV_PAGE_SIZE){
+        uint16_t key = rd16(base + off), len = rd16(base + off + 2U);
+        if(key == ERASED16) break;                                   /* 記録の終わり */
+        if(len > KV_MAX_LEN || (uint32_t)off + REC_SIZE(len) > KV_PAGE_SIZE){  /* 見出しが書きかけ：残りは使わない */
+            off = KV_PAGE_SIZE;
+            break;
+        }
+        const uint8_t *r = (const uint8_t*)(uintptr_t)(base + off);
+        uint16_t n = (uint16_t)(REC_HDR + ((len + 1U) & ~1U));
+        if(crc16_ccitt(r, n) == (uint16_t)(r[n] | (r[n + 1U] << 8)) && key != 0U){
+            kv_ent_t *e = find(key);
+            if(!e) e = find(0U);
+            if(e){
+                e->key = key; e->len = (uint8_t)len;
+                memcpy(e->val, r + REC_HDR, len);
+            }
+        }
+        off += REC_SIZE(len);
+    }
+    s_wr = off;   /* 満杯か書きかけで止まったなら KV_PAGE_SIZE（次の書込みで詰め直す） */
+}
+
+/* 記録の像を s_rec に作る */
+static void stage(uint8_t idx, uint8_t mode, uint32_t at)
+{
+    const kv_ent_t *e = &s_ent[idx];
+    uint8_t b[REC_MAX];
+    uint16_t n = (uint16_t)(REC_HDR + ((e->len + 1U) & ~1U));
+
+    b[0] = (uint8_t)e->key; b[1] = (uint8_t)(e->key >> 8);
+    b[2] = e->len;          b[3] = 0;
+    memcpy(&b[REC_HDR], e->val, e->len);
+    if(e->len & 1U) b[REC_HDR + e->len] = 0xFFU;
+    uint16_t c = crc16_ccitt(b, n);
+    b[n] = (uint8_t)c; b[n + 1U] = (uint8_t)(c >> 8);
+
+    n = (uint16_t)(n + 2U);
+    for(uint16_t i=0;i<n/2U;i++) s_rec[i] = (uint16_t)(b[2U*i] | (b[2U*i + 1U] << 8));
+    s_rec_n = (uint8_t)(n / 2U); s_rec_i = 0;
+    s_rec_mode = mode; s_rec_ent = idx; s_rec_ver = e->ver; s_rec_at = at;
+}
+
+static void stage_hdr(uint32_t seq, uint32_t at)
+{
+    uint8_t b[HDR_SIZE];
+    hdr_image(seq, b);
+    for(uint8_t i=0;i<HDR_SIZE/2U;i++) s_rec[i] = (uint16_t)(b[2U*i] | (b[2U*i + 1U] << 8));
+    s_rec_n = HDR_SIZE / 2U; s_rec_i = 0;
+    s_rec_mode = M_HDR; s_rec_at = at;
+}
+
+/* 書き終えた記録の後始末 */
+static void rec_done(void)
+{
+    switch(s_rec_mode){
+    case M_APPEND:
+        s_ent[s_rec_ent].ver_fl = s_rec_ver;
+        s_wr = (uint16_t)(s_wr + s_rec_n * 2U);
+        break;
+    case M_COPY:
+        s_cp_ver[s_rec_ent] = s_rec_ver;
+        s_cp_mask |= 1UL << s_rec_ent;
+        s_cp_wr = (uint16_t)(s_cp_wr + s_rec_n * 2U);
+        break;
+    default:                                   /* 見出しまで書けた：切替 */
+        for(uint8_t i=0;i<KV_MAX_KEYS;i++){ if(s_cp_mask & (1UL << i)) s_ent[i].ver_fl = s_cp_ver[i]; }
+        s_act ^= 1U;
+        s_wr = s_cp_wr;
+        kv_seq++;
+        s_spare_blank = 0;                     /* 旧ページは次に許された周で消す */
+        s_cp = 0;
+        break;
+    }
+    s_rec_n = 0;
+}
+
+/* 書けなかった（書きかけの残骸・電源の異常）。追記なら詰め直しへ、詰め直しなら中止して消去から */
+static void rec_fail(void)
+{
+    if(s_rec_mode == M_APPEND) s_wr = KV_PAGE_SIZE;
+    else { s_cp = 0; s_spare_blank = 0; }
+    s_rec_n = 0;
+}
+
+/* 次に書く記録を用意する。返値: 1=用意した 0=今は何もない（消去した周も 0） */
+static uint8_t next_rec(uint8_t may_erase)
+{
+    if(s_cp){
+        const uint32_t dst = page_base(s_act ^ 1U);
+        while(s_cp_i < KV_MAX_KEYS && s_ent[s_cp_i].key == 0U) s_cp_i++;
+        if(s_cp_i < KV_MAX_KEYS){ stage(s_cp_i, M_COPY, dst + s_cp_wr); s_cp_i++; }
+        else stage_hdr(kv_seq + 1U, dst);
+        return 1U;
+    }
+
+    uint8_t idx = KV_MAX_KEYS;
+    for(uint8_t i=0;i<KV_MAX_KEYS;i++){
+        if(s_ent[i].key && s_ent[i].ver != s_ent[i].ver_fl){ idx = i; break; }
+    }
+
+    if(!s_spare_blank && may_erase){           /* 空きページは先に消しておく（詰め直しで待たない） */
+        s_spare_blank = erase_page(s_act ^ 1U);
+        return 0;
+    }
+    if(idx == KV_MAX_KEYS) return 0;
+
+    if(s_wr + REC_SIZE(s_ent[idx].len) > KV_PAGE_SIZE){
+        if(!s_spare_blank) return 0;           /* 消去の許しを待つ（値は RAM にある） */
+        s_cp = 1U; s_cp_i = 0; s_cp_wr = HDR_SIZE; s_cp_mask = 0;
+        return next_rec(may_erase);
+    }
+    stage(idx, M_APPEND, page_base(s_act) + s_wr);
+    return 1U;
+}
+
+/* ==== API ============================================================ */
+void kv_init(void)
+{
+    uint32_t q0 = 0, q1 = 0;
+    uint8_t v0 = page_valid(0, &q0), v1 = page_valid(1U, &q1);
+
+    memset(s_ent, 0, sizeof s_ent);
+    s_rec_n = 0; s_cp = 0;
+    kv_erases = 0;
+
+    if(!v0 && !v1){                            /* 初回（か両方壊れた）：0 ページ目を作る */
+        uint8_t b[HDR_SIZE];
+        s_act = 0;
+        if(!page_blank(0)) (void)erase_page(0);
+        hdr_image(1U, b);
+        for(uint8_t i=0;i<HDR_SIZE/2U;i++) (void)KV_FLASH_PROG16(page_base(0) + 2U*i, (uint16_t)(b[2U*i] | (b[2U*i + 1U] << 8)));
+        kv_seq = 1U;
+        s_wr = HDR_SIZE;
+    } else {
+        s_act = (v0 && v1) ? (uint8_t)((int32_t)(q1 - q0) > 0) : v1;
+        kv_seq = s_act ? q1 : q0;
+        scan(s_act);
+    }
+    /* 表示の開始前なので、ここでは止まっても構わない：空きページを消しておく */
+    s_spare_blank = page_blank(s_act ^ 1U) ? 1U : erase_page(s_act ^ 1U);
+}
+
+uint8_t kv_get(uint16_t key, void *buf, uint8_t len)
+{
+    const kv_ent_t *e = (key && key != ERASED16) ? find(key) : NULL;
+    if(!e || e->len != len) return 0;          /* 型（長さ）が変わった値は読まない */
+    memcpy(buf, e->val, len);
+    return len;
+}
+
+uint8_t kv_set(uint16_t key, const void *buf, uint8_t len)
+{
+    if(!key || key == ERASED16 || len > KV_MAX_LEN) return 0;
+    kv_ent_t *e = find(key);
+    if(e && e->len == len && memcmp(e->val, buf, len) == 0) return 1U;
+    if(!e){
+        e = find(0U);
+        if(!e) return 0;
+        e->key = key;
+    }
+    e->len = len;
+    memcpy(e->val, buf, len);
+    e->ver++;
+    return 1U;
+}
+
+void kv_poll(uint8_t may_erase)
+{
+    uint8_t n = KV_PROG_PER_POLL;
+    while(n){
+        if(s_rec_i < s_rec_n){
+            if(!KV_FLASH_PROG16(s_rec_at + 2U * s_rec_i, s_rec[s_rec_i])){ rec_fail(); return; }
+            s_rec_i++; n--;
+            continue;
+        }
+        if(s_rec_n) rec_done();
+        if(!next_rec(may_erase)) return;
+    }
+}
+
+uint8_t kv_pending(void)
+{
+    if(s_rec_n || s_cp) return 1U;
+    for(uint8_t i=0;i<KV_MAX_KEYS;i++){ if(s_ent[i].key && s_ent[i].ver != s_ent[i].ver_fl) return 1U; }
+    return 0;
+}
+
+void kv_flush(void)
+{
+    for(uint16_t i = 0; i < 4096U && kv_pending(); i++) kv_poll(1U);
+}
+#endif /* KV_ENABLE */
@@ -1,4 +1,5 @@
 #include "nixie.h"
+#include "prof.h"
 #include <stdlib.h>
 
 /* ===== IN-14 実機ビット割り当て =====
@@ -40,67 +41,440 @@ static inline uint16_t NIXIE_CODE(uint8_t digit, uint8_t dotL, uint8_t dotR)
 #endif
 }
 
-/* ===== 低レベルGPIO（8本のシリアル入力線） ===== */
-static inline void SR0_set(uint8_t b){ HAL_GPIO_WritePin(SR0_GPIO_Port, SR0_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR1_set(uint8_t b){ HAL_GPIO_WritePin(SR1_GPIO_Port, SR1_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR2_set(uint8_t b){ HAL_GPIO_WritePin(SR2_GPIO_Port, SR2_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR3_set(uint8_t b){ HAL_GPIO_WritePin(SR3_GPIO_Port, SR3_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR4_set(uint8_t b){ HAL_GPIO_WritePin(SR4_GPIO_Port, SR4_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR5_set(uint8_t b){ HAL_GPIO_WritePin(SR5_GPIO_Port, SR5_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR6_set(uint8_t b){ HAL_GPIO_WritePin(SR6_GPIO_Port, SR6_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-static inline void SR7_set(uint8_t b){ HAL_GPIO_WritePin(SR7_GPIO_Port, SR7_Pin, b?GPIO_PIN_SET:GPIO_PIN_RESET); }
-
-static inline void SHCP_pulse(void){ HAL_GPIO_WritePin(SHCP_GPIO_Port, SHCP_Pin, GPIO_PIN_SET); HAL_GPIO_WritePin(SHCP_GPIO_Port, SHCP_Pin, GPIO_PIN_RESET); }
-static inline void STCP_latch(void){ HAL_GPIO_WritePin(STCP_GPIO_Port, STCP_Pin, GPIO_PIN_SET); HAL_GPIO_WritePin(STCP_GPIO_Port, STCP_Pin, GPIO_PIN_RESET); }
-
-static inline void SR0_set_bit(uint16_t v,int8_t i){ SR0_set((uint8_t)((v>>i)&1U)); }
-static inline void SR1_set_bit(uint16_t v,int8_t i){ SR1_set((uint8_t)((v>>i)&1U)); }
-static inline void SR2_set_bit(uint16_t v,int8_t i){ SR2_set((uint8_t)((v>>i)&1U)); }
-static inline void SR3_set_bit(uint16_t v,int8_t i){ SR3_set((uint8_t)((v>>i)&1U)); }
-static inline void SR4_set_bit(uint16_t v,int8_t i){ SR4_set((uint8_t)((v>>i)&1U)); }
-static inline void SR5_set_bit(uint16_t v,int8_t i){ SR5_set((uint8_t)((v>>i)&1U)); }
-static inline void SR6_set_bit(uint16_t v,int8_t i){ SR6_set((uint8_t)((v>>i)&1U)); }
-static inline void SR7_set_bit(uint16_t v,int8_t i){ SR7_set((uint8_t)((v>>i)&1U)); }
-
-/* ===== 8桁 enable マスク（1=有効） ===== */
+/* ===== 低レベルGPIO（8本のシリアル入力線） =====
+   SR0..SR7 は同一ポートの連続8ピン（PA3..PA10）。1ビット分の8本を BSRR 1語で
+   同時に set/reset し、SHCP/STCP は BSRR/BRR への1ストアで叩く */
+#define SR_PORT   SR0_GPIO_Port
+#define SR_SHIFT  3U
+_Static_assert(SR0_Pin == (1U << SR_SHIFT) &&
+               (SR0_Pin|SR1_Pin|SR2_Pin|SR3_Pin|SR4_Pin|SR5_Pin|SR6_Pin|SR7_Pin) == (0xFFU << SR_SHIFT),
+               "SR0..SR7 は連続ピン（SR0=bit SR_SHIFT）前提");
+
+/* ホストビルドでは GPIO 書込みをトレースへ通すため差し替える（Host/fake/stm32f3xx_hal.h） */
+#ifndef NIXIE_GPIO_BSRR
+#define NIXIE_GPIO_BSRR(port, w)  ((port)->BSRR = (w))
+#endif
+#ifndef NIXIE_GPIO_BRR
+#define NIXIE_GPIO_BRR(port, w)   ((port)->BRR = (w))
+#endif
+
+static inline void SHCP_pulse(void){ NIXIE_GPIO_BSRR(SHCP_GPIO_Port, SHCP_Pin); NIXIE_GPIO_BRR(SHCP_GPIO_Port, SHCP_Pin); }
+static inline void STCP_latch(void){ NIXIE_GPIO_BSRR(STCP_GPIO_Port, STCP_Pin); NIXIE_GPIO_BRR(STCP_GPIO_Port, STCP_Pin); }
+
+/* 4bit → bit j を byte j の bit0 へ展開（8本×12bit の転置用） */
+static const uint32_t NIBBLE_SPREAD[16] = {
+    0x00000000U, 0x00000001U, 0x00000100U, 0x00000101U,
+    0x00010000U, 0x00010001U, 0x00010100U, 0x00010101U,
+    0x01000000U, 0x01000001U, 0x01000100U, 0x01000101U,
+    0x01010000U, 0x01010001U, 0x01010100U, 0x01010101U
+};
+
+/* sr[k]（SRk へ送る12bit）→ 送出順に bit11..bit0 の BSRR 語 12個。
+   bsrr[i] は「SRk の bit i が1なら set、0なら reset」を8本ぶん同時に表す */
+static void frame_to_bsrr(const uint16_t sr[8], uint32_t bsrr[12])
+{
+    uint32_t col[3] = { 0U, 0U, 0U };   /* col[q] の byte j = 各 SR の bit(4q+j)、bit k = SRk */
+    for(uint8_t k=0;k<8;k++){
+        uint16_t x = sr[k];
+        col[0] |= NIBBLE_SPREAD[ x       & 0xFU] << k;
+        col[1] |= NIBBLE_SPREAD[(x >> 4) & 0xFU] << k;
+        col[2] |= NIBBLE_SPREAD[(x >> 8) & 0xFU] << k;
+    }
+    for(uint8_t i=0;i<12;i++){
+        uint32_t b = (col[i >> 2] >> ((i & 3U) * 8U)) & 0xFFU;
+        bsrr[i] = (b << SR_SHIFT) | ((b ^ 0xFFU) << (SR_SHIFT + 16U));
+    }
+}
+
+/* ===== 8桁 enable マスク（1=有効）と表示中フレーム ===== */
 static volatile uint8_t g_sr_enable = 0xFFU;
+static uint16_t         s_cur[8];              /* 表示中のコード（左→右） */
+static volatile uint8_t s_dirty = 0;           /* 1=リフレッシュ割込みで送り直す */
+
+/* ===== PWM リフレッシュ／カソード保護の状態（割込み側） ===== */
+#define NIXIE_PWM_SLOT_HZ (NIXIE_PWM_FRAME_HZ * NIXIE_PWM_STEPS)
+static uint8_t          s_duty[8];             /* 左→右、0..NIXIE_PWM_STEPS */
+static volatile uint8_t s_pwm_run  = 0;
+static uint8_t          s_pwm_slot = 0;
+static uint8_t          s_pwm_last = 0xFFU;    /* 直前に送ったマスク（実効） */
+static volatile uint8_t s_acp_on   = 0;        /* 1=カソード巡回中 */
+static uint16_t         s_acp_steps;           /* 残りステップ（1ステップ=全桁が1数字進む） */
+static uint16_t         s_acp_slots;           /* 1ステップのスロット数 */
+static uint16_t         s_acp_t;
+static uint8_t          s_acp_d;               /* 左端の桁に出す数字 */
+static uint16_t         s_xf[8];               /* クロスフェード先（左→右） */
+static volatile uint8_t s_xf_lvl  = 0;         /* 0=なし、スロット < lvl で s_xf を表示 */
+static uint8_t          s_xf_last = 0;         /* 直前に送ったのが s_xf なら1 */
+
+static void emit_frame(const uint16_t lr[8], uint8_t mask);
+
+void nixie_set_enable_mask(uint8_t mask){ g_sr_enable = mask; s_dirty = 1U; }
 
-void nixie_set_enable_mask(uint8_t mask){ g_sr_enable = mask; }
+#if NIXIE_USE_DMA
+static void dma_init(void);
+#endif
 
 void nixie_init(void)
 {
     g_sr_enable = 0xFFU;
+    for(uint8_t i=0;i<8;i++){ s_cur[i] = BLANK_12; s_duty[i] = NIXIE_PWM_STEPS; }
+    s_dirty = 0; s_acp_on = 0;
+#if NIXIE_USE_DMA
+    dma_init();
+#endif
+}
+
+/* ===== 内部：左→右の8桁を SR0..SR7 へ並べ替え、mask の無効桁をブランクへ ===== */
+static inline void frame_to_sr(const uint16_t lr[8], uint8_t mask, uint16_t sr[8])
+{
+    for(uint8_t k=0;k<8;k++) sr[k] = (mask & (1U<<k)) ? lr[7U-k] : BLANK_12;
 }
 
-/* ===== 内部：同期シフト  SR引数は SR7..SR0 の順 ===== */
-static void shift12_sync_masked(uint16_t v7,uint16_t v6,uint16_t v5,uint16_t v4,
-                                uint16_t v3,uint16_t v2,uint16_t v1,uint16_t v0)
+#if !NIXIE_USE_DMA
+/* ===== 内部：同期シフト＋ラッチ ===== */
+static void emit_frame(const uint16_t lr[8], uint8_t mask)
 {
-    if(!(g_sr_enable & (1U<<7))) v7 = BLANK_12;
-    if(!(g_sr_enable & (1U<<6))) v6 = BLANK_12;
-    if(!(g_sr_enable & (1U<<5))) v5 = BLANK_12;
-    if(!(g_sr_enable & (1U<<4))) v4 = BLANK_12;
-    if(!(g_sr_enable & (1U<<3))) v3 = BLANK_12;
-    if(!(g_sr_enable & (1U<<2))) v2 = BLANK_12;
-    if(!(g_sr_enable & (1U<<1))) v1 = BLANK_12;
-    if(!(g_sr_enable & (1U<<0))) v0 = BLANK_12;
+    PROF_BEGIN(PROF_NIXIE_EMIT);
+    uint16_t sr[8];
+    frame_to_sr(lr, mask, sr);
 
+    uint32_t bsrr[12];
+    frame_to_bsrr(sr, bsrr);
     for(int8_t i=11;i>=0;--i){
-        SR7_set_bit(v7,i); SR6_set_bit(v6,i); SR5_set_bit(v5,i); SR4_set_bit(v4,i);
-        SR3_set_bit(v3,i); SR2_set_bit(v2,i); SR1_set_bit(v1,i); SR0_set_bit(v0,i);
+        NIXIE_GPIO_BSRR(SR_PORT, bsrr[i]);   /* 8本同時にセット */
         SHCP_pulse();
     }
+    STCP_latch();
+    PROF_END(PROF_NIXIE_EMIT);
+}
+#else
+/* ===== 内部：TIM1＋DMA によるフレーム送出 =====
+   TIM1 の1周期を半ステップとし、CC1 で GPIOA.BSRR へデータ語（DMA1 Ch2）、
+   周期中央の CC2 で GPIOB.BSRR へクロック語（DMA1 Ch3）を書く。
+   偶数ステップ：データ確定 → SHCP↑、奇数ステップ：SHCP↓（データ語0=変化なし）。
+   最終ステップで STCP↑ し、Ch3 の転送完了割込みで STCP↓・停止・コールバック */
+#ifndef NIXIE_DMA_STEP_TICKS
+#define NIXIE_DMA_STEP_TICKS 16U      /* 半ステップ [TIM1 tick]。32MHz で 0.5µs */
+#endif
+#define NIXIE_DMA_STEPS 24U
+
+#define CLK_HI   ((uint32_t)SHCP_Pin)
+#define CLK_LO   ((uint32_t)SHCP_Pin << 16)
+static const uint32_t s_dma_clk[NIXIE_DMA_STEPS] = {
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO,
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO,
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO | (uint32_t)STCP_Pin
+};
+static const uint32_t s_dma_clk_arm[NIXIE_DMA_STEPS] = {     /* 先送り用：STCP を叩かない */
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO,
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO,
+    CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO, CLK_HI, CLK_LO
+};
+static uint32_t          s_dma_dat[NIXIE_DMA_STEPS];
+static volatile uint8_t  s_dma_busy = 0;
+static nixie_done_cb_t   s_dma_cb = NULL;
+static volatile uint8_t  s_pend = 0;           /* 1=送出待ちフレームあり */
+static uint16_t          s_pend_sr[8];         /* 送出待ち（マスク適用済み、SR0..SR7） */
+static nixie_done_cb_t   s_pend_cb = NULL;
+
+/* 先送りしたフレーム（NIXIE_ARM_*）。ラッチ付きの送出がシフトレジスタを上書きしたら
+   WANT に戻し、その送出の完了後に今のマスクで送り直す */
+static uint16_t          s_arm_lr[8];
+static volatile uint8_t  s_arm = NIXIE_ARM_NONE;
+static uint8_t           s_dma_arm = 0;        /* 1=送出中のものは先送り（ラッチなし） */
+
+static void dma_init(void)
+{
+    __HAL_RCC_TIM1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    TIM1->CR1  = 0;
+    TIM1->PSC  = 0;
+    TIM1->ARR  = NIXIE_DMA_STEP_TICKS - 1U;
+    TIM1->CCR1 = 1U;
+    TIM1->CCR2 = NIXIE_DMA_STEP_TICKS / 2U + 1U;
+    TIM1->CCMR1 = 0;                               /* Frozen：比較一致フラグのみ */
+    TIM1->DIER = 0;
+
+    const uint32_t ccr = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1 | DMA_CCR_PL;
+    DMA1_Channel2->CCR  = 0;
+    DMA1_Channel2->CPAR = (uint32_t)(uintptr_t)&SR_PORT->BSRR;
+    DMA1_Channel2->CCR  = ccr;
+    DMA1_Channel3->CCR  = 0;
+    DMA1_Channel3->CPAR = (uint32_t)(uintptr_t)&SHCP_GPIO_Port->BSRR;
+    DMA1_Channel3->CCR  = ccr | DMA_CCR_TCIE;
+
+    s_dma_busy = 0; s_pend = 0; s_arm = NIXIE_ARM_NONE;
+    HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+}
+
+/* 割込み禁止下で呼ぶ。sr[] を送出用テーブルへ展開して TIM1 を起動。latch=0 は先送り */
+static void dma_start(const uint16_t sr[8], nixie_done_cb_t cb, uint8_t latch)
+{
+    uint32_t bsrr[12];
+    frame_to_bsrr(sr, bsrr);
+    for(uint8_t i=0;i<12;i++){
+        s_dma_dat[2U*i]      = bsrr[11U-i];         /* bit11 から送出 */
+        s_dma_dat[2U*i + 1U] = 0U;
+    }
+    s_dma_cb   = cb;
+    s_dma_busy = 1;
+    s_dma_arm  = (uint8_t)!latch;
+    if(latch && (s_arm == NIXIE_ARM_SHIFT || s_arm == NIXIE_ARM_READY)) s_arm = NIXIE_ARM_WANT;
+
+    DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+    DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+    DMA1_Channel2->CMAR  = (uint32_t)(uintptr_t)s_dma_dat;
+    DMA1_Channel2->CNDTR = NIXIE_DMA_STEPS;
+    DMA1_Channel3->CMAR  = (uint32_t)(uintptr_t)(latch ? s_dma_clk : s_dma_clk_arm);
+    DMA1_Channel3->CNDTR = NIXIE_DMA_STEPS;
+    DMA1_Channel2->CCR |= DMA_CCR_EN;
+    DMA1_Channel3->CCR |= DMA_CCR_EN;
+
+    TIM1->CNT  = 0;
+    TIM1->SR   = 0;
+    TIM1->DIER = TIM_DIER_CC1DE | TIM_DIER_CC2DE;
+    TIM1->CR1  = TIM_CR1_CEN;
+}
+
+/* 割込み禁止下で呼ぶ。空いていれば送出、送出中なら最新の1枚として予約。
+   cb なしの予約（リフレッシュ）は、先に予約された cb を引き継ぐ */
+static uint8_t dma_send(const uint16_t sr[8], nixie_done_cb_t cb)
+{
+    if(!s_dma_busy){
+        dma_start(sr, cb, 1U);
+        return 1U;
+    }
+    for(uint8_t k=0;k<8;k++) s_pend_sr[k] = sr[k];
+    if(cb || !s_pend) s_pend_cb = cb;
+    s_pend = 1;
+    return 2U;
+}
+
+/* 割込み禁止下で呼ぶ。先送りを待っていて DMA が空いていれば送る */
+static void arm_kick(void)
+{
+    if(s_arm != NIXIE_ARM_WANT || s_dma_busy || s_pend) return;
+    uint16_t sr[8];
+    frame_to_sr(s_arm_lr, g_sr_enable & (s_pwm_run ? s_pwm_last : 0xFFU), sr);
+    dma_start(sr, NULL, 0U);
+    s_arm = NIXIE_ARM_SHIFT;
+}
+
+/* lr は s_cur のこともある。PPS ラッチ（s_cur を書き換える）と混ざらないよう、
+   並べ替えから送出開始までを割込み禁止で */
+static void emit_frame(const uint16_t lr[8], uint8_t mask)
+{
+    PROF_BEGIN(PROF_NIXIE_EMIT);
+    uint16_t sr[8];
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    frame_to_sr(lr, mask, sr);
+    (void)dma_send(sr, NULL);
+    __set_PRIMASK(pm);
+    PROF_END(PROF_NIXIE_EMIT);
+}
+
+uint8_t nixie_show_codes_async(const uint16_t codes_lr[8], nixie_done_cb_t cb)
+{
+    uint8_t r = 0U;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t k=0;k<8;k++) s_cur[k] = codes_lr[k];
+    s_arm = NIXIE_ARM_NONE;             /* 先送りより新しい表示 */
+    if(!s_acp_on){
+        uint16_t sr[8];
+        uint8_t mask = g_sr_enable & (s_pwm_run ? s_pwm_last : 0xFFU);
+        frame_to_sr(s_cur, mask, sr);
+        r = dma_send(sr, cb);
+        s_dirty = s_xf_lvl ? 1U : 0U;   /* クロスフェード中は割込み側で組み直す */
+    }
+    __set_PRIMASK(pm);
+    return r;
+}
+
+uint8_t nixie_busy(void){ return s_dma_busy; }
+
+uint8_t nixie_arm_codes(const uint16_t codes_lr[8])
+{
+    uint8_t ok = 0U;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    if(!s_acp_on && !s_xf_lvl){
+        for(uint8_t k=0;k<8;k++) s_arm_lr[k] = codes_lr[k];
+        s_arm = NIXIE_ARM_WANT;
+        arm_kick();
+        ok = 1U;
+    }
+    __set_PRIMASK(pm);
+    return ok;
+}
+
+/* PPS 捕捉割込みの先頭から。用意ができていれば STCP を叩くだけ */
+void nixie_latch_armed(void)
+{
+    if(s_arm != NIXIE_ARM_READY || s_dma_busy) return;
+    STCP_latch();
+    for(uint8_t k=0;k<8;k++) s_cur[k] = s_arm_lr[k];
+    s_arm = NIXIE_ARM_SHOWN;
+}
+
+uint8_t nixie_arm_state(void){ return s_arm; }
+
+/* DMA1 Ch3 転送完了（STCP↑ 済み） */
+void nixie_dma_irq(void)
+{
+    if(!(DMA1->ISR & DMA_ISR_TCIF3)) return;
+    DMA1->IFCR = DMA_IFCR_CGIF3;
+
+    TIM1->CR1  = 0;
+    TIM1->DIER = 0;
+    NIXIE_GPIO_BRR(STCP_GPIO_Port, STCP_Pin);
+
+    nixie_done_cb_t cb = s_dma_cb;
+    if(s_dma_arm && s_arm == NIXIE_ARM_SHIFT) s_arm = NIXIE_ARM_READY;
+    s_dma_busy = 0;
+    if(cb) cb();
+    if(s_pend && !s_dma_busy){
+        s_pend = 0;
+        dma_start(s_pend_sr, s_pend_cb, 1U);
+    }
+    arm_kick();
 }
+#endif /* NIXIE_USE_DMA */
 
-/* ===== 左→右(l0..l7) を SR7..SR0 へ（左右逆転の吸収） ===== */
+/* ===== 左→右(l0..l7) を表示中フレームとして送出 =====
+   同期シフトでリフレッシュ動作中は、送出を割込み側へ任せる（シフト途中の割込みで
+   フレームが混ざらないように） */
 static inline void display8_codes_lr(uint16_t l0,uint16_t l1,uint16_t l2,uint16_t l3,
                                      uint16_t l4,uint16_t l5,uint16_t l6,uint16_t l7)
 {
-    shift12_sync_masked(l7,l6,l5,l4,l3,l2,l1,l0);
-    STCP_latch();
+    const uint16_t v[8] = { l0, l1, l2, l3, l4, l5, l6, l7 };
+#if NIXIE_USE_DMA
+    (void)nixie_show_codes_async(v, NULL);
+#else
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t k=0;k<8;k++) s_cur[k] = v[k];
+    uint8_t defer = s_pwm_run;
+    if(defer) s_dirty = 1U;
+    __set_PRIMASK(pm);
+    if(!defer && !s_acp_on) emit_frame(s_cur, g_sr_enable);
+#endif
+}
+
+/* ===== PWM リフレッシュ（TIM6） =====
+   1フレームを NIXIE_PWM_STEPS スロットに分け、桁ごとに duty スロットだけ点灯。
+   点灯窓は桁ごとに 1/8 周期ずらし、同時点灯数（高圧電源の負荷）を平均化する。
+   マスクが変わったスロットだけ送り直すので、全桁フル輝度なら送出は起きない */
+void nixie_pwm_start(void)
+{
+    uint32_t f = HAL_RCC_GetPCLK1Freq();
+    if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) f *= 2U;
+
+    __HAL_RCC_TIM6_CLK_ENABLE();
+    TIM6->CR1  = 0;
+    TIM6->PSC  = 0;
+    TIM6->ARR  = f / NIXIE_PWM_SLOT_HZ - 1U;
+    TIM6->EGR  = TIM_EGR_UG;
+    TIM6->SR   = 0;
+    TIM6->DIER = TIM_DIER_UIE;
+
+    s_pwm_slot = 0; s_pwm_last = 0xFFU; s_dirty = 1U;
+    s_pwm_run  = 1U;
+    HAL_NVIC_SetPriority(TIM6_DAC1_IRQn, 1, 0);   /* PPS 捕捉・フレーム完了より下 */
+    HAL_NVIC_EnableIRQ(TIM6_DAC1_IRQn);
+    TIM6->CR1  = TIM_CR1_CEN;
+}
+
+void nixie_set_duty(uint8_t pos, uint8_t duty)
+{
+    if(pos >= 8U) return;
+    s_duty[pos] = (duty > NIXIE_PWM_STEPS) ? NIXIE_PWM_STEPS : duty;
+}
+
+void nixie_set_brightness(uint8_t duty)
+{
+    for(uint8_t i=0;i<8;i++) nixie_set_duty(i, duty);
+}
+
+uint8_t nixie_get_duty(uint8_t pos){ return (pos < 8U) ? s_duty[pos] : 0U; }
+
+uint8_t nixie_acp_start(uint8_t cycles, uint16_t step_ms)
+{
+    if(!s_pwm_run || cycles == 0U) return 0U;
+    uint32_t slots = ((uint32_t)step_ms * NIXIE_PWM_SLOT_HZ) / 1000U;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    s_acp_slots = (slots == 0U) ? 1U : (uint16_t)slots;
+    s_acp_steps = (uint16_t)cycles * 10U;
+    s_acp_t = 0; s_acp_d = 0;
+    s_acp_on = 1U; s_dirty = 1U;
+#if NIXIE_USE_DMA
+    s_arm = NIXIE_ARM_NONE;
+#endif
+    __set_PRIMASK(pm);
+    return 1U;
+}
+
+uint8_t nixie_acp_active(void){ return s_acp_on; }
+
+void nixie_xfade(const uint16_t to_lr[8], uint8_t level)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    if(to_lr){ for(uint8_t k=0;k<8;k++) s_xf[k] = to_lr[k]; }
+    s_xf_lvl = (!to_lr) ? 0U : (level > NIXIE_PWM_STEPS) ? NIXIE_PWM_STEPS : level;
+    s_dirty  = 1U;
+#if NIXIE_USE_DMA
+    s_arm = NIXIE_ARM_NONE;
+#endif
+    __set_PRIMASK(pm);
+}
+
+void nixie_pwm_irq(void)
+{
+    if(!(TIM6->SR & TIM_SR_UIF)) return;
+    TIM6->SR = ~(uint32_t)TIM_SR_UIF;
+
+    if(++s_pwm_slot >= NIXIE_PWM_STEPS) s_pwm_slot = 0;
+
+    if(s_acp_on){
+        /* 巡回中は全桁フル輝度で 0..9 を順に点灯（桁ごとに1数字ずつずらす） */
+        uint8_t step = 0;
+        if(++s_acp_t >= s_acp_slots){
+            s_acp_t = 0; step = 1U;
+            if(++s_acp_d >= 10U) s_acp_d = 0;
+            if(--s_acp_steps == 0U){ s_acp_on = 0; s_dirty = 1U; }
+        }
+        if(s_acp_on && (step || s_dirty)){
+            uint16_t v[8];
+            for(uint8_t i=0;i<8;i++) v[i] = NIXIE_CODE((uint8_t)((s_acp_d + i) % 10U), 0, 0);
+            s_dirty = 0;
+            s_pwm_last = 0xFFU;
+            emit_frame(v, g_sr_enable);
+            return;
+        }
+        if(s_acp_on) return;
+    }
+
+    uint8_t mask = 0;
+    for(uint8_t i=0;i<8;i++){
+        uint8_t ph = (uint8_t)((s_pwm_slot + i * (NIXIE_PWM_STEPS / 8U)) % NIXIE_PWM_STEPS);
+        if(ph < s_duty[i]) mask |= (uint8_t)(0x80U >> i);   /* 左端 = bit7 */
+    }
+    uint8_t xf = (s_pwm_slot < s_xf_lvl) ? 1U : 0U;   /* クロスフェード：スロット単位で2枚を時分割 */
+    if(mask != s_pwm_last || xf != s_xf_last || s_dirty){
+        s_pwm_last = mask;
+        s_xf_last  = xf;
+        s_dirty = 0;
+        emit_frame(xf ? s_xf : s_cur, mask & g_sr_enable);
+    }
 }
 
 /* ===== ヘルパ ===== */
+uint16_t nixie_code(uint8_t digit, uint8_t dotL, uint8_t dotR){ return NIXIE_CODE(digit,dotL,dotR); }
 static inline uint16_t code_digit(uint8_t d){ return NIXIE_CODE(d,0,0); }
 static inline uint16_t code_dot_only(void){ return NIXIE_CODE(0xFF,1,0); }          /* 左ドット1桁 */
 static inline uint16_t code_sign_bothdots(void){ return NIXIE_CODE(0xFF,1,1); }     /* 負号（左右ドット） */
@@ -115,9 +489,8 @@ void nixie_show_digits_lr(uint8_t d0,uint8_t d1,uint8_t d2,uint8_t d3,
 }
 
 /* -- 内部：文字列8桁 → 表示コード -- */
-static void nixie_show_text8_core(const char *s8, uint8_t accept_leading_minus)
+static void text8_codes(const char *s8, uint8_t accept_leading_minus, uint16_t v[8])
 {
-    uint16_t v[8];
     for(int i=0;i<8;i++) v[i] = code_blank();
 
     int pos = 0;
@@ -137,6 +510,12 @@ static void nixie_show_text8_core(const char *s8, uint8_t accept_leading_minus)
             v[pos++] = code_blank();
         }
     }
+}
+
+static void nixie_show_text8_core(const char *s8, uint8_t accept_leading_minus)
+{
+    uint16_t v[8];
+    text8_codes(s8, accept_leading_minus, v);
     display8_codes_lr(v[0],v[1],v[2],v[3],v[4],v[5],v[6],v[7]);
 }
 
@@ -144,7 +523,28 @@ static void nixie_show_text8_core(const char *s8, uint8_t accept_leading_minus)
 void nixie_show_integer8_str(const char *s8){ nixie_show_text8_core(s8,1U); }
 void nixie_show_decimal_str(const char *s8){ nixie_show_text8_core(s8,1U); }
 
+void nixie_show_codes(const uint16_t codes_lr[8])
+{
+    display8_codes_lr(codes_lr[0],codes_lr[1],codes_lr[2],codes_lr[3],
+                      codes_lr[4],codes_lr[5],codes_lr[6],codes_lr[7]);
+}
+
+void nixie_get_codes(uint16_t codes_lr[8])
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    for(uint8_t k=0;k<8;k++) codes_lr[k] = s_cur[k];
+    __set_PRIMASK(pm);
+}
+
 void nixie_show_time_hms(uint8_t hh, uint8_t mm, uint8_t ss)
+{
+    uint16_t v[8];
+    nixie_time_codes(hh, mm, ss, v);
+    nixie_show_codes(v);
+}
+
+void nixie_time_codes(uint8_t hh, uint8_t mm, uint8_t ss, uint16_t codes_lr[8])
 {
     char buf[9];
     buf[0] = (char)('0' + ((hh/10)%10));
@@ -156,5 +556,5 @@ void nixie_show_time_hms(uint8_t hh, uint8_t mm, uint8_t ss)
     buf[6] = (char)('0' + ((ss/10)%10));
     buf[7] = (char)('0' + (ss%10));
     buf[8] = '\0';
-    nixie_show_text8_core(buf,0U);
+    text8_codes(buf, 0U, codes_lr);
 }
@@ -0,0 +1,127 @@
+#include "prof.h"
+
+#if PROF_ENABLE
+#include "telem.h"
+#include <string.h>
+
+static const char *const PROF_NAME[PROF_N] = {
+    "loop", "gps_poll", "nmea_sent", "nixie_emit", "anim_poll",
+    "usart1_isr", "dma1_ch5_isr", "tim6_isr", "tim3_isr", "dma1_ch3_isr",
+    "wake"
+};
+
+static prof_stat_t s_stat[PROF_N];
+static uint32_t    s_ovh = 0;           /* 空の BEGIN/END で数える分 [cycle] */
+
+void prof_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+    s_ovh = 0xFFFFFFFFU;
+    for(uint8_t i=0;i<8;i++){
+        uint32_t t0 = prof_now();
+        uint32_t d  = prof_now() - t0;
+        if(d < s_ovh) s_ovh = d;
+    }
+    prof_reset();
+}
+
+void prof_reset(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    memset(s_stat, 0, sizeof s_stat);
+    for(uint8_t i=0;i<PROF_N;i++) s_stat[i].min = 0xFFFFFFFFU;
+    __set_PRIMASK(pm);
+}
+
+void prof_add(prof_id_t id, uint32_t cyc)
+{
+    prof_stat_t *s = &s_stat[id];
+    cyc = (cyc > s_ovh) ? cyc - s_ovh : 0U;
+    uint32_t pm = __get_PRIMASK();          /* 本体と割込みの両方から来るプローブがある */
+    __disable_irq();
+    s->n++;
+    s->sum += cyc;
+    if(cyc < s->min) s->min = cyc;
+    if(cyc > s->max) s->max = cyc;
+    __set_PRIMASK(pm);
+}
+
+const char *prof_name(prof_id_t id){ return (id < PROF_N) ? PROF_NAME[id] : "?"; }
+
+void prof_get(prof_id_t id, prof_stat_t *out)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    *out = s_stat[id];
+    __set_PRIMASK(pm);
+}
+
+/* ==== 文字出力（printf を持ち込まない） ============================ */
+static char *put_s(char *p, const char *s, uint8_t w)
+{
+    uint8_t n = 0;
+    while(*s){ *p++ = *s++; n++; }
+    while(n++ < w) *p++ = ' ';
+    return p;
+}
+
+static char *put_u(char *p, uint32_t v, uint8_t w)   /* 右詰め */
+{
+    char t[10];
+    uint8_t n = 0;
+    do{ t[n++] = (char)('0' + v % 10U); v /= 10U; }while(v);
+    while(w-- > n) *p++ = ' ';
+    while(n) *p++ = t[--n];
+    return p;
+}
+
+/* テレメトリが同じ UART を DMA で使うときは、その枠に入れて送る */
+static void send(UART_HandleTypeDef *hu, const char *b, char *e)
+{
+#if TELEM_ENABLE
+    (void)hu;
+    (void)telem_text(b, (uint16_t)(e - b));
+#else
+    (void)HAL_UART_Transmit(hu, (const uint8_t*)b, (uint16_t)(e - b), 100U);
+#endif
+}
+
+/* 1行1プローブ。値はサイクル数、us 列は最大値を SYSCLK で割ったもの */
+void prof_dump(UART_HandleTypeDef *hu)
+{
+    char b[80], *p = b;
+    p = put_s(p, "probe", 14);
+    p = put_s(p, "        n     min    mean     max  max_us\r\n", 0);
+    send(hu, b, p);
+
+    const uint32_t mhz = SystemCoreClock / 1000000U;
+    for(uint8_t i=0;i<PROF_N;i++){
+        prof_stat_t s;
+        prof_get((prof_id_t)i, &s);
+        p = put_s(b, PROF_NAME[i], 14);
+        p = put_u(p, s.n, 9);
+        p = put_u(p, s.n ? s.min : 0U, 8);
+        p = put_u(p, s.n ? (uint32_t)(s.sum / s.n) : 0U, 8);
+        p = put_u(p, s.max, 8);
+        p = put_u(p, mhz ? s.max / mhz : 0U, 8);
+        *p++ = '\r'; *p++ = '\n';
+        send(hu, b, p);
+    }
+}
+
+/* 受信はレジスタを覗くだけ（割込みも HAL の受信状態も使わない） */
+void prof_console(UART_HandleTypeDef *hu)
+{
+    USART_TypeDef *u = hu->Instance;
+    if(u->ISR & USART_ISR_ORE) u->ICR = USART_ICR_ORECF;
+    if(!(u->ISR & USART_ISR_RXNE)) return;
+
+    char c = (char)u->RDR;
+    if(c == 'p' || c == 'P') prof_dump(hu);
+    else if(c == 'r' || c == 'R') prof_reset();
+}
+#endif /* PROF_ENABLE */
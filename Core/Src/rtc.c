@@ -0,0 +1,128 @@
+#include "rtc.h"
+
+#if RTC_ENABLE
+#include "civil.h"
+
+#define RTC_MAGIC  0x4E585254U          /* BKP0R：暦を書いた印（バックアップ領域の初期化で消える） */
+#define RTC_WAIT   100000U              /* 発振・フラグ待ちの上限 [回] */
+
+/* ==== レジスタ操作（ホストビルドでは hal_fake の RTC 模型に差し替わる） ==== */
+#ifndef RTC_HW_READ
+#if RTC_USE_LSE
+#define RTC_SEL       RCC_BDCR_RTCSEL_LSE
+#define RTC_PREDIV_S  255U              /* 32768 / 128 / 256 = 1Hz */
+#else
+#define RTC_SEL       RCC_BDCR_RTCSEL_LSI
+#define RTC_PREDIV_S  311U              /* 40000 / 128 / 312 ≒ 1Hz（LSI の個体差の方が大きい） */
+#endif
+#define RTC_PREDIV_A  127U
+
+static uint8_t s_run = 0;               /* 1=RTC が動いていて暦が読める */
+
+static uint8_t wait_set(volatile uint32_t *r, uint32_t bit)
+{
+    for(uint32_t n = 0; n < RTC_WAIT; n++){ if(*r & bit) return 1U; }
+    return 0U;
+}
+
+static uint32_t from_bcd(uint32_t v){ return (v >> 4) * 10U + (v & 0x0FU); }
+static uint32_t to_bcd(uint32_t v){ return ((v / 10U) << 4) | (v % 10U); }
+
+static void wp_off(void){ RTC->WPR = 0xCAU; RTC->WPR = 0x53U; }
+static void wp_on(void){ RTC->WPR = 0xFFU; }
+
+/* INIT モードに入る（暦と分周の書換えはこの間だけ） */
+static uint8_t init_enter(void)
+{
+    wp_off();
+    RTC->ISR |= RTC_ISR_INIT;
+    return wait_set(&RTC->ISR, RTC_ISR_INITF);
+}
+
+static void init_leave(void)
+{
+    RTC->ISR &= ~RTC_ISR_INIT;
+    wp_on();
+}
+
+static void hw_start(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    (void)RCC->APB1ENR;
+    PWR->CR |= PWR_CR_DBP;                  /* バックアップ領域の書込み許可 */
+
+    /* 別のクロックで動いていたら、選択を変えるためにバックアップ領域ごと初期化 */
+    if((RCC->BDCR & RCC_BDCR_RTCEN) && (RCC->BDCR & RCC_BDCR_RTCSEL) != RTC_SEL){
+        RCC->BDCR |= RCC_BDCR_BDRST;
+        RCC->BDCR &= ~RCC_BDCR_BDRST;
+    }
+#if RTC_USE_LSE
+    RCC->BDCR |= RCC_BDCR_LSEON;
+    if(!wait_set(&RCC->BDCR, RCC_BDCR_LSERDY)) return;      /* 水晶が載っていない */
+#else
+    RCC->CSR |= RCC_CSR_LSION;              /* LSI はシステムリセットで止まるので毎回起こす */
+    if(!wait_set(&RCC->CSR, RCC_CSR_LSIRDY)) return;
+#endif
+    if(!(RCC->BDCR & RCC_BDCR_RTCEN)){
+        RCC->BDCR |= RTC_SEL | RCC_BDCR_RTCEN;
+        if(init_enter()){
+            RTC->PRER = RTC_PREDIV_S;       /* 同期側、非同期側の順に別々に書く */
+            RTC->PRER = RTC_PREDIV_S | (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos);
+        }
+        init_leave();
+    }
+
+    /* リセット後は影レジスタの同期を待ってから読む */
+    wp_off();
+    RTC->ISR &= ~RTC_ISR_RSF;
+    wp_on();
+    s_run = wait_set(&RTC->ISR, RTC_ISR_RSF);
+}
+
+static uint8_t hw_read(int64_t *utc_s)
+{
+    if(!s_run || RTC->BKP0R != RTC_MAGIC || !(RTC->ISR & RTC_ISR_INITS)) return 0U;
+    uint32_t tr = RTC->TR;                  /* TR を読むと DR は同じ瞬間の値で止まる */
+    uint32_t dr = RTC->DR;
+    *utc_s = civil_epoch(2000 + (int)from_bcd((dr >> RTC_DR_YU_Pos) & 0xFFU),
+                         (int)from_bcd((dr >> RTC_DR_MU_Pos) & 0x1FU),
+                         (int)from_bcd((dr >> RTC_DR_DU_Pos) & 0x3FU),
+                         (int)from_bcd((tr >> RTC_TR_HU_Pos) & 0x3FU),
+                         (int)from_bcd((tr >> RTC_TR_MNU_Pos) & 0x7FU),
+                         (int)from_bcd((tr >> RTC_TR_SU_Pos) & 0x7FU));
+    return 1U;
+}
+
+static void hw_write(int64_t utc_s)
+{
+    if(!s_run || utc_s < 0) return;
+    int32_t days = (int32_t)(utc_s / 86400);
+    uint32_t sod = (uint32_t)(utc_s - (int64_t)days * 86400);
+    civil_t c;
+    civil_from_days(days, &c);
+    if(c.YYYY < 2000 || c.YYYY > 2099) return;
+
+    uint32_t tr = (to_bcd(sod / 3600U) << RTC_TR_HU_Pos) | (to_bcd((sod / 60U) % 60U) << RTC_TR_MNU_Pos)
+                | (to_bcd(sod % 60U) << RTC_TR_SU_Pos);
+    uint32_t dr = (to_bcd((uint32_t)(c.YYYY - 2000)) << RTC_DR_YU_Pos)
+                | ((uint32_t)(c.wday ? c.wday : 7U) << RTC_DR_WDU_Pos)      /* 1=月 … 7=日 */
+                | (to_bcd((uint32_t)c.MM) << RTC_DR_MU_Pos) | (to_bcd((uint32_t)c.DD) << RTC_DR_DU_Pos);
+    if(init_enter()){
+        RTC->TR = tr;
+        RTC->DR = dr;
+        RTC->BKP0R = RTC_MAGIC;
+    }
+    init_leave();
+}
+
+#define RTC_HW_START()    hw_start()
+#define RTC_HW_READ(t)    hw_read(t)
+#define RTC_HW_WRITE(t)   hw_write(t)
+#endif
+
+/* ==== API ============================================================ */
+void    rtc_init(void){ RTC_HW_START(); }
+uint8_t rtc_get(int64_t *utc_s){ return RTC_HW_READ(utc_s); }
+void    rtc_set(int64_t utc_s){ RTC_HW_WRITE(utc_s); }
+
+#endif /* RTC_ENABLE */
@@ -22,6 +22,10 @@
 #include "stm32f3xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "timekeep.h"
+#include "nixie.h"
+#include "prof.h"
+#include "telem.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,6 +59,7 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_usart1_rx;
 extern UART_HandleTypeDef huart1;
 /* USER CODE BEGIN EV */
 
@@ -240,17 +245,31 @@ void EXTI4_IRQHandler(void)
   /* USER CODE END EXTI4_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 channel5 global interrupt.
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 0 */
+  PROF_BEGIN(PROF_DMA1_CH5_ISR);
+  /* USER CODE END DMA1_Channel5_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  /* USER CODE BEGIN DMA1_Channel5_IRQn 1 */
+  PROF_END(PROF_DMA1_CH5_ISR);
+  /* USER CODE END DMA1_Channel5_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART1 global interrupt / USART1 wake-up interrupt through EXT line 25.
   */
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-
+  PROF_BEGIN(PROF_USART1_ISR);
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-
+  PROF_END(PROF_USART1_ISR);
   /* USER CODE END USART1_IRQn 1 */
 }
 
@@ -270,5 +289,46 @@ void EXTI15_10_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM3 global interrupt (PPS input capture).
+  */
+void TIM3_IRQHandler(void)
+{
+  PROF_BEGIN(PROF_TIM3_ISR);
+  tk_capture_irq();
+  PROF_END(PROF_TIM3_ISR);
+}
+
+/**
+  * @brief This function handles TIM6 global and DAC1 underrun interrupts (nixie refresh).
+  */
+void TIM6_DAC1_IRQHandler(void)
+{
+  PROF_BEGIN(PROF_TIM6_ISR);
+  nixie_pwm_irq();
+  PROF_END(PROF_TIM6_ISR);
+}
+
+#if NIXIE_USE_DMA
+/**
+  * @brief This function handles DMA1 channel3 global interrupt (nixie frame done).
+  */
+void DMA1_Channel3_IRQHandler(void)
+{
+  PROF_BEGIN(PROF_DMA1_CH3_ISR);
+  nixie_dma_irq();
+  PROF_END(PROF_DMA1_CH3_ISR);
+}
+#endif
+
+#if TELEM_ENABLE
+/**
+  * @brief This function handles DMA1 channel7 global interrupt (USART2 telemetry TX).
+  */
+void DMA1_Channel7_IRQHandler(void)
+{
+  telem_dma_irq();
+}
+#endif
 
 /* USER CODE END 1 */
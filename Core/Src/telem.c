@@ -0,0 +1,274 @@
+#include "telem.h"
+
+#if TELEM_ENABLE
+#include "gps.h"
+#include "timekeep.h"
+#include "nixie.h"
+#include "prof.h"
+#include "idle.h"
+#include "crc.h"
+#include <string.h>
+
+volatile uint32_t telem_frames = 0;
+volatile uint32_t telem_drops  = 0;
+
+/* 符号化後の最大長：type+seq+本文+CRC に COBS の先頭・254字ごとの1字と区切り */
+#define FRAME_RAW_MAX  (2U + TELEM_BODY_MAX + 2U)
+#define FRAME_ENC_MAX  (FRAME_RAW_MAX + FRAME_RAW_MAX / 254U + 2U)
+
+static UART_HandleTypeDef *s_hu = NULL;
+static uint8_t           s_tx[TELEM_TX_BUF];
+static volatile uint16_t s_tw = 0, s_tr = 0;   /* 書込み・送出済み位置（周回カウンタ） */
+static volatile uint16_t s_tx_len = 0;         /* DMA 送出中の長さ（0=停止） */
+static uint8_t           s_seq = 0;
+static uint32_t          s_last_tick = 0;
+static uint8_t           s_slow = 0;
+
+/* ==== 符号化 ========================================================= */
+/* COBS。区切りの 0x00 まで書いて長さを返す */
+static uint16_t cobs(const uint8_t *in, uint16_t n, uint8_t *out)
+{
+    uint16_t o = 1, code_at = 0;
+    uint8_t  code = 1;
+    for(uint16_t i=0;i<n;i++){
+        if(in[i] == 0U){
+            out[code_at] = code; code_at = o++; code = 1;
+        }else{
+            out[o++] = in[i];
+            if(++code == 0xFFU){ out[code_at] = code; code_at = o++; code = 1; }
+        }
+    }
+    out[code_at] = code;
+    out[o++] = 0U;
+    return o;
+}
+
+/* ==== DMA 送出 ======================================================= */
+/* 割込み禁止下で呼ぶ。リング末尾で折り返さない連続区間を1回分送る */
+static void tx_kick(void)
+{
+    if(s_tx_len) return;
+    uint16_t avail = (uint16_t)(s_tw - s_tr);
+    if(!avail) return;
+    uint16_t off = s_tr & (TELEM_TX_BUF - 1U);
+    uint16_t n   = (avail < TELEM_TX_BUF - off) ? avail : (uint16_t)(TELEM_TX_BUF - off);
+
+    DMA1_Channel7->CCR  &= ~DMA_CCR_EN;
+    DMA1->IFCR           = DMA_IFCR_CGIF7;
+    DMA1_Channel7->CMAR  = (uint32_t)(uintptr_t)&s_tx[off];
+    DMA1_Channel7->CNDTR = n;
+    s_tx_len = n;
+    DMA1_Channel7->CCR  |= DMA_CCR_EN;
+}
+
+void telem_dma_irq(void)
+{
+    if(!(DMA1->ISR & DMA_ISR_TCIF7)) return;
+    DMA1->IFCR = DMA_IFCR_CGIF7;
+    DMA1_Channel7->CCR &= ~DMA_CCR_EN;
+    s_tr = (uint16_t)(s_tr + s_tx_len);
+    s_tx_len = 0;
+    tx_kick();
+}
+
+void telem_init(UART_HandleTypeDef *hu)
+{
+    s_hu = hu;
+    s_tw = s_tr = 0; s_tx_len = 0; s_seq = 0;
+    s_last_tick = HAL_GetTick(); s_slow = 0;
+    telem_frames = telem_drops = 0;
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    DMA1_Channel7->CCR  = 0;
+    DMA1_Channel7->CPAR = (uint32_t)(uintptr_t)&hu->Instance->TDR;
+    DMA1_Channel7->CCR  = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE;   /* 8bit、優先度 低 */
+    hu->Instance->CR3  |= USART_CR3_DMAT;
+
+    HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 2, 0);   /* 表示リフレッシュより下 */
+    HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+}
+
+uint8_t telem_busy(void){ return s_tw != s_tr; }
+
+uint8_t telem_send(uint8_t type, const void *body, uint16_t n)
+{
+    if(!s_hu || n > TELEM_BODY_MAX) return 0U;
+
+    uint8_t raw[FRAME_RAW_MAX], enc[FRAME_ENC_MAX];
+    raw[0] = type;
+    raw[1] = s_seq;
+    if(n) memcpy(&raw[2], body, n);
+    uint16_t c = crc16_ccitt(raw, (uint16_t)(n + 2U));
+    raw[n + 2U] = (uint8_t)c;
+    raw[n + 3U] = (uint8_t)(c >> 8);
+    uint16_t len = cobs(raw, (uint16_t)(n + 4U), enc);
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    if((uint16_t)(TELEM_TX_BUF - (uint16_t)(s_tw - s_tr)) < len){
+        __set_PRIMASK(pm);
+        telem_drops++;
+        return 0U;
+    }
+    for(uint16_t i=0;i<len;i++) s_tx[(uint16_t)(s_tw + i) & (TELEM_TX_BUF - 1U)] = enc[i];
+    s_tw = (uint16_t)(s_tw + len);
+    s_seq++;
+    telem_frames++;
+    tx_kick();
+    __set_PRIMASK(pm);
+    return 1U;
+}
+
+uint8_t telem_text(const char *s, uint16_t n)
+{
+    if(!s_hu) return 0U;
+    if(n > TELEM_BODY_MAX) n = TELEM_BODY_MAX;
+    const uint16_t need = (uint16_t)(FRAME_ENC_MAX);
+    /* 送出中の区間が終わるまで s_tr は進まないので、リング1周分を送り切る時間まで待つ */
+    const uint32_t tmo = 10U + (TELEM_TX_BUF * 10000U) / s_hu->Init.BaudRate;
+    uint32_t t0 = HAL_GetTick();
+    while((uint16_t)(TELEM_TX_BUF - (uint16_t)(s_tw - s_tr)) < need){
+        if(HAL_GetTick() - t0 >= tmo) break;
+        __WFI();                                   /* DMA 完了割込みで起きる */
+    }
+    return telem_send(TM_TEXT, s, n);
+}
+
+/* ==== 本文の組立て =================================================== */
+static uint8_t *put8(uint8_t *p, uint8_t v){ *p++ = v; return p; }
+static uint8_t *put16(uint8_t *p, uint16_t v){ *p++ = (uint8_t)v; *p++ = (uint8_t)(v >> 8); return p; }
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    *p++ = (uint8_t)v; *p++ = (uint8_t)(v >> 8); *p++ = (uint8_t)(v >> 16); *p++ = (uint8_t)(v >> 24);
+    return p;
+}
+
+static void send_fix(void)
+{
+    gps_fix_t fx;
+    (void)gps_get_snapshot(&fx);
+    uint8_t b[47], *p = b;
+    p = put32(p, fx.gen);
+    p = put32(p, fx.tick);
+    p = put16(p, (uint16_t)fx.lat.deg);
+    p = put32(p, (uint32_t)fx.lat.umin);
+    p = put16(p, (uint16_t)fx.lon.deg);
+    p = put32(p, (uint32_t)fx.lon.umin);
+    p = put32(p, (uint32_t)fx.alt_mm);
+    p = put32(p, (uint32_t)fx.spd_mms);
+    p = put32(p, (uint32_t)fx.cog_cdeg);
+    p = put16(p, (uint16_t)fx.utc_YYYY);
+    p = put8(p, (uint8_t)fx.utc_MM);
+    p = put8(p, (uint8_t)fx.utc_DD);
+    p = put8(p, (uint8_t)fx.utc_hh);
+    p = put8(p, (uint8_t)fx.utc_mm);
+    p = put8(p, (uint8_t)fx.utc_ss);
+    p = put16(p, (uint16_t)fx.tz_min);
+    p = put8(p, (uint8_t)fx.fix_type);
+    p = put8(p, (uint8_t)fx.sat_used);
+    p = put8(p, (uint8_t)fx.sat_view);
+    p = put16(p, (uint16_t)fx.hdop_c);
+    p = put8(p, fx.upd);
+    (void)telem_send(TM_FIX, b, (uint16_t)(p - b));
+}
+
+static void send_gps(void)
+{
+    volatile uint32_t *const CNT[14] = {
+        &gps_rmc_ok, &gps_rmc_bad, &gps_gga_ok, &gps_gga_bad, &gps_zda_ok, &gps_zda_bad,
+        &gps_vtg_ok, &gps_vtg_bad, &gps_gsa_ok, &gps_gsa_bad, &gps_gsv_ok, &gps_gsv_bad,
+        &gps_gll_ok, &gps_gll_bad
+    };
+    uint8_t b[78], *p = b;
+    p = put32(p, gps_rx_bytes);
+    p = put32(p, gps_rx_lines);
+    p = put32(p, gps_rx_dropped);
+    p = put32(p, gps_rx_overflows);
+    p = put32(p, gps_rx_resync);
+    p = put16(p, gps_rx_hwm);
+    for(uint8_t i=0;i<14;i++) p = put32(p, *CNT[i]);
+    (void)telem_send(TM_GPS, b, (uint16_t)(p - b));
+}
+
+static void send_time(void)
+{
+    uint8_t b[35], *p = b;
+    p = put32(p, HAL_GetTick());
+    p = put8(p, (uint8_t)tk_state());
+    p = put32(p, (uint32_t)tk_utc_sod());
+    p = put32(p, tk_sub_us());
+    p = put32(p, (uint32_t)tk_freq_err_ppb());
+    p = put32(p, tk_pps_count);
+    p = put32(p, tk_pps_reject);
+    p = put32(p, tk_relabel);
+#if IDLE_ENABLE
+    p = put16(p, idle_busy_pm);
+    p = put32(p, idle_wakeups);
+#else
+    p = put16(p, 1000U);
+    p = put32(p, 0U);
+#endif
+    (void)telem_send(TM_TIME, b, (uint16_t)(p - b));
+}
+
+static void send_disp(uint8_t flags)
+{
+    uint16_t v[8];
+    nixie_get_codes(v);
+    uint8_t b[25], *p = b;
+    for(uint8_t i=0;i<8;i++) p = put16(p, v[i]);
+    for(uint8_t i=0;i<8;i++) p = put8(p, nixie_get_duty(i));
+    p = put8(p, flags);
+    (void)telem_send(TM_DISP, b, (uint16_t)(p - b));
+}
+
+static void send_nmea(void)
+{
+    char s[GPS_LAST_SENTENCE_MAX];    /* gps_poll_line() と同じ本体ループ側なので排他は不要 */
+    uint16_t n = 0;
+    while(n < GPS_LAST_SENTENCE_MAX && gps_last_sentence[n]){ s[n] = gps_last_sentence[n]; n++; }
+    if(n) (void)telem_send(TM_NMEA, s, n);
+}
+
+#if PROF_ENABLE
+/* 1回に1プローブずつ巡回（まとめて送ると送信リングを溢れる） */
+static void send_prof(void)
+{
+    static uint8_t i = 0;
+    prof_stat_t st;
+    prof_get((prof_id_t)i, &st);
+    uint8_t b[TELEM_BODY_MAX], *p = b;
+    p = put8(p, i);
+    p = put32(p, st.n);
+    p = put32(p, st.n ? st.min : 0U);
+    p = put32(p, st.n ? (uint32_t)(st.sum / st.n) : 0U);
+    p = put32(p, st.max);
+    const char *nm = prof_name((prof_id_t)i);
+    while(*nm && p < b + sizeof b) *p++ = (uint8_t)*nm++;
+    (void)telem_send(TM_PROF, b, (uint16_t)(p - b));
+    if(++i >= PROF_N) i = 0;
+}
+#endif
+
+/* 秒境界（同期前は 1000ms ごと）に FIX/TIME/DISP（と計測表の1行）、
+   TELEM_SLOW_EVERY_S 秒ごとに受信カウンタと直近の文 */
+void telem_poll(uint8_t flip, uint8_t disp_flags)
+{
+    if(!s_hu) return;
+    uint32_t now = HAL_GetTick();
+    if(!flip && (now - s_last_tick) < 1000U) return;
+    s_last_tick = now;
+
+    send_fix();
+    send_time();
+    send_disp(disp_flags);
+#if PROF_ENABLE
+    send_prof();
+#endif
+    if(++s_slow >= TELEM_SLOW_EVERY_S){
+        s_slow = 0;
+        send_gps();
+        send_nmea();
+    }
+}
+#endif /* TELEM_ENABLE */
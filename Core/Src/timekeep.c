@@ -0,0 +1,264 @@
+#include "timekeep.h"
+#include "idle.h"
+
+/* ==== パラメータ ===================================================== */
+/* 周波数推定の IIR 時定数 [PPS数]（2の冪） */
+#ifndef TK_FREQ_AVG
+#define TK_FREQ_AVG 8
+#endif
+/* PPS 周期の許容ずれ。推定が収束する前は HSI の素の誤差(±1%)を見込む */
+#ifndef TK_PPS_TOL_PPM
+#define TK_PPS_TOL_PPM 200
+#endif
+#define TK_PPS_TOL_COARSE_PPM 20000
+/* PPS なし運用で NMEA 文頭が秒境界から遅れる量 [ms]（受信機依存） */
+#ifndef TK_NMEA_LAT_MS
+#define TK_NMEA_LAT_MS 0
+#endif
+/* 推定時刻（tk_seed）から最初のラベルへ跳ばずに寄せる最大の差 [秒]。越えたら跳ぶ */
+#ifndef TK_SLEW_MAX_S
+#define TK_SLEW_MAX_S 10
+#endif
+
+#define TK_SOD_DAY 86400
+
+/* ==== 状態 =========================================================== */
+/* s_edge/s_sod は「直近の秒境界の TIM2 値と、その時点の UTC 通日秒」。
+   PPS 割込みと本体（tk_poll/tk_on_fix）の両方が書くので、本体側は割込み禁止で触る */
+static uint32_t          s_nom = 0;         /* 公称タイマクロック [ticks/s] */
+static volatile int32_t  s_err_q8 = 0;      /* (実周期−公称)×256 の移動平均 */
+static volatile uint8_t  s_freq_n = 0;      /* 推定に使った PPS 数（飽和） */
+static volatile uint32_t s_pps_ts = 0;      /* 直近の PPS 捕捉値 */
+static volatile uint8_t  s_pps_ok = 0;      /* 1=s_pps_ts 有効 */
+static volatile uint32_t s_edge = 0;
+static volatile int32_t  s_sod = -1;
+static volatile uint8_t  s_flip = 0;        /* 未処理の秒境界 */
+static volatile uint8_t  s_state = TK_UNSYNC;
+static volatile int32_t  s_slew = 0;        /* 表示の遅れ [秒]（表示 = s_sod − s_slew）。0 へ寄せる */
+static volatile uint8_t  s_half = 0;        /* この秒の半秒で1つ進めた */
+static tk_pps_hook_t     s_hook = NULL;
+static uint32_t          s_win_lo = 0;      /* 次の PPS の窓：直近の PPS から [lo, lo+w] tick */
+static uint32_t          s_win_w  = 0;
+
+volatile uint32_t tk_pps_count  = 0;
+volatile uint32_t tk_pps_reject = 0;
+volatile uint32_t tk_relabel    = 0;
+
+/* ==== 内部 =========================================================== */
+static inline uint32_t tk_now(void){ return TIM2->CNT; }
+static inline uint32_t tk_tps(void){ return (uint32_t)((int32_t)s_nom + s_err_q8 / 256); }
+static inline int32_t  sod_add(int32_t s, int32_t n){ s += n; while(s >= TK_SOD_DAY) s -= TK_SOD_DAY; return s; }
+
+/* 秒境界ごと。進みすぎ（s_slew<0）は2秒に1度、表示の秒を据え置いて詰める */
+static inline void slew_sec(void){ s_half = 0; if(s_slew < 0 && (s_sod & 1)) s_slew++; }
+
+/* 推定時刻から最初のラベルへ。差が小さければ表示側に残して寄せる */
+static void slew_from_estimate(int32_t sod)
+{
+    int32_t d = sod - s_sod;
+    if(d >  TK_SOD_DAY / 2) d -= TK_SOD_DAY;
+    if(d < -TK_SOD_DAY / 2) d += TK_SOD_DAY;
+    s_slew = (d >= -TK_SLEW_MAX_S && d <= TK_SLEW_MAX_S) ? d : 0;
+    s_half = 0;
+}
+
+/* PPS 1回分。前回 PPS から 1秒±許容 なら周波数推定に使い、秒境界として採用。
+   外れた（グリッチ・位相跳び）ものは候補として保持し、次の PPS で確かめる */
+static void pps_edge(uint32_t ts)
+{
+    uint32_t tps = tk_tps();
+    uint32_t tol = (s_freq_n >= TK_FREQ_AVG) ? tps / (1000000U / TK_PPS_TOL_PPM)
+                                             : s_nom / (1000000U / TK_PPS_TOL_COARSE_PPM);
+    uint32_t per = ts - s_pps_ts;
+    uint8_t  good = s_pps_ok && ((per > tps) ? per - tps : tps - per) <= tol;
+
+    if(s_pps_ok && !good) tk_pps_reject++;
+    s_pps_ts = ts;
+    s_pps_ok = 1;
+    if(!good) return;
+    s_win_lo = tps - tol;
+    s_win_w  = 2U * tol;
+
+    int32_t e = (int32_t)(per - s_nom);
+    if(s_freq_n == 0U) s_err_q8 = e * 256;              /* 初回は実測値で初期化 */
+    else               s_err_q8 += (e * 256 - s_err_q8) / TK_FREQ_AVG;
+    if(s_freq_n < 255U) s_freq_n++;
+    tk_pps_count++;
+    if(s_state == TK_ESTIMATE) return;                  /* ラベルが来るまでは推定の秒境界のまま */
+
+    if(s_sod >= 0){
+        /* 通常は1秒。ホールドオーバで外挿済みの秒があれば、その分は数えない */
+        uint32_t n = (ts - s_edge + tps / 2U) / tps;
+        if(n > 0U){ s_sod = sod_add(s_sod, (int32_t)n); s_flip = 1; slew_sec(); }
+    }
+    s_edge  = ts;
+    s_state = (s_sod >= 0) ? TK_PPS : TK_UNSYNC;
+}
+
+/* ==== API ============================================================ */
+void tk_init(void)
+{
+    /* TIM2/TIM3 は APB1。APB1 分周が1以外ならタイマクロックは2倍 */
+    s_nom = HAL_RCC_GetPCLK1Freq();
+    if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) s_nom *= 2U;
+    s_err_q8 = 0; s_freq_n = 0;
+    s_pps_ok = 0; s_sod = -1; s_flip = 0; s_state = TK_UNSYNC;
+    s_slew = 0; s_half = 0;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    /* PB5 を EXTI から TIM3_CH2 (AF2) へ付け替え */
+    GPIO_InitTypeDef gi = {0};
+    HAL_GPIO_DeInit(PPS_GPIO_Port, PPS_Pin);
+    gi.Pin       = PPS_Pin;
+    gi.Mode      = GPIO_MODE_AF_PP;
+    gi.Pull      = GPIO_PULLUP;
+    gi.Speed     = GPIO_SPEED_FREQ_LOW;
+    gi.Alternate = GPIO_AF2_TIM3;
+    HAL_GPIO_Init(PPS_GPIO_Port, &gi);
+
+    /* TIM2: 32bit フリーラン（時間軸） */
+    TIM2->CR1 = 0;
+    TIM2->PSC = 0;
+    TIM2->ARR = 0xFFFFFFFFU;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CR1 = TIM_CR1_CEN;
+
+    /* TIM3: 16bit フリーラン、CH2 で PPS 立下りを捕捉（fCK/8 のデジタルフィルタ） */
+    TIM3->CR1   = 0;
+    TIM3->PSC   = 0;
+    TIM3->ARR   = 0xFFFFU;
+    TIM3->CCMR1 = TIM_CCMR1_CC2S_0 | (3U << TIM_CCMR1_IC2F_Pos);
+    TIM3->CCER  = TIM_CCER_CC2E | TIM_CCER_CC2P;
+    TIM3->EGR   = TIM_EGR_UG;
+    TIM3->SR    = 0;
+    TIM3->DIER  = TIM_DIER_CC2IE;
+    TIM3->CR1   = TIM_CR1_CEN;
+
+    HAL_NVIC_SetPriority(TIM3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+/* TIM3 は16bitなので、捕捉からの経過（TIM3 上で測る）を TIM2 の現在値から
+   引いて 32bit の時間軸へ載せる。割込み遅延が 65536 tick(約2ms) 未満なら厳密 */
+void tk_capture_irq(void)
+{
+    uint32_t sr = TIM3->SR;
+    TIM3->SR = ~(uint32_t)(TIM_SR_CC2IF | TIM_SR_CC2OF);
+    if(!(sr & TIM_SR_CC2IF)) return;
+
+    uint16_t c3 = (uint16_t)TIM3->CCR2;
+    uint16_t n3 = (uint16_t)TIM3->CNT;
+    uint32_t n2 = tk_now();
+    uint32_t ts = n2 - (uint16_t)(n3 - c3);
+    if(s_hook && s_state == TK_PPS && (ts - s_pps_ts) - s_win_lo <= s_win_w) s_hook();
+    pps_edge(ts);
+    idle_event();                 /* 秒の切替を待たせない */
+}
+
+/* 時刻付きの文が届いたら、1秒以内の PPS があればそれにラベルを付ける。
+   PPS が無ければ（または古ければ）到着時刻を秒境界とする */
+void tk_on_fix(const gps_fix_t *fx)
+{
+    if(fx->utc_hh < 0 || fx->utc_mm < 0 || fx->utc_ss < 0) return;
+    int32_t sod = sod_add((int32_t)fx->utc_hh*3600 + fx->utc_mm*60 + fx->utc_ss, 0);
+#if TK_NMEA_LABELS_NEXT_PPS
+    sod = sod_add(sod, TK_SOD_DAY - 1);
+#endif
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = tk_now();
+    uint32_t tps = tk_tps();
+
+    if(s_state == TK_ESTIMATE){ slew_from_estimate(sod); s_state = TK_UNSYNC; }
+    if(s_pps_ok && (now - s_pps_ts) < tps){
+        if(s_state == TK_PPS && s_edge == s_pps_ts){
+            if(s_sod != sod){ s_sod = sod; s_flip = 1; tk_relabel++; }
+        }else if(s_state != TK_PPS){
+            /* 最初の PPS、または喪失からの復帰 */
+            s_edge = s_pps_ts; s_sod = sod; s_flip = 1;
+            s_state = TK_PPS;
+        }
+    }else if(s_state == TK_HOLDOVER){
+        if(s_sod != sod){ s_sod = sod; s_flip = 1; tk_relabel++; }   /* 位相は外挿を信じる */
+    }else if(s_state != TK_PPS){
+        if(s_sod != sod){ s_sod = sod; s_flip = 1; }
+        s_edge  = now - (uint32_t)(((uint64_t)tps * TK_NMEA_LAT_MS) / 1000U);
+        s_state = TK_NMEA;
+    }
+    __set_PRIMASK(pm);
+}
+
+/* 本体ループから頻繁に呼ぶ。PPS が 1.5秒来なければホールドオーバへ移り、
+   推定周波数で秒境界を外挿する。表示が遅れていれば半秒の所でも1つ進める */
+uint8_t tk_poll(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    if(s_sod >= 0){
+        uint32_t now = tk_now();
+        uint32_t tps = tk_tps();
+        if(s_state == TK_PPS && (now - s_edge) > tps + tps / 2U) s_state = TK_HOLDOVER;
+        if(s_state != TK_PPS){
+            while((now - s_edge) >= tps){ s_edge += tps; s_sod = sod_add(s_sod, 1); s_flip = 1; slew_sec(); }
+        }
+        if(s_slew > 0 && !s_half && (now - s_edge) >= tps / 2U && (now - s_edge) < tps){
+            s_half = 1U; s_slew--; s_flip = 1;
+        }
+    }
+    uint8_t f = s_flip;
+    s_flip = 0;
+    __set_PRIMASK(pm);
+    return f;
+}
+
+/* 起動時の推定時刻。GPS の時刻が先に来ていれば何もしない */
+void tk_seed(int64_t utc_s)
+{
+    if(utc_s < 0) return;
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    if(s_sod < 0){
+        s_sod   = (int32_t)(utc_s % TK_SOD_DAY);
+        s_edge  = tk_now();
+        s_slew  = 0;
+        s_flip  = 1;
+        s_state = TK_ESTIMATE;
+    }
+    __set_PRIMASK(pm);
+}
+
+void tk_set_pps_hook(tk_pps_hook_t fn){ s_hook = fn; }
+
+int32_t tk_utc_sod(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    int32_t s = s_sod, w = s_slew;
+    __set_PRIMASK(pm);
+    return (s < 0) ? -1 : sod_add(s, TK_SOD_DAY - w);
+}
+
+uint32_t tk_sub_us(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t dt  = tk_now() - s_edge;
+    uint32_t tps = tk_tps();
+    __set_PRIMASK(pm);
+    if(s_sod < 0) return 0U;
+    uint64_t us = ((uint64_t)dt * 1000000U) / tps;
+    return (us > 999999U) ? 999999U : (uint32_t)us;
+}
+
+tk_state_t tk_state(void){ return (tk_state_t)s_state; }
+
+uint8_t tk_unsynced(void){ return (uint8_t)(s_state == TK_ESTIMATE || s_slew != 0); }
+
+int32_t tk_freq_err_ppb(void)
+{
+    if(s_freq_n == 0U || s_nom == 0U) return 0;
+    return (int32_t)(((int64_t)s_err_q8 * 1000000000LL) / ((int64_t)s_nom * 256));
+}
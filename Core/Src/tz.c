@@ -0,0 +1,106 @@
+#include "tz.h"
+#include "civil.h"
+
+static tz_ctx_t s_tz = { 0, TZ_NONE, 0, 0, 0, TZ_NONE, 0, 0, 0 };
+
+static int32_t floor_div(int32_t a, int32_t b){ return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+
+uint8_t tz_lookup(int32_t lat_cdeg, int32_t lon_cdeg)
+{
+    for(uint16_t i = 0; i < TZ_N_BOXES; i++){
+        const tz_box_t *b = &TZ_BOXES[i];
+        if(lat_cdeg >= b->lat0 && lat_cdeg <= b->lat1 && lon_cdeg >= b->lon0 && lon_cdeg <= b->lon1) return b->rule;
+    }
+    return TZ_NONE;
+}
+
+void tz_ctx_init(tz_ctx_t *z)
+{
+    z->have = 0; z->rule = TZ_NONE; z->naut = 0;
+    z->lat = z->lon = 0;
+    z->c_rule = TZ_NONE; z->c_year = 0; z->c_start = z->c_end = 0;
+}
+
+void tz_ctx_update(tz_ctx_t *z, int32_t lat_cdeg, int32_t lon_cdeg)
+{
+    int32_t dlat = lat_cdeg - z->lat, dlon = lon_cdeg - z->lon;
+    if(dlat < 0) dlat = -dlat;
+    if(dlon < 0) dlon = -dlon;
+    if(z->have && dlat + dlon < TZ_MOVE_CDEG) return;
+
+    z->have = 1U; z->lat = lat_cdeg; z->lon = lon_cdeg;
+    z->rule = tz_lookup(lat_cdeg, lon_cdeg);
+
+    int32_t n = floor_div(lon_cdeg + 750, 1500);      /* 経度15度ごと、中央で丸め */
+    if(n < -12) n = -12;
+    if(n >  12) n =  12;
+    z->naut = (int16_t)(n * 60);
+}
+
+/* m月第n週のw曜日（5=最終週）の現地 min 分 → UTC */
+int64_t tz_when_utc(const tz_when_t *w, int year, int16_t off_min)
+{
+    int32_t d1 = civil_to_days(year, w->mon, 1);
+    int32_t d  = d1 + (int32_t)((w->wday + 7U - civil_wday(d1)) % 7U) + (w->week - 1) * 7;
+    if(d >= d1 + civil_dim(year, w->mon)) d -= 7;
+    return (int64_t)d * 86400 + (int32_t)(w->min - off_min) * 60;
+}
+
+/* 標準時で数えた年 */
+static int32_t std_year(const tz_rule_t *r, int64_t utc_s)
+{
+    int64_t t = utc_s + (int64_t)r->std_min * 60;
+    int64_t days = t / 86400;
+    if(t - days * 86400 < 0) days--;
+    civil_t c;
+    civil_from_days((int32_t)days, &c);
+    return c.YYYY;
+}
+
+/* 南半球は start > end（年を跨いで夏時間） */
+static int16_t pick(const tz_rule_t *r, int64_t t, int64_t start, int64_t end)
+{
+    uint8_t dst = (start < end) ? (t >= start && t < end) : (t >= start || t < end);
+    return dst ? r->dst_min : r->std_min;
+}
+
+int16_t tz_rule_offset(uint8_t rule, int64_t utc_s)
+{
+    if(rule >= TZ_N_RULES) return 0;
+    const tz_rule_t *r = &TZ_RULES[rule];
+    if(!r->start.mon) return r->std_min;
+    int32_t y = std_year(r, utc_s);
+    return pick(r, utc_s, tz_when_utc(&r->start, y, r->std_min), tz_when_utc(&r->end, y, r->dst_min));
+}
+
+int16_t tz_ctx_offset(tz_ctx_t *z, int64_t utc_s)
+{
+    if(z->rule == TZ_NONE) return z->naut;
+    const tz_rule_t *r = &TZ_RULES[z->rule];
+    if(!r->start.mon) return r->std_min;
+
+    int32_t y = std_year(r, utc_s);
+    if(z->c_rule != z->rule || z->c_year != y){
+        z->c_start = tz_when_utc(&r->start, y, r->std_min);
+        z->c_end   = tz_when_utc(&r->end,   y, r->dst_min);
+        z->c_rule = z->rule; z->c_year = y;
+    }
+    return pick(r, utc_s, z->c_start, z->c_end);
+}
+
+int16_t tz_ctx_std_offset(const tz_ctx_t *z){ return (z->rule == TZ_NONE) ? z->naut : TZ_RULES[z->rule].std_min; }
+
+tz_ctx_t *tz_default(void){ return &s_tz; }
+
+void    tz_update(int32_t lat_cdeg, int32_t lon_cdeg){ tz_ctx_update(&s_tz, lat_cdeg, lon_cdeg); }
+int16_t tz_offset(int64_t utc_s){ return tz_ctx_offset(&s_tz, utc_s); }
+int16_t tz_std_offset(void){ return tz_ctx_std_offset(&s_tz); }
+uint8_t tz_rule(void){ return s_tz.rule; }
+
+const char *tz_name(void)
+{
+#if TZ_WITH_NAMES
+    if(s_tz.rule != TZ_NONE) return TZ_NAMES[s_tz.rule];
+#endif
+    return "";
+}
@@ -0,0 +1,329 @@
+/* 生成ファイル（Host/tools/tzgen.py、tzdata 2025b）。手で直さず tz_regions.txt を直して再生成する */
+#include "tz.h"
+
+/* 標準時差・夏時間の時差 [分、東+]、夏時間の始まり・終わり {月, 第n週(5=最終), 曜日(0=日), 現地時刻[分]} */
+const tz_rule_t TZ_RULES[] = {
+    {  -60,    0, { 3,5,0,    0 }, {10,5,0,   60 } },   /*  0 Atlantic/Azores        <-01>1<+00>,M3.5.0/0,M10.5.0/1 */
+    {    0,   60, { 3,5,0,   60 }, {10,5,0,  120 } },   /*  1 Atlantic/Madeira       WET0WEST,M3.5.0/1,M10.5.0 */
+    {  -60,  -60, { 0,0,0,    0 }, { 0,0,0,    0 } },   /*  2 Atlantic/Cape_Verde    <-01>1 */
+    {    0,    0, { 0,0,0,    0 }, { 0,0,0,    0 } },   /*  3 Africa/Abidjan         GMT0 */
+    { -240, -180, { 3,2,0,  120 }, {11,1,0,  120 } },   /*  4 Atlantic/Bermuda       AST4ADT,M3.2.0,M11.1.0 */
+    {   60,    0, {10,5,0,  120 }, { 3,5,0,   60 } },   /*  5 Europe/Dublin          IST-1GMT0,M10.5.0,M3.5.0/1 */
+    {   60,   60, { 0,0,0,    0 }, { 0,0,0,    0 } },   /*  6 Africa/Tunis           CET-1 */
+    {   60,  120, { 3,5,0,  120 }, {10,5,0,  180 } },   /*  7 Europe/Oslo            CET-1CEST,M3.5.0,M10.5.0/3 */
+    {  120,  120, { 0,0,0,    0 }, { 0,0,0,    0 } },   /*  8 Africa/Tripoli         EET-2 */
+    {  120,  180, { 3,5,0,  180 }, {10,5,0,  240 } },   /*  9 Europe/Helsinki        EET-2EEST,M3.5.0/3,M10.5.0/4 */
+    {  120,  180, { 3,5,0,  120 }, {10,5,0,  180 } },   /* 10 Europe/Chisinau        EET-2EEST,M3.5.0,M10.5.0/3 */
+    {  180,  180, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 11 Europe/Istanbul        MSK-3 */
+    {  120,  180, { 3,5,0,    0 }, {10,5,0,    0 } },   /* 12 Asia/Beirut            EET-2EEST,M3.5.0/0,M10.5.0/0 */
+    {  120,  180, { 3,4,4, 1560 }, {10,5,0,  120 } },   /* 13 Asia/Jerusalem         IST-2IDT,M3.4.4/26,M10.5.0 */
+    {  120,  180, { 4,5,5,    0 }, {10,5,4, 1440 } },   /* 14 Africa/Cairo           EET-2EEST,M4.5.5/0,M10.5.4/24 */
+    {  240,  240, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 15 Europe/Samara          <+04>-4 */
+    {  210,  210, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 16 Asia/Tehran            <+0330>-3:30 */
+    {  360,  360, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 17 Asia/Bishkek           <+06>-6 */
+    {  300,  300, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 18 Asia/Karachi           <+05>-5 */
+    {  345,  345, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 19 Asia/Kathmandu         <+0545>-5:45 */
+    {  420,  420, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 20 Asia/Bangkok           <+07>-7 */
+    {  390,  390, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 21 Asia/Yangon            <+0630>-6:30 */
+    {  330,  330, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 22 Asia/Kolkata           IST-5:30 */
+    {  270,  270, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 23 Asia/Kabul             <+0430>-4:30 */
+    {  480,  480, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 24 Asia/Shanghai          <+08>-8 */
+    {  540,  540, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 25 Asia/Tokyo             JST-9 */
+    {  600,  600, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 26 Asia/Vladivostok       <+10>-10 */
+    {  660,  660, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 27 Asia/Sakhalin          <+11>-11 */
+    {  720,  720, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 28 Asia/Anadyr            <+12>-12 */
+    {  570,  570, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 29 Australia/Darwin       ACST-9:30 */
+    {  570,  630, {10,1,0,  120 }, { 4,1,0,  180 } },   /* 30 Australia/Adelaide     ACST-9:30ACDT,M10.1.0,M4.1.0/3 */
+    {  600,  660, {10,1,0,  120 }, { 4,1,0,  180 } },   /* 31 Australia/Sydney       AEST-10AEDT,M10.1.0,M4.1.0/3 */
+    {  720,  780, { 9,5,0,  120 }, { 4,1,0,  180 } },   /* 32 Pacific/Auckland       NZST-12NZDT,M9.5.0,M4.1.0/3 */
+    {  780,  780, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 33 Pacific/Tongatapu      <+13>-13 */
+    { -600, -600, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 34 Pacific/Tahiti         <-10>10 */
+    { -210, -150, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 35 America/St_Johns       NST3:30NDT,M3.2.0,M11.1.0 */
+    { -120,  -60, { 3,5,0,  -60 }, {10,5,0,    0 } },   /* 36 America/Nuuk           <-02>2<-01>,M3.5.0/-1,M10.5.0/0 */
+    { -420, -420, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 37 America/Mazatlan       MST7 */
+    { -540, -480, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 38 America/Anchorage      AKST9AKDT,M3.2.0,M11.1.0 */
+    { -480, -420, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 39 America/Los_Angeles    PST8PDT,M3.2.0,M11.1.0 */
+    { -420, -360, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 40 America/Denver         MST7MDT,M3.2.0,M11.1.0 */
+    { -360, -360, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 41 America/Regina         CST6 */
+    { -300, -240, { 3,2,0,    0 }, {11,1,0,   60 } },   /* 42 America/Havana         CST5CDT,M3.2.0/0,M11.1.0/1 */
+    { -300, -240, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 43 America/New_York       EST5EDT,M3.2.0,M11.1.0 */
+    { -360, -300, { 3,2,0,  120 }, {11,1,0,  120 } },   /* 44 America/Winnipeg       CST6CDT,M3.2.0,M11.1.0 */
+    { -240, -240, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 45 America/Caracas        AST4 */
+    { -300, -300, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 46 America/Jamaica        EST5 */
+    { -240, -180, { 9,1,6, 1440 }, { 4,1,6, 1440 } },   /* 47 America/Santiago       <-04>4<-03>,M9.1.6/24,M4.1.6/24 */
+    { -180, -180, { 0,0,0,    0 }, { 0,0,0,    0 } },   /* 48 America/Punta_Arenas   <-03>3 */
+};
+
+#if TZ_WITH_NAMES
+const char *const TZ_NAMES[] = {
+    "Atlantic/Azores",
+    "Atlantic/Madeira",
+    "Atlantic/Cape_Verde",
+    "Africa/Abidjan",
+    "Atlantic/Bermuda",
+    "Europe/Dublin",
+    "Africa/Tunis",
+    "Europe/Oslo",
+    "Africa/Tripoli",
+    "Europe/Helsinki",
+    "Europe/Chisinau",
+    "Europe/Istanbul",
+    "Asia/Beirut",
+    "Asia/Jerusalem",
+    "Africa/Cairo",
+    "Europe/Samara",
+    "Asia/Tehran",
+    "Asia/Bishkek",
+    "Asia/Karachi",
+    "Asia/Kathmandu",
+    "Asia/Bangkok",
+    "Asia/Yangon",
+    "Asia/Kolkata",
+    "Asia/Kabul",
+    "Asia/Shanghai",
+    "Asia/Tokyo",
+    "Asia/Vladivostok",
+    "Asia/Sakhalin",
+    "Asia/Anadyr",
+    "Australia/Darwin",
+    "Australia/Adelaide",
+    "Australia/Sydney",
+    "Pacific/Auckland",
+    "Pacific/Tongatapu",
+    "Pacific/Tahiti",
+    "America/St_Johns",
+    "America/Nuuk",
+    "America/Mazatlan",
+    "America/Anchorage",
+    "America/Los_Angeles",
+    "America/Denver",
+    "America/Regina",
+    "America/Havana",
+    "America/New_York",
+    "America/Winnipeg",
+    "America/Caracas",
+    "America/Jamaica",
+    "America/Santiago",
+    "America/Punta_Arenas",
+};
+#endif
+
+/* 南端, 北端, 西端, 東端 [0.01度], 規則番号。先頭から照合する */
+const tz_box_t TZ_BOXES[] = {
+    {   3680,   3980,  -3150,  -2480,   0 },   /* Atlantic/Azores */
+    {   3230,   3320,  -1750,  -1620,   1 },   /* Atlantic/Madeira */
+    {   2750,   2950,  -1830,  -1330,   1 },   /* Atlantic/Canary */
+    {   1470,   1730,  -2550,  -2260,   2 },   /* Atlantic/Cape_Verde */
+    {   6130,   6250,   -780,   -620,   1 },   /* Atlantic/Faroe */
+    {   6320,   6660,  -2460,  -1340,   3 },   /* Atlantic/Reykjavik */
+    {   3220,   3250,  -6500,  -6460,   4 },   /* Atlantic/Bermuda */
+    {   3690,   4220,   -960,   -620,   1 },   /* Europe/Lisbon */
+    {   5140,   5540,  -1060,   -540,   5 },   /* Europe/Dublin */
+    {   4980,   6100,   -820,    180,   1 },   /* Europe/London */
+    {   3200,   3740,    750,   1155,   6 },   /* Africa/Tunis */
+    {   3020,   3200,    750,   1020,   6 },   /* Africa/Tunis */
+    {   3600,   3710,   -160,    860,   6 },   /* Africa/Algiers */
+    {   3590,   4380,   -940,    440,   7 },   /* Europe/Madrid */
+    {   5430,   5530,   1960,   2290,   8 },   /* Europe/Kaliningrad */
+    {   5390,   5650,   2090,   2690,   9 },   /* Europe/Vilnius */
+    {   5560,   5810,   2090,   2830,   9 },   /* Europe/Riga */
+    {   5750,   5980,   2170,   2830,   9 },   /* Europe/Tallinn */
+    {   5530,   6350,   1090,   2030,   7 },   /* Europe/Stockholm */
+    {   6350,   6910,   1400,   2420,   7 },   /* Europe/Stockholm */
+    {   5980,   6100,   2050,   2790,   9 },   /* Europe/Helsinki */
+    {   6100,   6200,   2050,   2950,   9 },   /* Europe/Helsinki */
+    {   6200,   6900,   2050,   3060,   9 },   /* Europe/Helsinki */
+    {   6900,   7010,   2560,   2900,   9 },   /* Europe/Helsinki */
+    {   5790,   6350,    450,   1290,   7 },   /* Europe/Oslo */
+    {   6350,   6950,    900,   2050,   7 },   /* Europe/Oslo */
+    {   6900,   7120,   1500,   3110,   7 },   /* Europe/Oslo */
+    {   3450,   3580,   3220,   3460,   9 },   /* Asia/Nicosia */
+    {   3480,   4060,   2000,   2610,   9 },   /* Europe/Athens */
+    {   4060,   4180,   2270,   2660,   9 },   /* Europe/Athens */
+    {   3580,   3650,   2760,   2830,   9 },   /* Europe/Athens */
+    {   4120,   4420,   2240,   2870,   9 },   /* Europe/Sofia */
+    {   4540,   4850,   2760,   3020,  10 },   /* Europe/Chisinau */
+    {   4400,   4830,   2100,   3000,   9 },   /* Europe/Bucharest */
+    {   4360,   4400,   2250,   2860,   9 },   /* Europe/Bucharest */
+    {   4430,   4600,   3240,   3670,  11 },   /* Europe/Simferopol */
+    {   4430,   5240,   2210,   3700,   9 },   /* Europe/Kyiv */
+    {   4780,   5050,   3700,   4020,   9 },   /* Europe/Kyiv */
+    {   5120,   5620,   2360,   3280,  11 },   /* Europe/Minsk */
+    {   3580,   5510,   -520,   2420,   7 },   /* Europe/Berlin */
+    {   5450,   5780,    800,   1520,   7 },   /* Europe/Copenhagen */
+    {   3580,   4220,   2560,   4150,  11 },   /* Europe/Istanbul */
+    {   3690,   4130,   4150,   4350,  11 },   /* Europe/Istanbul */
+    {   3690,   3970,   4350,   4480,  11 },   /* Europe/Istanbul */
+    {   3330,   3470,   3510,   3670,  12 },   /* Asia/Beirut */
+    {   2940,   3330,   3420,   3560,  13 },   /* Asia/Jerusalem */
+    {   2200,   3170,   2470,   3500,  14 },   /* Africa/Cairo */
+    {   2440,   2620,   5070,   5170,  11 },   /* Asia/Qatar */
+    {   2580,   2640,   5030,   5080,  11 },   /* Asia/Bahrain */
+    {   2260,   2610,   5150,   5640,  15 },   /* Asia/Dubai */
+    {   1660,   2640,   5200,   5990,  15 },   /* Asia/Muscat */
+    {   2900,   3750,   4850,   6100,  16 },   /* Asia/Tehran */
+    {   2650,   2900,   5100,   6100,  16 },   /* Asia/Tehran */
+    {   2500,   2650,   5700,   6100,  16 },   /* Asia/Tehran */
+    {   3650,   3850,   4480,   4850,  16 },   /* Asia/Tehran */
+    {   3150,   3650,   4600,   4850,  16 },   /* Asia/Tehran */
+    {   2950,   3150,   4800,   4850,  16 },   /* Asia/Tehran */
+    {   3840,   4260,   4050,   5050,  15 },   /* Asia/Tbilisi */
+    {   1250,   3740,   3450,   5570,  11 },   /* Asia/Riyadh */
+    {   5100,   5480,   4550,   5300,  15 },   /* Europe/Samara */
+    {   4600,   4850,   4550,   4950,  15 },   /* Europe/Astrakhan */
+    {   5600,   5850,   5150,   5430,  15 },   /* Europe/Samara */
+    {   3920,   4020,   6930,   7380,  17 },   /* Asia/Bishkek */
+    {   4020,   4120,   7260,   7650,  17 },   /* Asia/Bishkek */
+    {   4120,   4285,   7100,   8030,  17 },   /* Asia/Bishkek */
+    {   4285,   4300,   7400,   7650,  17 },   /* Asia/Bishkek */
+    {   5300,   5850,   7050,   7650,  17 },   /* Asia/Omsk */
+    {   -100,    720,   7250,   7380,  18 },   /* Indian/Maldives */
+    {   2630,   3050,   8000,   8820,  19 },   /* Asia/Kathmandu */
+    {   2670,   2830,   8870,   9220,  17 },   /* Asia/Thimphu */
+    {   2060,   2520,   8900,   9230,  17 },   /* Asia/Dhaka */
+    {   2400,   2650,   8800,   8900,  17 },   /* Asia/Dhaka */
+    {    560,   2050,   9800,  10950,  20 },   /* Asia/Bangkok */
+    {   2050,   2150,  10000,  10670,  20 },   /* Asia/Vientiane */
+    {   2150,   2280,  10220,  10670,  20 },   /* Asia/Ho_Chi_Minh */
+    {    950,   2180,   9220,  10120,  21 },   /* Asia/Yangon */
+    {   2180,   2400,   9340,   9960,  21 },   /* Asia/Yangon */
+    {   2400,   2650,   9470,   9870,  21 },   /* Asia/Yangon */
+    {   2650,   2860,   9600,   9870,  21 },   /* Asia/Yangon */
+    {    580,   2360,   6800,   9750,  22 },   /* Asia/Kolkata */
+    {   2360,   2800,   7100,   8900,  22 },   /* Asia/Kolkata */
+    {   2800,   3000,   7350,   8900,  22 },   /* Asia/Kolkata */
+    {   3000,   3250,   7460,   8100,  22 },   /* Asia/Kolkata */
+    {   3250,   3550,   7400,   7800,  22 },   /* Asia/Kolkata */
+    {   2360,   2950,   8900,   9750,  22 },   /* Asia/Kolkata */
+    {   2360,   2980,   6160,   7100,  18 },   /* Asia/Karachi */
+    {   2800,   3250,   6650,   7460,  18 },   /* Asia/Karachi */
+    {   3250,   3710,   7050,   7780,  18 },   /* Asia/Karachi */
+    {   2940,   3850,   6090,   7500,  23 },   /* Asia/Kabul */
+    {   3510,   4280,   5240,   6670,  18 },   /* Asia/Ashgabat */
+    {   3700,   4560,   5590,   7320,  18 },   /* Asia/Tashkent */
+    {   4050,   5200,   4650,   8730,  18 },   /* Asia/Almaty */
+    {   5200,   5550,   4650,   7800,  18 },   /* Asia/Almaty */
+    {   4120,   7000,   2700,   5150,  11 },   /* Europe/Moscow */
+    {   6100,   7000,   5150,   6600,  11 },   /* Europe/Moscow */
+    {   6600,   7050,   2800,   4150,  11 },   /* Europe/Moscow */
+    {   5100,   6100,   5150,   7300,  18 },   /* Asia/Yekaterinburg */
+    {   5900,   6100,   7300,   7750,  18 },   /* Asia/Yekaterinburg */
+    {   6100,   7350,   6600,   8500,  18 },   /* Asia/Yekaterinburg */
+    {   4500,   5220,   8770,   9600,  20 },   /* Asia/Hovd */
+    {   4150,   5020,   9600,  12000,  24 },   /* Asia/Ulaanbaatar */
+    {   4900,   6100,   7650,   9900,  20 },   /* Asia/Novosibirsk */
+    {   6100,   7800,   8500,  10600,  20 },   /* Asia/Krasnoyarsk */
+    {   4900,   6400,   9900,  11200,  24 },   /* Asia/Irkutsk */
+    {   4130,   4560,  13930,  14600,  25 },   /* Asia/Tokyo */
+    {   4100,   4500,  11500,  13060,  24 },   /* Asia/Shanghai */
+    {   4500,   4950,  11500,  13450,  24 },   /* Asia/Shanghai */
+    {   4200,   5500,  13300,  14150,  26 },   /* Asia/Vladivostok */
+    {   4200,   4900,  13060,  13300,  26 },   /* Asia/Vladivostok */
+    {   4900,   7700,  11200,  14000,  25 },   /* Asia/Yakutsk */
+    {   4580,   5450,  14150,  14500,  27 },   /* Asia/Sakhalin */
+    {   5900,   6600,  14500,  16300,  27 },   /* Asia/Magadan */
+    {   5080,   6200,  15550,  17500,  28 },   /* Asia/Kamchatka */
+    {   6200,   7150,  16300,  18000,  28 },   /* Asia/Anadyr */
+    {   6400,   6750, -18000, -16890,  28 },   /* Asia/Anadyr */
+    {   3300,   3870,  12450,  13100,  25 },   /* Asia/Seoul */
+    {   3870,   4200,  12500,  12950,  25 },   /* Asia/Pyongyang */
+    {   2400,   4560,  12290,  14600,  25 },   /* Asia/Tokyo */
+    {   1800,   5360,   7350,  13510,  24 },   /* Asia/Shanghai */
+    {    120,    680,   9960,  10450,  24 },   /* Asia/Kuala_Lumpur */
+    {     80,    750,  10950,  11950,  24 },   /* Asia/Kuching */
+    {    450,   2150,  11650,  12700,  24 },   /* Asia/Manila */
+    {   -950,   -810,  12400,  12740,  25 },   /* Asia/Dili */
+    {  -1100,    600,   9500,  11450,  20 },   /* Asia/Jakarta */
+    {  -1100,    500,  11450,  12500,  24 },   /* Asia/Makassar */
+    {  -1100,    200,  12500,  14110,  25 },   /* Asia/Jayapura */
+    {  -1170,   -100,  14110,  15600,  26 },   /* Pacific/Port_Moresby */
+    {  -3550,  -1350,  11250,  12900,  24 },   /* Australia/Perth */
+    {  -2600,  -1050,  12900,  13800,  29 },   /* Australia/Darwin */
+    {  -3850,  -2600,  12900,  14100,  30 },   /* Australia/Adelaide */
+    {  -2900,   -900,  13800,  15400,  26 },   /* Australia/Brisbane */
+    {  -4400,  -2900,  14100,  15400,  31 },   /* Australia/Sydney */
+    {  -2300,  -1950,  16350,  16820,  27 },   /* Pacific/Noumea */
+    {  -4750,  -3400,  16600,  17900,  32 },   /* Pacific/Auckland */
+    {  -2100,  -1200,  17600,  18000,  28 },   /* Pacific/Fiji */
+    {  -2100,  -1200, -18000, -17800,  28 },   /* Pacific/Fiji */
+    {  -2250,  -1550, -17600, -17350,  33 },   /* Pacific/Tongatapu */
+    {  -1450,  -1320, -17290, -17130,  33 },   /* Pacific/Apia */
+    {  -1800,  -1700, -15000, -14900,  34 },   /* Pacific/Tahiti */
+    {   1850,   2250, -16050, -15450,  34 },   /* Pacific/Honolulu */
+    {   2760,   3600,  -1320,   -100,   6 },   /* Africa/Casablanca */
+    {   2080,   2770,  -1720,   -870,   6 },   /* Africa/El_Aaiun */
+    {   2200,   3200,   1000,   2500,   8 },   /* Africa/Tripoli */
+    {   3200,   3320,   1150,   2500,   8 },   /* Africa/Tripoli */
+    {   1890,   3760,   -870,   1200,   6 },   /* Africa/Algiers */
+    {    400,   1500,  -1760,    120,   3 },   /* Africa/Abidjan */
+    {   1500,   2500,  -1760,    420,   3 },   /* Africa/Abidjan */
+    {    600,   1120,    -20,    180,   3 },   /* Africa/Lome */
+    {    350,   1000,   2400,   3350,   8 },   /* Africa/Juba */
+    {   1000,   2200,   2180,   3650,   8 },   /* Africa/Khartoum */
+    {  -1180,   1800,   2950,   5150,  11 },   /* Africa/Nairobi */
+    {  -2600,  -1180,   4250,   5100,  11 },   /* Indian/Antananarivo */
+    {  -3500,   -800,   2000,   4100,   8 },   /* Africa/Johannesburg */
+    {  -3500,  -2860,   1640,   2000,   8 },   /* Africa/Johannesburg */
+    {  -2900,  -1740,   1150,   2000,   8 },   /* Africa/Windhoek */
+    {  -1350,    540,   2400,   3130,   8 },   /* Africa/Lubumbashi */
+    {  -1740,   2350,      0,   2750,   6 },   /* Africa/Lagos */
+    {  -2060,  -1990,   5730,   5790,  15 },   /* Indian/Mauritius */
+    {  -2150,  -2080,   5520,   5590,  15 },   /* Indian/Reunion */
+    {   -500,   -350,   5520,   5600,  15 },   /* Indian/Mahe */
+    {   4650,   5200,  -5950,  -5250,  35 },   /* America/St_Johns */
+    {   5150,   6050,  -6700,  -5570,   4 },   /* America/Goose_Bay */
+    {   4330,   4810,  -6780,  -5970,   4 },   /* America/Halifax */
+    {   5970,   8370,  -7330,  -1130,  36 },   /* America/Nuuk */
+    {   6000,   7000, -14100, -12380,  37 },   /* America/Whitehorse */
+    {   5100,   7200, -18000, -14100,  38 },   /* America/Anchorage */
+    {   5460,   6000, -14100, -13000,  38 },   /* America/Juneau */
+    {   3130,   3700, -11480, -10905,  37 },   /* America/Phoenix */
+    {   3250,   4200, -12500, -11410,  39 },   /* America/Los_Angeles */
+    {   4200,   4900, -12500, -11700,  39 },   /* America/Los_Angeles */
+    {   4900,   6000, -14000, -11850,  39 },   /* America/Vancouver */
+    {   3130,   4100, -11700, -10200,  40 },   /* America/Denver */
+    {   4100,   4900, -11700, -10400,  40 },   /* America/Denver */
+    {   4900,   6000, -12000, -11000,  40 },   /* America/Edmonton */
+    {   6000,   7000, -12380, -10200,  40 },   /* America/Yellowknife */
+    {   4900,   6000, -11000, -10140,  41 },   /* America/Regina */
+    {   1980,   2330,  -8500,  -7410,  42 },   /* America/Havana */
+    {   2090,   2730,  -7950,  -7270,  43 },   /* America/Nassau */
+    {   2450,   3500,  -8500,  -7500,  43 },   /* America/New_York */
+    {   3500,   3900,  -8450,  -7500,  43 },   /* America/New_York */
+    {   3700,   3900,  -8600,  -8450,  43 },   /* America/Kentucky/Louisville */
+    {   3900,   4750,  -8650,  -6690,  43 },   /* America/New_York */
+    {   4200,   6300,  -8950,  -5710,  43 },   /* America/Toronto */
+    {   4900,   6000, -10140,  -8950,  44 },   /* America/Winnipeg */
+    {   2580,   4900, -10400,  -8500,  44 },   /* America/Chicago */
+    {   1800,   2010,  -7450,  -7160,  43 },   /* America/Port-au-Prince */
+    {   1750,   2000,  -7160,  -6830,  45 },   /* America/Santo_Domingo */
+    {   1000,   1860,  -6830,  -5940,  45 },   /* America/Puerto_Rico */
+    {   1770,   1860,  -7840,  -7610,  46 },   /* America/Jamaica */
+    {   2800,   3270, -11800, -11470,  39 },   /* America/Tijuana */
+    {   2600,   3250, -11470, -10850,  37 },   /* America/Hermosillo */
+    {   2200,   2600, -11250, -10580,  37 },   /* America/Mazatlan */
+    {   2280,   2800, -11500, -10940,  37 },   /* America/Mazatlan */
+    {   1780,   2170,  -8920,  -8670,  46 },   /* America/Cancun */
+    {   1450,   3180, -10850,  -8670,  41 },   /* America/Mexico_City */
+    {    800,   1850,  -9230,  -8250,  41 },   /* America/Guatemala */
+    {    720,    970,  -8300,  -7710,  46 },   /* America/Panama */
+    {    700,   1220,  -7200,  -5980,  45 },   /* America/Caracas */
+    {     60,    700,  -6780,  -6000,  45 },   /* America/Caracas */
+    {    120,    860,  -6140,  -5650,  45 },   /* America/Guyana */
+    {   -430,   1250,  -7910,  -6680,  46 },   /* America/Bogota */
+    {   -500,    150,  -8110,  -7520,  46 },   /* America/Guayaquil */
+    {  -1840,      0,  -8140,  -6860,  46 },   /* America/Lima */
+    {  -1120,   -700,  -7400,  -6660,  46 },   /* America/Rio_Branco */
+    {  -2700,  -1750,  -7570,  -6840,  47 },   /* America/Santiago */
+    {  -3800,  -2700,  -7570,  -7000,  47 },   /* America/Santiago */
+    {  -4850,  -3800,  -7600,  -7160,  47 },   /* America/Santiago */
+    {  -5600,  -4850,  -7600,  -6650,  48 },   /* America/Punta_Arenas */
+    {  -2290,   -970,  -6970,  -5750,  45 },   /* America/La_Paz */
+    {  -2760,  -1930,  -6270,  -5420,  48 },   /* America/Asuncion */
+    {  -1000,    530,  -7390,  -5610,  45 },   /* America/Manaus */
+    {  -2400,   -730,  -6170,  -5100,  45 },   /* America/Cuiaba */
+    {  -5600,    580,  -7360,  -3470,  48 },   /* America/Sao_Paulo */
+};
+
+const uint8_t  TZ_N_RULES = 49;
+const uint16_t TZ_N_BOXES = 213;
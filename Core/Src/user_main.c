@@ -1,54 +1,231 @@
 #include "main.h"
 #include "gps.h"
 #include "nixie.h"
+#include "timekeep.h"
+#include "anim.h"
+#include "prof.h"
+#include "telem.h"
+#include "idle.h"
+#include "civil.h"
+#include "kv.h"
+#include "rtc.h"
+#include "tz.h"
 #include <stdlib.h>
 
-/* ===== シャッフル効果パラメータ ===== */
-#ifndef SHUF_START_DIV
-#define SHUF_START_DIV 3
+extern UART_HandleTypeDef huart1;   /* GPS (main.c) */
+extern UART_HandleTypeDef huart2;   /* VCP (main.c) */
+
+/* ===== 夜間減光とカソード保護（現地時刻、時は [FROM, TO) で日跨ぎ可） ===== */
+#ifndef DIM_FROM_H
+#define DIM_FROM_H     23
+#endif
+#ifndef DIM_TO_H
+#define DIM_TO_H       6
+#endif
+#ifndef DIM_DUTY
+#define DIM_DUTY       4U          /* 0..NIXIE_PWM_STEPS */
+#endif
+#ifndef ACP_FROM_H
+#define ACP_FROM_H     2           /* 人が見ていない時間帯 */
+#endif
+#ifndef ACP_TO_H
+#define ACP_TO_H       5
+#endif
+#ifndef ACP_EVERY_MIN
+#define ACP_EVERY_MIN  10          /* この分の倍数の ACP_AT_SEC 秒に巡回 */
 #endif
-#ifndef SHUF_PEAK_DIV
-#define SHUF_PEAK_DIV  20
+#ifndef ACP_AT_SEC
+#define ACP_AT_SEC     30
 #endif
-#ifndef SHUF_END_DIV
-#define SHUF_END_DIV   10
+#ifndef ACP_CYCLES
+#define ACP_CYCLES     5U
+#endif
+#ifndef ACP_STEP_MS
+#define ACP_STEP_MS    100U
+#endif
+#ifndef POS_SAVE_E5
+#define POS_SAVE_E5    1000        /* 位置を保存し直す移動量（緯度差＋経度差）[1e-5 度] ≒ 1km */
+#endif
+#ifndef RTC_SET_EVERY_S
+#define RTC_SET_EVERY_S 3600       /* GPS に同期している間、RTC を書き直す間隔 [秒] */
 #endif
 
-/* ===== シャッフル制御フラグ ===== */
+/* ===== 演出（SW_EX で順に切替） ===== */
+static const anim_t *const FX_LIST[] = {
+    &ANIM_FX_SHUFFLE, &ANIM_FX_SLOT, &ANIM_FX_CASCADE, &ANIM_FX_DISSOLVE
+};
 static volatile uint8_t  g_shuffle_req  = 0U;
-static volatile uint8_t  g_shuffle_busy = 0U;
+static uint8_t           g_fx_next      = 0U;
 
-/* ====== 表示モードと時刻カウンタ ====== */
+/* ====== 表示モード ====== */
 typedef enum { DISP_LOCAL = 0, DISP_UTC = 1 } disp_mode_t;
 static volatile disp_mode_t g_disp_mode = DISP_LOCAL;
 static volatile uint32_t    g_utc_btn_last_tick = 0;   /* 150msデバウンス */
+static volatile uint8_t     g_redraw = 0U;             /* 秒境界を待たずに再描画 */
+static int16_t              g_tz_warm = 0;             /* GPS の現地時刻が無いときの時差 [分]（起動時は保存値、以後は最後の GPS の値） */
 
-static volatile int disp_hh = -1, disp_mm = -1, disp_ss = -1;
+/* ===== 現地の通日秒（-1=未同期） ===== */
+static int32_t local_sod(int32_t sod)
+{
+    if (sod < 0) return -1;
+    gps_fix_t fx;
+    (void)gps_get_snapshot(&fx);
+    civil_t lc;
+    if (fx.lcl_hh >= 0) g_tz_warm = fx.tz_min;     /* 時刻の空の RMC（途絶中）でも時差は続けて使う */
+    utc_to_local(sod, g_tz_warm, &lc);
+    return (int32_t)lc.hh * 3600 + lc.mm * 60 + lc.ss;
+}
 
-/* ===== GPS→表示カウンタ同期 ===== */
-static void sync_display_time_from_gps(void)
+/* ===== UTC 通日秒を表示モードに合わせたコードへ。0=未同期 =====
+   推定時刻の間と GPS の時刻へ寄せている間は、区切りのドットを1秒おきに消す */
+static uint8_t time_codes_at(int32_t sod, uint16_t v[8])
 {
-    if (g_disp_mode == DISP_UTC) {
-        if (g_UTC_hh >= 0 && g_UTC_mm >= 0 && g_UTC_ss >= 0) {
-            disp_hh = g_UTC_hh; disp_mm = g_UTC_mm; disp_ss = g_UTC_ss;
-        }
-    } else {
-        if (g_LCL_hh >= 0 && g_LCL_mm >= 0 && g_LCL_ss >= 0) {
-            disp_hh = g_LCL_hh; disp_mm = g_LCL_mm; disp_ss = g_LCL_ss;
-        }
+    if (sod < 0) return 0U;
+
+    if (g_disp_mode == DISP_LOCAL) sod = local_sod(sod);
+    nixie_time_codes((uint8_t)(sod / 3600), (uint8_t)((sod / 60) % 60), (uint8_t)(sod % 60), v);
+    if (tk_unsynced() && (sod & 1)) v[2] = v[5] = nixie_code(0xFFU, 0U, 0U);
+    return 1U;
+}
+
+static uint8_t time_codes_now(uint16_t v[8]){ return time_codes_at(tk_utc_sod(), v); }
+
+static void show_time_now(void)
+{
+    uint16_t v[8];
+    if (time_codes_now(v)) nixie_show_codes(v);
+}
+
+/* ===== 次の秒の先送り（nixie.h）=====
+   PPS に同期している間は、秒の表示を済ませた直後に次の秒のフレームをシフトレジスタへ
+   送っておき、PPS の捕捉割込みが STCP を叩くだけで切替える */
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+static int32_t g_arm_sod = -1;     /* 先送りした秒（UTC 通日秒） */
+#endif
+
+static void arm_next(void)
+{
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+    int32_t sod = tk_utc_sod();
+    uint16_t v[8];
+    if (tk_state() != TK_PPS || tk_unsynced() || sod < 0) return;
+    sod = (sod + 1) % 86400;
+    if (time_codes_at(sod, v) && nixie_arm_codes(v)) g_arm_sod = sod;
+#endif
+}
+
+/* 今の秒が PPS で既に表示されていれば 1 */
+static uint8_t armed_shown(void)
+{
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+    return (uint8_t)(nixie_arm_state() == NIXIE_ARM_SHOWN && g_arm_sod == tk_utc_sod());
+#else
+    return 0U;
+#endif
+}
+
+static uint8_t in_hours(int32_t h, int32_t from, int32_t to)
+{
+    return (from <= to) ? (h >= from && h < to) : (h >= from || h < to);
+}
+
+/* ===== 秒ごと：時間帯に応じた輝度と、カソード巡回の起動 ===== */
+static void tube_schedule(void)
+{
+    int32_t sod = local_sod(tk_utc_sod());
+    if (sod < 0) return;
+    int32_t h = sod / 3600, m = (sod / 60) % 60, s = sod % 60;
+
+    nixie_set_brightness(in_hours(h, DIM_FROM_H, DIM_TO_H) ? DIM_DUTY : NIXIE_PWM_STEPS);
+    if (in_hours(h, ACP_FROM_H, ACP_TO_H) && (m % ACP_EVERY_MIN) == 0 && s == ACP_AT_SEC
+        && !nixie_acp_active() && !anim_busy()) {
+        (void)nixie_acp_start(ACP_CYCLES, ACP_STEP_MS);
+    }
+}
+
+/* ===== 設定の保存（kv.h）。値が変わったときだけ kv がフラッシュへ遅延書込みする ===== */
+static kv_fix_t g_fix_saved;
+static uint8_t  g_fix_boot = 0U;   /* この起動で日付つきの測位を保存した */
+
+static void settings_load(void)
+{
+    uint8_t v;
+    if (kv_get(KV_DISP_MODE, &v, 1U) && v <= (uint8_t)DISP_UTC) g_disp_mode = (disp_mode_t)v;
+    if (kv_get(KV_FX_NEXT, &v, 1U) && v < (uint8_t)(sizeof(FX_LIST) / sizeof(FX_LIST[0]))) g_fx_next = v;
+    nixie_set_enable_mask(kv_get(KV_ENABLE_MASK, &v, 1U) ? v : 0xFFU);   /* 既定は全桁有効 */
+    if (!kv_get(KV_LAST_FIX, &g_fix_saved, sizeof g_fix_saved)) {
+        static const kv_fix_t NONE = { INT32_MIN, INT32_MIN, 0U, 0, 0U };
+        g_fix_saved = NONE;
     }
 }
 
-/* ===== 1秒進める ===== */
-static inline void tick_display_1s(void)
+/* 最後の測位は、起動後に初めて日付つきで測位したときと、POS_SAVE_E5 以上動いたときだけ
+   （走行中や毎秒は書かない。毎日電源を入れ直す使い方なら1日1記録） */
+static void settings_fix(const gps_fix_t *fx)
 {
-    if (disp_hh < 0) return;
-    if (++disp_ss >= 60) { disp_ss = 0; if (++disp_mm >= 60) { disp_mm = 0; if (++disp_hh >= 24) disp_hh = 0; } }
+    if (fx->lat.umin == GPS_FX_INVALID || fx->lon.umin == GPS_FX_INVALID) return;
+    kv_fix_t f = { (int32_t)fx->lat.deg * 100000 + fx->lat.umin / 600,
+                   (int32_t)fx->lon.deg * 100000 + fx->lon.umin / 600, 0U, fx->tz_min, 0U };
+    if (g_fix_boot
+        && labs((long)(f.lat_e5 - g_fix_saved.lat_e5)) + labs((long)(f.lon_e5 - g_fix_saved.lon_e5)) < POS_SAVE_E5) return;
+    if (fx->utc_YYYY >= 1970 && fx->utc_MM >= 1 && fx->utc_DD >= 1 && fx->utc_hh >= 0 && fx->utc_mm >= 0 && fx->utc_ss >= 0)
+        f.utc_s = (uint32_t)civil_epoch(fx->utc_YYYY, fx->utc_MM, fx->utc_DD, fx->utc_hh, fx->utc_mm, fx->utc_ss);
+    if (kv_set(KV_LAST_FIX, &f, sizeof f)) {
+        g_fix_saved = f;
+        g_fix_boot = (uint8_t)(f.utc_s != 0U);
+    }
+}
+
+static void settings_poll(void)
+{
+    uint8_t m = (uint8_t)g_disp_mode;
+    (void)kv_set(KV_DISP_MODE, &m, 1U);
+    (void)kv_set(KV_FX_NEXT, &g_fx_next, 1U);
+
+    /* ページ消去は割込みごと 20〜40ms 止まる。PWM が止まっても見た目の変わらない時だけ許す */
+    uint8_t steady = !anim_busy() && !nixie_acp_active();
+    for (uint8_t i = 0; i < 8U && steady; i++) steady = (nixie_get_duty(i) >= NIXIE_PWM_STEPS);
+    kv_poll(steady);
+}
+
+/* ===== 起動直後の推定時刻 =====
+   最後の測位の位置で時差表を引いておき（位置の無い時刻だけの文でも現地時刻が出る）、
+   RTC が動き続けていればその時刻で timekeep を始める。GPS の時刻が来れば timekeep が寄せる */
+static uint8_t g_rtc_set = 0U;     /* この起動で RTC を書いた */
+
+static void warm_start(void)
+{
+    uint8_t pos = (g_fix_saved.lat_e5 != INT32_MIN);
+    g_tz_warm = g_fix_saved.tz_min;
+    if (pos) tz_update(g_fix_saved.lat_e5 / 1000, g_fix_saved.lon_e5 / 1000);
+
+    int64_t t;
+    if (!rtc_get(&t) || t < (int64_t)g_fix_saved.utc_s) return;   /* 最後の測位より前：RTC は止まっていた */
+    if (pos) g_tz_warm = tz_offset(t);                              /* 今日の夏時間で */
+    tk_seed(t);
+}
+
+/* 秒境界ごと。GPS に同期している間は RTC_SET_EVERY_S ごとに RTC を書き直す */
+static void rtc_keep(void)
+{
+    tk_state_t st = tk_state();
+    int32_t sod = tk_utc_sod();
+    if ((st != TK_PPS && st != TK_NMEA) || tk_unsynced() || sod < 0) return;
+    if (g_rtc_set && (sod % RTC_SET_EVERY_S) != 0) return;
+
+    gps_fix_t fx;
+    (void)gps_get_snapshot(&fx);
+    if (fx.utc_YYYY < 2000 || fx.utc_MM < 1 || fx.utc_DD < 1 || fx.utc_hh < 0) return;
+    int64_t t = civil_epoch(fx.utc_YYYY, fx.utc_MM, fx.utc_DD, 0, 0, 0) + sod;
+    if (sod < (int32_t)fx.utc_hh * 3600) t += 86400;               /* スナップショットの後に日付が変わった */
+    rtc_set(t);
+    g_rtc_set = 1U;
 }
 
 /* ===== EXTI（ボタン） ===== */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
+    idle_event();
     if(GPIO_Pin == SW_EX_Pin){            /* シャッフル要求 */
         if(!g_shuffle_req) g_shuffle_req = 1U;
         return;
@@ -58,71 +235,95 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
         if ((now - g_utc_btn_last_tick) >= 150U) {
             g_utc_btn_last_tick = now;
             g_disp_mode = (g_disp_mode == DISP_UTC) ? DISP_LOCAL : DISP_UTC;
-            sync_display_time_from_gps();
+            g_redraw = 1U;
         }
         return;
     }
 }
 
-/* ===== シャッフル実装 ===== */
-static void shuffle_effect(void)
-{
-    g_shuffle_busy = 1U;
-
-    uint8_t d[8];
-    for (int i=0;i<8;i++) d[i]=(uint8_t)(rand()%10U);
-    nixie_show_digits_lr(d[0],d[1],d[2],d[3],d[4],d[5],d[6],d[7]);
-
-    for (uint8_t div=SHUF_START_DIV; div<=SHUF_PEAK_DIV; ++div){
-        HAL_Delay(1000U/div);
-        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
-        for (int i=0;i<8;i++) d[i]=(uint8_t)(rand()%10U);
-        nixie_show_digits_lr(d[0],d[1],d[2],d[3],d[4],d[5],d[6],d[7]);
-    }
-    for (int div=SHUF_PEAK_DIV-1; div>=SHUF_END_DIV; --div){
-        HAL_Delay(1000U/(uint32_t)div);
-        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
-        for (int i=0;i<8;i++) d[i]=(uint8_t)(rand()%10U);
-        nixie_show_digits_lr(d[0],d[1],d[2],d[3],d[4],d[5],d[6],d[7]);
-    }
-
-    for (int i=0;i<8;i++) d[i]=(uint8_t)(rand()%10U);
-    nixie_show_digits_lr(d[0],d[1],d[2],d[3],d[4],d[5],d[6],d[7]);
-
-    g_shuffle_busy = 0U;
-}
-
-/* ===== エントリ =====
-   main() の while ループ直前で呼ぶ */
-void user_main(void)
+/* ===== 起動 =====
+   周辺の初期化（MX_*_Init）の後に1回。ホストの模擬（Host/tools/nixie_sim）はこの後
+   user_loop() を仮想時間で回す */
+void user_setup(void)
 {
     srand((unsigned)HAL_GetTick());
 
+    kv_init();                     /* 設定の読出し（空きページの消去もここで、表示の開始前に） */
     nixie_init();
-    nixie_set_enable_mask(0xFF);   /* 全桁有効 */
+    settings_load();               /* 表示モード・演出・有効桁・最後の測位 */
+    nixie_pwm_start();             /* TIM6 リフレッシュ（輝度・カソード保護） */
 
-    sync_display_time_from_gps();  /* 取れている側に初期同期 */
+    gps_init(&huart1);             /* USART1 受信開始（DMA循環） */
+    tk_init();                     /* TIM2 時間軸＋PPS キャプチャ */
+    rtc_init();                    /* リセットを跨いで動いている RTC（VBAT があれば電源断も） */
+    warm_start();                  /* 最後の測位の時差と RTC の推定時刻ですぐ表示 */
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+    tk_set_pps_hook(nixie_latch_armed);   /* PPS の割込みは先送りしたフレームのラッチだけ */
+#endif
+    prof_init();                   /* PROF_ENABLE=1 のとき DWT 計測（VCP で 'p' 表示） */
+    telem_init(&huart2);           /* VCP へ DMA でテレメトリ（Host/tools/telem_dump で復号） */
+    idle_init();                   /* 仕事が無い間は WFI で眠る */
+}
 
-    uint32_t t_prev = HAL_GetTick();
+/* ===== 本体ループの1周（最後に idle_wait で次の仕事か 1ms 境界まで眠る） ===== */
+void user_loop(void)
+{
+    PROF_BEGIN(PROF_LOOP);
+    uint8_t upd = gps_poll_line();
+    if (upd & (GPS_UPD_RMC | GPS_UPD_ZDA | GPS_UPD_GLL)) {
+        gps_fix_t fx;
+        (void)gps_get_snapshot(&fx);
+        tk_on_fix(&fx);            /* 直前の PPS に時刻ラベル */
+        settings_fix(&fx);
+    }
 
-    while (1) {
-        if (g_shuffle_req) {
-            shuffle_effect();
-            t_prev = HAL_GetTick();    /* タイマ補正 */
-            g_shuffle_req = 0U;
+    if (g_shuffle_req) {
+        g_shuffle_req = 0U;
+        if (!anim_busy() && !nixie_acp_active()) {
+            uint16_t v[8];
+            anim_start(FX_LIST[g_fx_next], time_codes_now(v) ? v : NULL);
+            if (++g_fx_next >= (uint8_t)(sizeof(FX_LIST) / sizeof(FX_LIST[0]))) g_fx_next = 0U;
         }
+    }
 
-        uint32_t now = HAL_GetTick();
-        if ((now - t_prev) >= 1000U && !g_shuffle_busy) {
-            t_prev += 1000U;
-
-            if (disp_hh < 0) sync_display_time_from_gps();
-            else             tick_display_1s();
-
-            if (disp_hh >= 0)
-                nixie_show_time_hms((uint8_t)disp_hh,(uint8_t)disp_mm,(uint8_t)disp_ss);
+    /* 演出はコマ時刻が来た分だけ描いて戻る（GPS 受信を止めない） */
+    PROF_BEGIN(PROF_ANIM_POLL);
+    uint8_t a = anim_poll();
+    PROF_END(PROF_ANIM_POLL);
+    if (a == ANIM_FRAME) HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+    if (a == ANIM_END)   g_redraw = 1U;
 
+    /* 秒表示は PPS（無ければ推定した秒境界）で切替える */
+    uint8_t flip = tk_poll();
+    if (flip && anim_busy()) {
+        uint16_t v[8];
+        if (time_codes_now(v)) anim_set_target(v);   /* 演出の着地点も秒に追従 */
+    }
+    if ((flip || g_redraw) && !anim_busy()) {
+        if (g_redraw || !armed_shown()) show_time_now();   /* PPS で切替わっていれば送らない */
+        g_redraw = 0U;
+        if (flip) {
             HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+            tube_schedule();
+            if (!nixie_acp_active()) arm_next();
         }
     }
+    if (flip) rtc_keep();      /* 次の起動の推定時刻 */
+
+    telem_poll(flip, (uint8_t)((g_disp_mode == DISP_UTC ? TM_DISP_UTC : 0U)
+                             | (anim_busy() ? TM_DISP_ANIM : 0U)
+                             | (nixie_acp_active() ? TM_DISP_ACP : 0U)));
+    prof_console(&huart2);
+    settings_poll();           /* 変わった設定をフラッシュへ少しずつ */
+    PROF_END(PROF_LOOP);
+
+    idle_wait();               /* 割込みの知らせか次の 1ms まで */
+}
+
+/* ===== エントリ =====
+   main() の while ループ直前で呼ぶ */
+void user_main(void)
+{
+    user_setup();
+    while (1) user_loop();
 }
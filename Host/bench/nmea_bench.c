@@ -0,0 +1,393 @@
+/* NMEA 受信の負荷試験。
+   合成した（または記録した）NMEA バイト列を、指定ボーレートの仮想時間で1バイトずつ
+   HAL_UART_RxCpltCallback 経由で s_ring へ入れ、gps_poll_line() を指定間隔で呼ぶ。
+   解析側のホスト CPU 時間、リングの最大使用量とあふれ（gps_rx_* カウンタ）、文種別カウンタを報告する。
+   あふれがあっても同じ文を二重に数えない（ok が送った数を超えない）ことを確かめ、超えたら終了コード 1
+
+     nmea_bench                  既定の組合せ（1/5/10/20Hz × 話者 × 9600/115200bps）を一覧
+     nmea_bench -r 10 -b 9600 -t mix -c 5 -x 2 -l 5 -g 20 -S 1500/5
+     nmea_bench -f capture.nmea -b 9600 -g 50
+     nmea_bench -L               基準線（a48f8b3 の gps_poll_line）と並べて cycles/sentence を比べる
+     nmea_bench -L -t mix -s 30
+
+   GPS_RX_BUF_SZ はビルド時の値（cmake -DCMAKE_C_FLAGS=-DGPS_RX_BUF_SZ=512 など）が使われる */
+#include "hal_fake.h"
+#include "gps.h"
+#include "nmea_legacy.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_TSC 1   /* core_cm4.h の __I/__O と衝突するので x86intrin.h は使わない */
+#else
+#define HAVE_TSC 0
+#endif
+
+typedef struct {
+    uint32_t    hz;           /* 1秒あたりの測位エポック */
+    uint32_t    baud;
+    const char *talker;       /* GP/GN/GL/GA/mix */
+    uint32_t    seconds;      /* 合成する長さ [s] */
+    uint32_t    gap_ms;       /* gps_poll_line() の呼出し間隔 */
+    uint32_t    stall_ms;     /* stall_every_s ごとに本体ループが止まる時間 */
+    uint32_t    stall_every_s;
+    double      badck_pct;    /* チェックサム破損 */
+    double      trunc_pct;    /* 途中で切れる（改行なし） */
+    double      long_pct;     /* 82字超の RMC */
+    const char *file;
+    uint32_t    seed;
+    uint8_t     rg_only;      /* RMC/GGA だけを合成（-L で基準線と同じ仕事に揃える） */
+} cfg_t;
+
+typedef struct {
+    uint8_t  *buf;
+    size_t    len, cap;
+    uint32_t  rmc, gga;       /* 無傷で送った数（期待される ok） */
+    uint32_t  n_long, n_bad, n_trunc;
+} stream_t;
+
+typedef struct {
+    uint64_t host_ns, tsc;
+    uint32_t polls, lines;
+    double   wire_s;
+} result_t;
+
+/* ==== 合成 =========================================================== */
+static uint32_t s_rng;
+static uint32_t rnd(void){ s_rng = s_rng * 1664525U + 1013904223U; return s_rng >> 8; }
+static int      chance(double pct){ return pct > 0.0 && (double)(rnd() % 1000000U) < pct * 10000.0; }
+
+static void put(stream_t *st, const char *p, size_t n)
+{
+    if(st->len + n > st->cap){
+        st->cap = (st->cap + n) * 2U;
+        st->buf = (uint8_t*)realloc(st->buf, st->cap);
+        if(!st->buf){ perror("realloc"); exit(2); }
+    }
+    memcpy(st->buf + st->len, p, n);
+    st->len += n;
+}
+
+/* body（'$' と '*' を除く）に検査和を付けて流す。破損・切断はここで加える。返値: 1=無傷 */
+static int emit(stream_t *st, const cfg_t *c, const char *body)
+{
+    char s[256];
+    uint8_t ck = 0;
+    for(const char *p=body;*p;p++) ck ^= (uint8_t)*p;
+    int n = snprintf(s, sizeof s, "$%s*%02X\r\n", body, ck);
+
+    if(chance(c->trunc_pct)){
+        put(st, s, (size_t)(1 + rnd() % (uint32_t)(n - 3)));   /* 改行まで届かない */
+        st->n_trunc++;
+        return 0;
+    }
+    if(chance(c->badck_pct)){
+        s[n-3] = (s[n-3] == '0') ? '1' : '0';
+        st->n_bad++;
+        put(st, s, (size_t)n);
+        return 0;
+    }
+    put(st, s, (size_t)n);
+    return 1;
+}
+
+static const char *pick_talker(const cfg_t *c, const char *mix_as)
+{
+    return strcmp(c->talker, "mix") == 0 ? mix_as : c->talker;
+}
+
+static void gen_epoch(stream_t *st, const cfg_t *c, uint32_t k)
+{
+    char b[200];
+    uint32_t ms  = (uint32_t)((uint64_t)k * 1000U / c->hz);
+    uint32_t sod = 43200U + ms / 1000U;
+    uint32_t cs  = (ms % 1000U) / 10U;
+    uint32_t hh = sod / 3600U, mi = (sod / 60U) % 60U, ss = sod % 60U;
+    uint32_t frac = (k * 37U) % 10000U;                  /* 位置を少しずつ動かす */
+    const char *nav = pick_talker(c, "GN");
+
+    if(chance(c->long_pct)){
+        snprintf(b, sizeof b, "%sRMC,%02u%02u%02u.%03u,A,3541.%04u1234,N,13945.%04u5678,E,"
+                 "0.0041,77.5213,170624,0.00,E,D,V,EXTRA,FIELD,PADDING,0000", nav, hh, mi, ss, cs*10U, frac, frac);
+        st->n_long++;
+        (void)emit(st, c, b);
+    }else{
+        snprintf(b, sizeof b, "%sRMC,%02u%02u%02u.%02u,A,3541.%04u,N,13945.%04u,E,0.004,77.52,170624,,,A,V",
+                 nav, hh, mi, ss, cs, frac, frac);
+        st->rmc += (uint32_t)emit(st, c, b);
+    }
+    if(!c->rg_only){
+        snprintf(b, sizeof b, "%sVTG,77.52,T,,M,0.004,N,0.008,K,A", nav);
+        (void)emit(st, c, b);
+    }
+    snprintf(b, sizeof b, "%sGGA,%02u%02u%02u.%02u,3541.%04u,N,13945.%04u,E,1,12,0.79,41.3,M,39.5,M,,",
+             nav, hh, mi, ss, cs, frac, frac);
+    st->gga += (uint32_t)emit(st, c, b);
+    if(c->rg_only) return;
+
+    static const char *const CONS[3] = { "GP", "GL", "GA" };
+    int ncons = strcmp(c->talker, "mix") == 0 ? 3 : 1;
+    for(int i=0;i<ncons;i++){
+        snprintf(b, sizeof b, "%sGSA,A,3,02,05,12,13,15,18,20,25,29,,,,1.38,0.79,1.13,%d",
+                 pick_talker(c, CONS[i]), i + 1);
+        (void)emit(st, c, b);
+    }
+    for(int i=0;i<ncons;i++){
+        const char *t = (ncons == 1) ? c->talker : CONS[i];
+        for(int m=1;m<=3;m++){
+            snprintf(b, sizeof b, "%sGSV,3,%d,12,%02d,40,083,46,%02d,17,308,41,%02d,07,344,39,%02d,22,228,45,1",
+                     t, m, m*4-3, m*4-2, m*4-1, m*4);
+            (void)emit(st, c, b);
+        }
+    }
+    snprintf(b, sizeof b, "%sGLL,3541.%04u,N,13945.%04u,E,%02u%02u%02u.%02u,A,A", nav, frac, frac, hh, mi, ss, cs);
+    (void)emit(st, c, b);
+    if(cs == 0U){
+        snprintf(b, sizeof b, "%sZDA,%02u%02u%02u.00,17,06,2024,00,00", nav, hh, mi, ss);
+        (void)emit(st, c, b);
+    }
+}
+
+static void build_stream(stream_t *st, const cfg_t *c)
+{
+    memset(st, 0, sizeof *st);
+    if(c->file){
+        FILE *f = fopen(c->file, "rb");
+        if(!f){ perror(c->file); exit(2); }
+        char tmp[4096];
+        size_t n;
+        while((n = fread(tmp, 1, sizeof tmp, f)) > 0) put(st, tmp, n);
+        fclose(f);
+        return;
+    }
+    s_rng = c->seed;
+    for(uint32_t k=0;k<c->seconds * c->hz;k++) gen_epoch(st, c, k);
+}
+
+/* ==== 実行 =========================================================== */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t rdtsc(void)
+{
+#if HAVE_TSC
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void do_poll(result_t *r)
+{
+    uint32_t l0 = gps_rx_lines;
+    uint64_t t0 = now_ns();
+#if HAVE_TSC
+    uint64_t c0 = __builtin_ia32_rdtsc();
+#endif
+    (void)gps_poll_line();
+#if HAVE_TSC
+    r->tsc += __builtin_ia32_rdtsc() - c0;
+#endif
+    r->host_ns += now_ns() - t0;
+    r->polls++;
+    r->lines += gps_rx_lines - l0;
+}
+
+/* 本体ループの呼出し時刻：gap_ms ごと。stall_every_s 周期の末尾 stall_ms は呼ばれない */
+static uint64_t next_poll(const cfg_t *c, uint64_t t)
+{
+    const uint64_t ms = HAL_FAKE_TIM_HZ / 1000U;
+    t += (uint64_t)c->gap_ms * ms;
+    if(c->stall_ms && c->stall_every_s){
+        uint64_t per = (uint64_t)c->stall_every_s * 1000U * ms;
+        uint64_t ph  = t % per;
+        if(ph >= per - (uint64_t)c->stall_ms * ms) t += per - ph;
+    }
+    return t;
+}
+
+static void run(const cfg_t *c, const stream_t *st, result_t *r)
+{
+    memset(r, 0, sizeof *r);
+    hal_fake_reset();
+    huart1.hdmarx = NULL;                 /* 1バイト割込み受信（RxCplt 経由） */
+    gps_init(&huart1);
+
+    const uint64_t tb = (uint64_t)HAL_FAKE_TIM_HZ * 10U;   /* 8N1 = 10bit/バイト */
+    uint64_t tp = next_poll(c, 0);
+    for(size_t i=0;i<st->len;i++){
+        uint64_t t_byte = (uint64_t)(i + 1U) * tb / c->baud;
+        while(tp <= t_byte){
+            hal_fake_advance_ticks(tp - hal_fake_now_ticks());
+            do_poll(r);
+            tp = next_poll(c, tp);
+        }
+        hal_fake_advance_ticks(t_byte - hal_fake_now_ticks());
+        hal_fake_uart_inject(&huart1, &st->buf[i], 1U);
+    }
+    do_poll(r);
+    r->wire_s = (double)hal_fake_now_ticks() / HAL_FAKE_TIM_HZ;
+}
+
+static void print_header(void)
+{
+    printf("%4s %-4s %6s %8s %6s %9s %9s %10s %5s %6s %4s %4s %17s %17s %5s\n",
+           "Hz", "tlk", "baud", "bytes", "lines", "ns/sent", "cyc/sent", "sent/s", "hwm", "drop",
+           "ovf", "rsy", "rmc ok/bad(exp)", "gga ok/bad(exp)", "load");
+}
+
+/* 戻り値：1=送った数より多く解析した（あふれ後の二重計上） */
+static int print_row(const cfg_t *c, const stream_t *st, const result_t *r)
+{
+    double per = r->lines ? (double)r->host_ns / r->lines : 0.0;
+    double cyc = r->lines ? (double)r->tsc / r->lines : 0.0;
+    double sps = r->host_ns ? r->lines * 1e9 / (double)r->host_ns : 0.0;
+    double load = (c->file || !c->seconds) ? 0.0
+                : 100.0 * ((double)st->len / c->seconds) / (c->baud / 10.0);
+    char rmc[32], gga[32];
+    snprintf(rmc, sizeof rmc, "%u/%u(%u)", (unsigned)gps_rmc_ok, (unsigned)gps_rmc_bad, (unsigned)st->rmc);
+    snprintf(gga, sizeof gga, "%u/%u(%u)", (unsigned)gps_gga_ok, (unsigned)gps_gga_bad, (unsigned)st->gga);
+    printf("%4u %-4s %6u %8zu %6u %9.0f %9.0f %10.0f %5u %6u %4u %4u %17s %17s %4.0f%%\n",
+           c->hz, c->file ? "file" : c->talker, c->baud, st->len, r->lines, per, cyc, sps,
+           (unsigned)gps_rx_hwm, (unsigned)gps_rx_dropped, (unsigned)gps_rx_overflows,
+           (unsigned)gps_rx_resync, rmc, gga, load);
+    return !c->file && (gps_rmc_ok > st->rmc + st->n_long || gps_gga_ok > st->gga);  /* 82字超も解析上は通る */
+}
+
+/* ==== 基準線との比較（-L） ============================================ */
+/* 同じバイト列を受信リングを通さずに、基準線の解析器（nmea_legacy.c）と gps_parser_feed() へ
+   丸ごと渡し、それぞれ LEG_REPS 回の最短を取る。新しい側は全文種別を解析し、基準線は
+   RMC/GGA 以外を strncmp で捨てるだけなので、話者ごとに全文種別の流れ（all）と
+   RMC/GGA だけの流れ（rg）の2行を出す。仕事が揃うのは rg の行。
+   基準線が受けた RMC/GGA を新しい側が落としていれば（ok が少なければ）1 を返す */
+#define LEG_REPS 5
+
+static void print_header_legacy(void)
+{
+    printf("%-4s %-3s %8s %6s | %9s %9s | %9s %9s | %7s | %15s %15s\n",
+           "tlk", "", "bytes", "lines", "old ns", "old cyc", "new ns", "new cyc", "new/old",
+           "rmc ok old/new", "gga ok old/new");
+}
+
+static int compare_row(const cfg_t *c, const stream_t *st)
+{
+    static gps_parser_t p;
+    uint64_t ns_old = UINT64_MAX, cy_old = UINT64_MAX, ns_new = UINT64_MAX, cy_new = UINT64_MAX;
+    for(int k=0;k<LEG_REPS;k++){
+        nmea_legacy_reset();
+        uint64_t t0 = now_ns(), c0 = rdtsc();
+        (void)nmea_legacy_feed(st->buf, st->len);
+        uint64_t c1 = rdtsc(), t1 = now_ns();
+        if(t1 - t0 < ns_old) ns_old = t1 - t0;
+        if(c1 - c0 < cy_old) cy_old = c1 - c0;
+
+        gps_parser_init(&p);
+        t0 = now_ns(); c0 = rdtsc();
+        (void)gps_parser_feed(&p, st->buf, (uint32_t)st->len);
+        c1 = rdtsc(); t1 = now_ns();
+        if(t1 - t0 < ns_new) ns_new = t1 - t0;
+        if(c1 - c0 < cy_new) cy_new = c1 - c0;
+    }
+
+    nmea_legacy_t lg;
+    nmea_legacy_get(&lg);
+    double n = lg.lines ? (double)lg.lines : 1.0;
+    double ratio = HAVE_TSC ? (cy_old ? (double)cy_new / cy_old : 0.0) : (ns_old ? (double)ns_new / ns_old : 0.0);
+    char rmc[32], gga[32];
+    snprintf(rmc, sizeof rmc, "%u/%u", (unsigned)lg.rmc_ok, (unsigned)p.st.ok[GPS_ST_RMC]);
+    snprintf(gga, sizeof gga, "%u/%u", (unsigned)lg.gga_ok, (unsigned)p.st.ok[GPS_ST_GGA]);
+    printf("%-4s %-3s %8zu %6u | %9.0f %9.0f | %9.0f %9.0f | %7.2f | %15s %15s\n",
+           c->file ? "file" : c->talker, c->rg_only ? "rg" : "all", st->len, (unsigned)lg.lines,
+           (double)ns_old / n, (double)cy_old / n, (double)ns_new / n, (double)cy_new / n, ratio, rmc, gga);
+    return lg.rmc_ok > p.st.ok[GPS_ST_RMC] || lg.gga_ok > p.st.ok[GPS_ST_GGA];
+}
+
+static void usage(void)
+{
+    fputs("usage: nmea_bench [-r Hz] [-b baud] [-t GP|GN|GL|GA|mix] [-s seconds] [-g poll_gap_ms]\n"
+          "                  [-S stall_ms/every_s] [-c badck%] [-x trunc%] [-l long%] [-f file]\n"
+          "                  [-e seed] [-q] [-L]\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    cfg_t c = { 10, 9600, "GP", 10, 10, 0, 0, 0.0, 0.0, 0.0, NULL, 1, 0 };
+    int single = 0, quick = 0, legacy = 0, o;
+    while((o = getopt(argc, argv, "r:b:t:s:g:S:c:x:l:f:e:qLh")) != -1){
+        switch(o){
+        case 'r': c.hz = (uint32_t)atoi(optarg); single = 1; break;
+        case 'b': c.baud = (uint32_t)atoi(optarg); single = 1; break;
+        case 't': c.talker = optarg; single = 1; break;
+        case 's': c.seconds = (uint32_t)atoi(optarg); break;
+        case 'g': c.gap_ms = (uint32_t)atoi(optarg); break;
+        case 'S': if(sscanf(optarg, "%u/%u", &c.stall_ms, &c.stall_every_s) != 2) usage(); break;
+        case 'c': c.badck_pct = atof(optarg); break;
+        case 'x': c.trunc_pct = atof(optarg); break;
+        case 'l': c.long_pct  = atof(optarg); break;
+        case 'f': c.file = optarg; single = 1; break;
+        case 'e': c.seed = (uint32_t)atoi(optarg); break;
+        case 'q': quick = 1; break;
+        case 'L': legacy = 1; break;
+        default:  usage();
+        }
+    }
+    if(quick) c.seconds = 2;
+    if(c.hz == 0U || c.baud == 0U || c.gap_ms == 0U) usage();
+
+    stream_t st;
+    result_t r;
+    if(legacy){
+        printf("a48f8b3 gps_poll_line (old) vs gps_parser_feed (new), %uHz, best of %d, per sentence\n", c.hz, LEG_REPS);
+        print_header_legacy();
+        static const char *const TLK[] = { "GP", "GN", "mix" };   /* 基準線が RMC/GGA を読む話者 */
+        int bad = 0;
+        for(size_t t=0;t<(single ? 1U : sizeof TLK/sizeof TLK[0]);t++){
+            for(uint8_t rg=0;rg<(c.file ? 1U : 2U);rg++){
+                cfg_t k = c;
+                if(!single) k.talker = TLK[t];
+                k.rg_only = rg;
+                build_stream(&st, &k);
+                bad |= compare_row(&k, &st);
+                free(st.buf);
+            }
+        }
+        return bad;
+    }
+
+    printf("GPS_RX_BUF_SZ=%u poll_gap=%ums stall=%ums/%us badck=%.1f%% trunc=%.1f%% long=%.1f%%\n",
+           gps_rx_capacity(), c.gap_ms, c.stall_ms, c.stall_every_s, c.badck_pct, c.trunc_pct, c.long_pct);
+    print_header();
+
+    if(single){
+        build_stream(&st, &c);
+        run(&c, &st, &r);
+        int dup = print_row(&c, &st, &r);
+        free(st.buf);
+        return dup;
+    }
+
+    static const uint32_t HZ[]   = { 1, 5, 10, 20 };
+    static const uint32_t BAUD[] = { 9600, 115200 };
+    static const char *const TLK[] = { "GP", "GN", "GL", "GA", "mix" };
+    int dup = 0;
+    for(size_t b=0;b<sizeof BAUD/sizeof BAUD[0];b++){
+        for(size_t h=0;h<sizeof HZ/sizeof HZ[0];h++){
+            for(size_t t=0;t<sizeof TLK/sizeof TLK[0];t++){
+                cfg_t k = c;
+                k.hz = HZ[h]; k.baud = BAUD[b]; k.talker = TLK[t];
+                build_stream(&st, &k);
+                run(&k, &st, &r);
+                dup |= print_row(&k, &st, &r);
+                free(st.buf);
+            }
+        }
+    }
+    return dup;
+}
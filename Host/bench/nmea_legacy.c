@@ -0,0 +1,263 @@
+#include "nmea_legacy.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+
+/* 当時の既定値。line[] と tmp[] の大きさもこれ */
+#define GPS_RX_BUF_SZ 256
+#define GPS_LAST_SENTENCE_MAX 82
+
+static volatile int g_UTC_hh = -1, g_UTC_mm = -1, g_UTC_ss = -1;
+static volatile int g_UTC_YYYY = -1, g_UTC_MM = -1, g_UTC_DD = -1;
+static volatile int g_LCL_hh = -1, g_LCL_mm = -1, g_LCL_ss = -1;
+static volatile int g_LCL_YYYY = -1, g_LCL_MM = -1, g_LCL_DD = -1;
+static volatile float g_LTT = NAN, g_LGT = NAN, g_ALT = NAN, g_SPD = NAN;
+
+static volatile uint32_t gps_rx_lines = 0;
+static volatile uint32_t gps_rmc_ok = 0, gps_rmc_bad = 0;
+static volatile uint32_t gps_gga_ok = 0, gps_gga_bad = 0;
+static volatile char     gps_last_sentence[GPS_LAST_SENTENCE_MAX];
+
+/* 受信リングの代わり：nmea_legacy_feed() で渡されたバイト列 */
+static const uint8_t *s_in;
+static size_t         s_in_n, s_in_i;
+static inline int  ring_avail(void){ return (int)(s_in_n - s_in_i); }
+static inline int  ring_get(void){ if(s_in_i >= s_in_n) return -1; return (int)s_in[s_in_i++]; }
+
+static char     s_line[GPS_RX_BUF_SZ];
+static uint16_t s_L = 0;
+
+static int    nmea_ck_ok(const char *p, size_t n);
+static int    hexval(char c);
+static int    wrap24(int h){ int x=h%24; if(x<0)x+=24; return x; }
+static int    tz_from_longitude(float lon_deg);
+static int    is_leap(int y);
+static int    dim(int y,int m);
+static void   inc_day(int *y,int *m,int *d);
+static void   dec_day(int *y,int *m,int *d);
+
+void nmea_legacy_reset(void)
+{
+    g_UTC_hh = g_UTC_mm = g_UTC_ss = -1;
+    g_UTC_YYYY = g_UTC_MM = g_UTC_DD = -1;
+    g_LCL_hh = g_LCL_mm = g_LCL_ss = -1;
+    g_LCL_YYYY = g_LCL_MM = g_LCL_DD = -1;
+    g_LTT = g_LGT = g_ALT = g_SPD = NAN;
+    gps_rx_lines = gps_rmc_ok = gps_rmc_bad = gps_gga_ok = gps_gga_bad = 0;
+    gps_last_sentence[0] = '\0';
+    s_L = 0;
+}
+
+void nmea_legacy_get(nmea_legacy_t *out)
+{
+    out->lines  = gps_rx_lines;
+    out->rmc_ok = gps_rmc_ok; out->rmc_bad = gps_rmc_bad;
+    out->gga_ok = gps_gga_ok; out->gga_bad = gps_gga_bad;
+    out->lat = g_LTT; out->lon = g_LGT; out->alt = g_ALT; out->spd = g_SPD;
+    out->utc_hh = g_UTC_hh; out->utc_mm = g_UTC_mm; out->utc_ss = g_UTC_ss;
+    out->lcl_hh = g_LCL_hh;
+}
+
+/* ==== 以下は a48f8b3 の gps.c のまま ================================== */
+static int hexval(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)toupper((unsigned char)c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+static int nmea_ck_ok(const char *p, size_t n)
+{
+    if (!p || n < 4) return 0;
+    size_t i = (p[0] == '$') ? 1 : 0;
+    uint8_t sum = 0; size_t k=i;
+    for(; k<n && p[k] && p[k] != '*'; ++k) sum ^= (uint8_t)p[k];
+    if (k>=n || p[k] != '*') return 0;
+    if (k+2 >= n) return 0;
+    int hi = hexval(p[k+1]), lo = hexval(p[k+2]);
+    if (hi<0 || lo<0) return 0;
+    return (sum == (uint8_t)((hi<<4)|lo));
+}
+
+float nmea_legacy_dm_to_deg(const char *s)
+{
+    if(!s || !*s) return NAN;
+    char *endp = NULL;
+    float v = strtof(s, &endp);
+    if (endp == s) return NAN;
+    int d = (int)(v / 100.0f);
+    float m = v - d * 100.0f;
+    return d + m / 60.0f;
+}
+
+static int tz_from_longitude(float lon_deg)
+{
+    if (isnan(lon_deg)) return 0;
+    float tzf = floorf((lon_deg + 7.5f) / 15.0f);
+    if (tzf < -12.0f) tzf = -12.0f;
+    if (tzf >  14.0f) tzf =  14.0f;
+    return (int)tzf;
+}
+
+static int is_leap(int y){ return ( (y%4==0 && y%100!=0) || (y%400==0) ); }
+static int dim(int y,int m){
+    static const int d[12]={31,28,31,30,31,30,31,31,30,31,30,31};
+    if(m==2) return d[m-1] + (is_leap(y)?1:0);
+    return d[m-1];
+}
+static void inc_day(int *y,int *m,int *d){
+    if(*y<0||*m<1||*d<1) return;
+    (*d)++;
+    int md = dim(*y,*m);
+    if(*d>md){ *d=1; (*m)++; if(*m>12){ *m=1; (*y)++; } }
+}
+static void dec_day(int *y,int *m,int *d){
+    if(*y<0||*m<1||*d<1) return;
+    (*d)--;
+    if(*d<1){ (*m)--; if(*m<1){ *m=12; (*y)--; } *d = dim(*y,*m); }
+}
+
+/* gps_poll_line() の本体（static の line/L をファイルへ出した以外は同じ） */
+uint8_t nmea_legacy_feed(const void *buf, size_t n_in)
+{
+    char     *line = s_line;
+    uint16_t  L = s_L;
+    uint8_t updated = 0;
+    s_in = (const uint8_t *)buf; s_in_n = n_in; s_in_i = 0;
+
+    while(ring_avail() > 0){
+        int ci = ring_get();
+        if(ci < 0) break;
+        char ch = (char)ci;
+        if(ch == '\r') continue;
+
+        if(ch == '\n'){
+            line[L] = '\0';
+            gps_rx_lines++;
+            size_t len = (size_t)L;
+
+            /* ---- RMC ---- */
+            if(L>=6 &&
+               (strncmp(line,"$GPRMC",6)==0 || strncmp(line,"$GNRMC",6)==0) &&
+               nmea_ck_ok(line,len))
+            {
+                size_t n = strlen(line);
+                if(n >= GPS_LAST_SENTENCE_MAX) n = GPS_LAST_SENTENCE_MAX-1;
+                for(size_t i=0;i<n;i++) gps_last_sentence[i]=line[i];
+                gps_last_sentence[n]='\0';
+
+                /* トークン化 */
+                char tmp[GPS_RX_BUF_SZ];
+                strncpy(tmp,line,sizeof(tmp)-1); tmp[sizeof(tmp)-1]='\0';
+                char *fld[20]={0}; int nf=0; fld[nf++]=tmp;
+                for(char *p=tmp; *p && nf<20; ++p){
+                    if(*p==',' || *p=='*'){ *p='\0'; if(*(p+1)) fld[nf++]=p+1; }
+                }
+                /* RMC: 0:$G?RMC,1:time,2:A/V,3:lat,4:N/S,5:lon,6:E/W,7:knots,8:cog,9:date(ddmmyy),... */
+                if(nf>=10){
+                    const char *t   = fld[1]; /* hhmmss.sss */
+                    const char *lat = fld[3]; const char *ns = fld[4];
+                    const char *lon = fld[5]; const char *ew = fld[6];
+                    const char *spk = fld[7]; /* knots */
+                    const char *dmy = fld[9]; /* ddmmyy */
+
+                    /* UTC時刻 */
+                    if(t && strlen(t)>=6 && isdigit((unsigned char)t[0])){
+                        g_UTC_hh = (t[0]-'0')*10 + (t[1]-'0');
+                        g_UTC_mm = (t[2]-'0')*10 + (t[3]-'0');
+                        g_UTC_ss = (t[4]-'0')*10 + (t[5]-'0');
+                    }
+
+                    /* UTC日付（2000+yy） */
+                    if(dmy && strlen(dmy)==6 &&
+                       isdigit((unsigned char)dmy[0]) && isdigit((unsigned char)dmy[1]) &&
+                       isdigit((unsigned char)dmy[2]) && isdigit((unsigned char)dmy[3]) &&
+                       isdigit((unsigned char)dmy[4]) && isdigit((unsigned char)dmy[5]))
+                    {
+                        g_UTC_DD  = (dmy[0]-'0')*10 + (dmy[1]-'0');
+                        g_UTC_MM  = (dmy[2]-'0')*10 + (dmy[3]-'0');
+                        int yy    = (dmy[4]-'0')*10 + (dmy[5]-'0');
+                        g_UTC_YYYY = 2000 + yy;
+                    }
+
+                    /* 位置（float） */
+                    float latd = nmea_legacy_dm_to_deg(lat);
+                    float lond = nmea_legacy_dm_to_deg(lon);
+                    if(!isnan(latd)){ if(ns && *ns=='S') latd = -latd; g_LTT = latd; }
+                    if(!isnan(lond)){ if(ew && *ew=='W') lond = -lond; g_LGT = lond; }
+
+                    /* 速度：knots→m/s（float） */
+                    if(spk && *spk){
+                        char *ep=NULL; float kn = strtof(spk,&ep);
+                        if(ep!=spk) g_SPD = kn * 0.514444f;
+                    }
+
+                    /* === 現地時間・現地日付（UTCとUTC日付が揃っていれば） ==== */
+                    if(g_UTC_hh>=0 && g_UTC_mm>=0 && g_UTC_ss>=0){
+                        /* 分・秒はUTCのまま */
+                        g_LCL_mm = g_UTC_mm;
+                        g_LCL_ss = g_UTC_ss;
+
+                        int tz  = tz_from_longitude(g_LGT);
+                        int lhh = g_UTC_hh + tz;
+
+                        /* UTC日付が未取得なら時だけ正規化（現地日付は据え置き） */
+                        if(g_UTC_YYYY<0 || g_UTC_MM<1 || g_UTC_DD<1){
+                            g_LCL_hh = wrap24(lhh);
+                        }else{
+                            int y=g_UTC_YYYY, m=g_UTC_MM, d=g_UTC_DD;
+                            while(lhh < 0){ lhh += 24; dec_day(&y,&m,&d); }
+                            while(lhh >= 24){ lhh -= 24; inc_day(&y,&m,&d); }
+                            g_LCL_hh = lhh;
+                            g_LCL_YYYY = y; g_LCL_MM = m; g_LCL_DD = d;  /* ← 現地日付確定 */
+                        }
+                    }
+
+                    gps_rmc_ok++; updated |= 1;
+                }else{
+                    gps_rmc_bad++;
+                }
+            }
+            /* ---- GGA ---- */
+            else if(L>=6 &&
+                    (strncmp(line,"$GPGGA",6)==0 || strncmp(line,"$GNGGA",6)==0) &&
+                    nmea_ck_ok(line,len))
+            {
+                size_t n = strlen(line);
+                if(n >= GPS_LAST_SENTENCE_MAX) n = GPS_LAST_SENTENCE_MAX-1;
+                for(size_t i=0;i<n;i++) gps_last_sentence[i]=line[i];
+                gps_last_sentence[n]='\0';
+
+                char tmp[GPS_RX_BUF_SZ];
+                strncpy(tmp,line,sizeof(tmp)-1); tmp[sizeof(tmp)-1]='\0';
+                char *fld[20]={0}; int nf=0; fld[nf++]=tmp;
+                for(char *p=tmp; *p && nf<20; ++p){
+                    if(*p==',' || *p=='*'){ *p='\0'; if(*(p+1)) fld[nf++]=p+1; }
+                }
+                /* 9: alt(m) */
+                if(nf>=11){
+                    const char *alt = fld[9];
+                    if(alt && *alt){
+                        char *ep=NULL; float a = strtof(alt,&ep);
+                        if(ep!=alt) g_ALT = a;
+                    }
+                    gps_gga_ok++; updated |= 2;
+                }else{
+                    gps_gga_bad++;
+                }
+            }else{
+                if(L>=6 && (strncmp(line,"$GPRMC",6)==0 || strncmp(line,"$GNRMC",6)==0)) gps_rmc_bad++;
+                else if(L>=6 && (strncmp(line,"$GPGGA",6)==0 || strncmp(line,"$GNGGA",6)==0)) gps_gga_bad++;
+            }
+
+            L = 0;
+        }else{
+            if(L < GPS_RX_BUF_SZ-1) line[L++] = ch;
+            else L = 0;
+        }
+    }
+
+    s_L = L;
+    return updated;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 基準線（a48f8b3）の NMEA 解析をホスト専用に写したもの =====
+   比較の物差し。行を line[] に溜め、'\n' で nmea_ck_ok() → strncpy で tmp[] へ複写 →
+   ',' '*' で切り、RMC/GGA だけを float（strtof）で読む。受信リングの代わりに渡した
+   バイト列を読む以外は当時のまま。状態は全部このファイルの static（1つだけ） */
+
+typedef struct {
+    uint32_t lines;
+    uint32_t rmc_ok, rmc_bad;
+    uint32_t gga_ok, gga_bad;
+    float    lat, lon, alt, spd;       /* g_LTT / g_LGT / g_ALT / g_SPD */
+    int      utc_hh, utc_mm, utc_ss;
+    int      lcl_hh;
+} nmea_legacy_t;
+
+void    nmea_legacy_reset(void);
+uint8_t nmea_legacy_feed(const void *buf, size_t n);   /* 返値: 1=RMC 2=GGA（gps_poll_line と同じ） */
+void    nmea_legacy_get(nmea_legacy_t *out);
+
+/* 当時の ddmm.mmmm → 度（strtof を通す）。空・数字なしは NAN */
+float   nmea_legacy_dm_to_deg(const char *s);
+
+#ifdef __cplusplus
+}
+#endif
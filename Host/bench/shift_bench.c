@@ -0,0 +1,98 @@
+/* 表示フレーム送出の計測。nixie.c の送出（NIXIE_USE_DMA=1 は TIM1＋DMA、0 は CPU の直書き）を
+   tube_sim で受け、1フレームあたりのホスト CPU 時間、GPIO 書込み数、仮想時間でのシフト時間と
+   ラッチの遅れ、グリッチを報告する。送出の手順を変えたときの比較用。
+
+     shift_bench                 既定（5000 フレーム、毎回違う表示）
+     shift_bench -n 100000
+     shift_bench -p              PWM リフレッシュを動かしたまま（半分の輝度）
+     shift_bench -v              フレームを端末へ描く（先頭 -n 件）
+
+   どちらの送出かはビルド時の値（cmake -DCMAKE_C_FLAGS=-DNIXIE_USE_DMA=0 など）。
+   グリッチ（途中でのラッチ・数字の2重点灯）があれば終了コード 1 */
+#include "hal_fake.h"
+#include "nixie.h"
+#include "tube_sim.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void)
+{
+    fputs("usage: shift_bench [-n frames] [-p] [-v]\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n = 5000U;
+    int pwm = 0, verbose = 0, o;
+    while((o = getopt(argc, argv, "n:pvh")) != -1){
+        switch(o){
+        case 'n': n = (uint32_t)atoi(optarg); break;
+        case 'p': pwm = 1; break;
+        case 'v': verbose = 1; break;
+        default:  usage();
+        }
+    }
+    if(n == 0U) usage();
+
+    static tube_sim_t sim;
+    ts_frame_t *log = verbose ? (ts_frame_t*)calloc(n * 2U, sizeof *log) : NULL;
+    hal_fake_reset();
+    tube_sim_attach(&sim, log, verbose ? n * 2U : 0U);
+    hal_fake_set_isr(TIM6_DAC1_IRQn, nixie_pwm_irq);
+#if NIXIE_USE_DMA
+    hal_fake_set_isr(DMA1_Channel3_IRQn, nixie_dma_irq);
+#endif
+    nixie_init();
+    if(pwm){
+        nixie_pwm_start();
+        nixie_set_brightness(NIXIE_PWM_STEPS / 2U);
+    }
+
+    /* 1秒ごとの時刻表示を 1ms 間隔で詰めて送る（フレームの中身は毎回変わる） */
+    uint64_t host = 0;
+    uint32_t w0 = hal_fake_gpio_writes, shown = 0;
+    for(uint32_t i=0;i<n;i++){
+        uint32_t s = i % 86400U;
+        uint16_t v[8];
+        nixie_time_codes((uint8_t)(s / 3600U), (uint8_t)(s / 60U % 60U), (uint8_t)(s % 60U), v);
+        uint64_t t0 = now_ns();
+        nixie_show_codes(v);
+        host += now_ns() - t0;
+        hal_fake_advance_us(1000U);
+
+        uint16_t got[8];
+        tube_sim_shown(&sim, got);
+        if(!pwm && memcmp(got, v, sizeof v) == 0) shown++;
+    }
+
+    if(verbose){
+        char line[96];
+        for(uint32_t i=0;i<sim.n_log;i++){
+            tube_sim_render_frame(&log[i], line, sizeof line);
+            printf("%s shift=%.2fus latch=%.2fus\n", line,
+                   (double)log[i].shift_ticks * 1e6 / HAL_FAKE_TIM_HZ, (double)log[i].latch_ticks * 1e6 / HAL_FAKE_TIM_HZ);
+        }
+    }
+
+    printf("NIXIE_USE_DMA=%d pwm=%d frames=%u latches=%u glitches=%u\n",
+           NIXIE_USE_DMA, pwm, n, sim.n_stcp, sim.n_glitch);
+    printf("host %.1f ns/frame  gpio writes %.1f/latch\n",
+           (double)host / n, sim.n_stcp ? (double)(hal_fake_gpio_writes - w0) / sim.n_stcp : 0.0);
+    printf("shift avg %.2fus max %.2fus  latch delay max %.2fus\n",
+           sim.n_full ? (double)sim.sum_shift / sim.n_full * 1e6 / HAL_FAKE_TIM_HZ : 0.0,
+           (double)sim.max_shift * 1e6 / HAL_FAKE_TIM_HZ, (double)sim.max_latch * 1e6 / HAL_FAKE_TIM_HZ);
+    if(!pwm) printf("shown as requested %u/%u\n", shown, n);
+    free(log);
+    return (sim.n_glitch || (!pwm && shown != n)) ? 1 : 0;
+}
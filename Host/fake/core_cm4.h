@@ -0,0 +1,97 @@
+/* ホスト用 core_cm4.h の代用品。
+   デバイスヘッダ（stm32f303x8.h）が必要とする修飾子と、本体コードが使う
+   割込みマスク・バリア命令だけを C で置き換える。割込みマスクは hal_fake.c が持ち、
+   マスク解除時に保留中の割込みを配送する */
+#ifndef HOST_FAKE_CORE_CM4_H
+#define HOST_FAKE_CORE_CM4_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __CM4_CMSIS_VERSION_MAIN  (5U)
+#define __CM4_CMSIS_VERSION_SUB   (1U)
+#define __CORTEX_M                (4U)
+
+#define __I     volatile const
+#define __O     volatile
+#define __IO    volatile
+#define __IM    volatile const
+#define __OM    volatile
+#define __IOM   volatile
+
+#ifndef __ASM
+#define __ASM                     __asm
+#endif
+#ifndef __INLINE
+#define __INLINE                  inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE           static inline
+#endif
+#ifndef __STATIC_FORCEINLINE
+#define __STATIC_FORCEINLINE      static inline
+#endif
+#ifndef __NO_RETURN
+#define __NO_RETURN               __attribute__((__noreturn__))
+#endif
+#ifndef __USED
+#define __USED                    __attribute__((used))
+#endif
+#ifndef __WEAK
+#define __WEAK                    __attribute__((weak))
+#endif
+#ifndef __PACKED
+#define __PACKED                  __attribute__((packed, aligned(1)))
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED(x)              __attribute__((aligned(x)))
+#endif
+
+/* ==== 区間計測用の DWT / CoreDebug（prof.c が触る分だけ、実体は hal_fake.c） ==== */
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+typedef struct {
+    volatile uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+#define DWT_CTRL_CYCCNTENA_Msk         (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk     (1UL << 24)
+extern DWT_Type       hal_fake_DWT;
+extern CoreDebug_Type hal_fake_CoreDebug;
+#define DWT            (&hal_fake_DWT)
+#define CoreDebug      (&hal_fake_CoreDebug)
+
+/* ==== SCB（idle.c が SCR を触る分だけ） ==== */
+typedef struct {
+    volatile uint32_t SCR;
+} SCB_Type;
+#define SCB_SCR_SLEEPONEXIT_Msk        (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk          (1UL << 2)
+extern SCB_Type       hal_fake_SCB;
+#define SCB            (&hal_fake_SCB)
+
+/* ==== 割込みマスク（hal_fake.c） ==== */
+uint32_t hal_fake_get_primask(void);
+void     hal_fake_set_primask(uint32_t pm);
+void     hal_fake_wfi(void);
+
+static inline uint32_t __get_PRIMASK(void){ return hal_fake_get_primask(); }
+static inline void     __set_PRIMASK(uint32_t pm){ hal_fake_set_primask(pm); }
+static inline void     __disable_irq(void){ hal_fake_set_primask(1U); }
+static inline void     __enable_irq(void){ hal_fake_set_primask(0U); }
+
+static inline void __DMB(void){ __sync_synchronize(); }
+static inline void __DSB(void){ __sync_synchronize(); }
+static inline void __ISB(void){ __sync_synchronize(); }
+static inline void __NOP(void){ }
+static inline void __WFI(void){ hal_fake_wfi(); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FAKE_CORE_CM4_H */
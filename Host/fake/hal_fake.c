@@ -0,0 +1,694 @@
+#include "hal_fake.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ==== 周辺レジスタの実体 ============================================= */
+GPIO_TypeDef        hal_fake_GPIOA, hal_fake_GPIOB, hal_fake_GPIOF;
+TIM_TypeDef         hal_fake_TIM1, hal_fake_TIM2, hal_fake_TIM3, hal_fake_TIM6;
+DMA_TypeDef         hal_fake_DMA1;
+DMA_Channel_TypeDef hal_fake_DMA1_Ch[7];
+RCC_TypeDef         hal_fake_RCC;
+USART_TypeDef       hal_fake_USART1, hal_fake_USART2;
+EXTI_TypeDef        hal_fake_EXTI;
+SYSCFG_TypeDef      hal_fake_SYSCFG;
+DWT_Type            hal_fake_DWT;
+CoreDebug_Type      hal_fake_CoreDebug;
+SCB_Type            hal_fake_SCB;
+uint32_t            SystemCoreClock = 2U * HAL_FAKE_TIM_HZ;
+
+UART_HandleTypeDef huart1;
+UART_HandleTypeDef huart2;
+DMA_HandleTypeDef  hdma_usart1_rx;
+
+uint32_t hal_fake_gpio_writes  = 0;
+uint32_t hal_fake_uart_dropped = 0;
+uint32_t hal_fake_flash_progs  = 0;
+uint32_t hal_fake_flash_erases[HAL_FAKE_FLASH_PAGES];
+
+/* ==== 状態 =========================================================== */
+#define NIRQ 96
+
+static uint64_t             s_now;             /* 仮想時間 [tick] */
+static uint32_t             s_primask;
+static uint8_t              s_in_isr;
+static uint8_t              s_wfi, s_woke;     /* WFI 中／その間に割込みが来た */
+static uint8_t              s_irq_en[NIRQ], s_irq_prio[NIRQ];
+static uint64_t             s_pend[2];         /* 保留中の割込み（bit i = IRQ 64*w+i） */
+static hal_fake_isr_t       s_isr[NIRQ];
+static hal_fake_gpio_hook_t s_gpio_hook;
+static void                *s_gpio_ctx;
+static hal_fake_input_t     s_in_fn;           /* 外部入力の予定 */
+static void                *s_in_ctx;
+static uint64_t             s_in_due = UINT64_MAX;
+static uint8_t              s_in_busy;         /* fn の中（入れ子で呼ばない） */
+static uint8_t              s_hold;            /* 割込みを保留だけにする（tim1_run の中） */
+
+/* 書込みで消えるフラグ（TIM SR は 0 書込みでクリア、DMA は IFCR でクリア）の実際値 */
+static uint32_t             s_tim_sr[4];
+static uint32_t             s_dma_isr;
+/* DMA チャネルの転送位置。CNDTR が書き換えられたら再設定とみなす */
+static uint32_t             s_dma_off[7], s_dma_len[7], s_dma_ndtr[7];
+/* TIM のプリスケーラ内の端数 */
+static uint32_t             s_psc_acc[4];
+/* ReceiveToIdle_DMA の書込み位置 */
+static uint16_t             s_urx_pos;
+/* HAL_UART_Transmit と TDR への DMA 書込みの送出分（USART1/USART2） */
+#define UTX_CAP 4096
+static uint8_t              s_utx[2][UTX_CAP];
+static uint32_t             s_utx_n[2];
+/* USART2 送信 DMA（DMA1 Ch7）：次の1バイトを TDR へ運ぶ時刻。0=停止中 */
+static uint64_t             s_utx_due;
+
+/* フラッシュ模型（kv.c）。非 PIE なので 32bit アドレスで渡せる */
+#define FLASH_PAGE 2048U
+static uint16_t             s_flash[HAL_FAKE_FLASH_PAGES * FLASH_PAGE / 2U];
+static int32_t              s_flash_cut = -1;  /* あと何回の操作で電源断か（-1=なし） */
+static uint8_t              s_flash_dead;
+static uint8_t              s_flash_on;        /* 初回に消去済みの状態にする */
+
+/* RTC 模型（rtc.c）。時刻は s_rtc_s + (s_now − s_rtc_at) / HAL_FAKE_TIM_HZ */
+static uint8_t              s_rtc_on;
+static int64_t              s_rtc_s, s_rtc_at;
+
+static TIM_TypeDef *const S_TIM[4] = { &hal_fake_TIM1, &hal_fake_TIM2, &hal_fake_TIM3, &hal_fake_TIM6 };
+static GPIO_TypeDef *const S_GPIO[3] = { &hal_fake_GPIOA, &hal_fake_GPIOB, &hal_fake_GPIOF };
+
+/* ==== 内部 =========================================================== */
+static int tim_index(const TIM_TypeDef *t)
+{
+    for(int i=0;i<4;i++) if(S_TIM[i] == t) return i;
+    return -1;
+}
+
+static int port_index(const GPIO_TypeDef *p)
+{
+    return (p == &hal_fake_GPIOA) ? 0 : (p == &hal_fake_GPIOB) ? 1 : (p == &hal_fake_GPIOF) ? 2 : -1;
+}
+
+/* USART2 送信 DMA が動ける状態か（DMAT・チャネル有効・残りあり） */
+static int utx_dma_on(void)
+{
+    const DMA_Channel_TypeDef *ch = &hal_fake_DMA1_Ch[6];
+    return (hal_fake_USART2.CR3 & USART_CR3_DMAT) && (ch->CCR & DMA_CCR_EN) && ch->CNDTR != 0U;
+}
+
+static uint64_t utx_byte_ticks(void)   /* 8N1 の1文字時間 */
+{
+    uint32_t baud = huart2.Init.BaudRate ? huart2.Init.BaudRate : 38400U;
+    return (uint64_t)HAL_FAKE_TIM_HZ * 10U / baud;
+}
+
+static void utx_put(int u, uint8_t b)
+{
+    if(s_utx_n[u] < UTX_CAP) s_utx[u][s_utx_n[u]++] = b;
+}
+
+/* 本体が書いたレジスタの副作用を反映（本フェイクへ入るたびに呼ぶ） */
+static void regs_sync(void)
+{
+    for(int i=0;i<4;i++){
+        s_tim_sr[i] &= S_TIM[i]->SR;              /* rc_w0：0 を書いたビットだけ消える */
+        S_TIM[i]->SR = s_tim_sr[i];
+    }
+    uint32_t ifcr = hal_fake_DMA1.IFCR;
+    if(ifcr){
+        for(int c=0;c<7;c++){
+            uint32_t nib = (ifcr >> (4*c)) & 0xFU;
+            if(nib & 1U) nib = 0xFU;              /* CGIF は4ビットとも */
+            s_dma_isr &= ~(nib << (4*c));
+        }
+        hal_fake_DMA1.IFCR = 0;
+    }
+    hal_fake_DMA1.ISR  = s_dma_isr;
+
+    for(int p=0;p<3;p++){                          /* 直書きされた BSRR/BRR（最後の1回分） */
+        uint32_t bsrr = S_GPIO[p]->BSRR, brr = S_GPIO[p]->BRR;
+        S_GPIO[p]->BSRR = 0; S_GPIO[p]->BRR = 0;
+        if(bsrr) hal_fake_gpio_bsrr(S_GPIO[p], bsrr);
+        if(brr)  hal_fake_gpio_bsrr(S_GPIO[p], brr << 16);
+    }
+
+    if(!utx_dma_on())    s_utx_due = 0;
+    else if(!s_utx_due)  s_utx_due = s_now + utx_byte_ticks();
+}
+
+static uint8_t irq_pending(void)
+{
+    for(int w=0;w<2;w++){
+        for(uint64_t m=s_pend[w]; m; m &= m - 1U) if(s_irq_en[64*w + __builtin_ctzll(m)]) return 1;
+    }
+    return 0;
+}
+
+static void irq_dispatch(void)
+{
+    while(!s_primask && !s_in_isr && (s_pend[0] | s_pend[1])){
+        int best = -1;
+        for(int w=0;w<2;w++){
+            for(uint64_t m=s_pend[w]; m; m &= m - 1U){
+                int i = 64*w + __builtin_ctzll(m);
+                if(!s_irq_en[i]) continue;
+                if(best < 0 || s_irq_prio[i] < s_irq_prio[best]) best = i;
+            }
+        }
+        if(best < 0) return;
+        s_pend[best / 64] &= ~(1ULL << (best % 64));
+        if(!s_isr[best]) continue;
+        s_woke = 1;
+        s_in_isr = 1;
+        s_isr[best]();
+        s_in_isr = 0;
+        regs_sync();
+    }
+}
+
+static void tim_flag(int ti, uint32_t f){ s_tim_sr[ti] |= f; S_TIM[ti]->SR = s_tim_sr[ti]; }
+static void dma_flag(int c, uint32_t f){ s_dma_isr |= (f | 1U) << (4*c); hal_fake_DMA1.ISR = s_dma_isr; }
+
+/* 周辺アドレスへの書込み（BSRR/BRR はトレースへ） */
+static void periph_write(uint32_t addr, uint32_t v, uint32_t size)
+{
+    for(int p=0;p<3;p++){
+        if(addr == (uint32_t)(uintptr_t)&S_GPIO[p]->BSRR){ hal_fake_gpio_bsrr(S_GPIO[p], v); return; }
+        if(addr == (uint32_t)(uintptr_t)&S_GPIO[p]->BRR) { hal_fake_gpio_bsrr(S_GPIO[p], v << 16); return; }
+    }
+    if(addr == (uint32_t)(uintptr_t)&hal_fake_USART1.TDR){ utx_put(0, (uint8_t)v); return; }
+    if(addr == (uint32_t)(uintptr_t)&hal_fake_USART2.TDR){ utx_put(1, (uint8_t)v); return; }
+    void *d = (void*)(uintptr_t)addr;
+    if(size == 4U) *(volatile uint32_t*)d = v;
+    else if(size == 2U) *(volatile uint16_t*)d = (uint16_t)v;
+    else *(volatile uint8_t*)d = (uint8_t)v;
+}
+
+static uint32_t mem_read(uint32_t addr, uint32_t size)
+{
+    const void *s = (const void*)(uintptr_t)addr;
+    return (size == 4U) ? *(const volatile uint32_t*)s : (size == 2U) ? *(const volatile uint16_t*)s
+                                                                        : *(const volatile uint8_t*)s;
+}
+
+/* DMA1 チャネル c（0始まり）へ1要求 */
+static void dma_request(int c)
+{
+    DMA_Channel_TypeDef *ch = &hal_fake_DMA1_Ch[c];
+    if(!(ch->CCR & DMA_CCR_EN) || ch->CNDTR == 0U) return;
+    if(ch->CNDTR != s_dma_ndtr[c]){ s_dma_off[c] = 0; s_dma_len[c] = ch->CNDTR; }
+
+    uint32_t ms = 1U << ((ch->CCR & DMA_CCR_MSIZE) >> DMA_CCR_MSIZE_Pos);
+    uint32_t ps = 1U << ((ch->CCR & DMA_CCR_PSIZE) >> DMA_CCR_PSIZE_Pos);
+    uint32_t ma = ch->CMAR + ((ch->CCR & DMA_CCR_MINC) ? s_dma_off[c] * ms : 0U);
+    uint32_t pa = ch->CPAR + ((ch->CCR & DMA_CCR_PINC) ? s_dma_off[c] * ps : 0U);
+    if(ch->CCR & DMA_CCR_DIR) periph_write(pa, mem_read(ma, ms), ps);
+    else                      periph_write(ma, mem_read(pa, ps), ms);
+
+    s_dma_off[c]++;
+    ch->CNDTR--;
+    uint8_t ht = (ch->CNDTR == s_dma_len[c] / 2U), tc = (ch->CNDTR == 0U);
+    if(tc && (ch->CCR & DMA_CCR_CIRC)){ ch->CNDTR = s_dma_len[c]; s_dma_off[c] = 0; }
+    /* 割込みはその場で配送され、ハンドラが再設定することがあるので、記録を先に */
+    s_dma_ndtr[c] = ch->CNDTR;
+    if(ht){
+        dma_flag(c, DMA_ISR_HTIF1);
+        if(ch->CCR & DMA_CCR_HTIE) hal_fake_raise((IRQn_Type)(DMA1_Channel1_IRQn + c));
+    }
+    if(tc){
+        dma_flag(c, DMA_ISR_TCIF1);
+        if(ch->CCR & DMA_CCR_TCIE) hal_fake_raise((IRQn_Type)(DMA1_Channel1_IRQn + c));
+    }
+}
+
+static uint64_t tim_to_update(int ti)
+{
+    TIM_TypeDef *t = S_TIM[ti];
+    uint64_t cnt_left = (uint64_t)t->ARR - t->CNT + 1U;
+    if(t->PSC == 0U) return cnt_left;
+    return cnt_left * (t->PSC + 1U) - s_psc_acc[ti];
+}
+
+/* ticks だけ進める（更新イベントを跨がない量で呼ぶ）。返値: 更新イベントが起きたら1 */
+static int tim_step(int ti, uint64_t ticks)
+{
+    TIM_TypeDef *t = S_TIM[ti];
+    uint64_t c;
+    if(t->PSC == 0U){                             /* 本体のタイマは全部これ（割り算を省く） */
+        c = (uint64_t)t->CNT + ticks;
+        if(c > t->ARR){ t->CNT = (uint32_t)(c - t->ARR - 1U); return 1; }
+        t->CNT = (uint32_t)c;
+        return 0;
+    }
+    uint64_t acc = s_psc_acc[ti] + ticks;
+    uint64_t inc = acc / (t->PSC + 1U);
+    s_psc_acc[ti] = (uint32_t)(acc % (t->PSC + 1U));
+    c = (uint64_t)t->CNT + inc;
+    if(c > t->ARR){ t->CNT = (uint32_t)(c - t->ARR - 1U); return 1; }
+    t->CNT = (uint32_t)c;
+    return 0;
+}
+
+/* TIM1 の比較チャネル k の一致：フラグと DMA 要求。CH1→Ch2, CH2→Ch3, CH4→Ch4, CH3→Ch6 */
+static void tim1_compare(int k)
+{
+    static const int8_t CH_DMA[4] = { 1, 2, 5, 3 };
+    tim_flag(0, TIM_SR_CC1IF << k);
+    if(hal_fake_TIM1.DIER & (TIM_DIER_CC1DE << k)) dma_request(CH_DMA[k]);
+}
+
+/* TIM1 を最大 lim tick 進め、その間の比較一致と更新をそれぞれの時刻（s_now）で処理する。
+   lim は他の事象（他のタイマの更新・送信 DMA・外部入力）の手前までなので、DMA の1フレーム
+   （24周期・48回の BSRR 書込み）は普通ここを1回通るだけで済む。割込みは保留だけにして、
+   新しく保留になったら（転送完了など）その時点で戻る。その間は本体が動かずレジスタも
+   変わらないので、一致の順（CCR 昇順、ARR 以下）は最初に1回だけ並べる。返値: 進めた tick */
+static uint64_t tim1_run(uint64_t lim)
+{
+    TIM_TypeDef *t = &hal_fake_TIM1;
+    const uint32_t ccr[4] = { t->CCR1, t->CCR2, t->CCR3, t->CCR4 };
+    int8_t ord[4];
+    int n = 0;
+    for(int k=0;k<4;k++){
+        if(ccr[k] > t->ARR) continue;
+        int i = n++;
+        for(; i > 0 && ccr[ord[i-1]] > ccr[k]; i--) ord[i] = ord[i-1];
+        ord[i] = (int8_t)k;
+    }
+    int j = 0;                                    /* この周期で次に一致するもの（ord の添字） */
+    while(j < n && ccr[ord[j]] <= t->CNT) j++;
+
+    uint64_t used = 0, p0 = s_pend[0], p1 = s_pend[1];
+    uint64_t div = (uint64_t)t->PSC + 1U;
+    s_hold = 1;
+    while(used < lim){
+        uint32_t at = (j < n) ? ccr[ord[j]] : t->ARR + 1U;   /* 次の一致か更新のカウント値 */
+        uint64_t d = (at - t->CNT) * div - s_psc_acc[0];
+        if(d > lim - used){
+            tim_step(0, lim - used);
+            s_now += lim - used;
+            used = lim;
+            break;
+        }
+        s_now += d;
+        used  += d;
+        s_psc_acc[0] = 0;
+        if(j < n){
+            t->CNT = at;
+            tim1_compare(ord[j++]);
+        }else{
+            t->CNT = 0;
+            tim_flag(0, TIM_SR_UIF);
+            for(j = 0; j < n && ccr[ord[j]] == 0U; j++) tim1_compare(ord[j]);
+        }
+        if(s_pend[0] != p0 || s_pend[1] != p1) break;
+    }
+    s_hold = 0;
+    return used;
+}
+
+/* ==== ハーネス API =================================================== */
+void hal_fake_reset(void)
+{
+    if((uintptr_t)&hal_fake_GPIOA > 0xFFFFFFFFU){
+        fprintf(stderr, "hal_fake: DMA のアドレスが32bitに入らない（-no-pie でリンクすること）\n");
+        abort();
+    }
+    memset(&hal_fake_GPIOA, 0, sizeof hal_fake_GPIOA);
+    memset(&hal_fake_GPIOB, 0, sizeof hal_fake_GPIOB);
+    memset(&hal_fake_GPIOF, 0, sizeof hal_fake_GPIOF);
+    for(int i=0;i<4;i++){ memset(S_TIM[i], 0, sizeof(TIM_TypeDef)); S_TIM[i]->ARR = 0xFFFFU; }
+    memset(&hal_fake_DMA1, 0, sizeof hal_fake_DMA1);
+    memset(hal_fake_DMA1_Ch, 0, sizeof hal_fake_DMA1_Ch);
+    memset(&hal_fake_RCC, 0, sizeof hal_fake_RCC);
+    memset(&hal_fake_USART1, 0, sizeof hal_fake_USART1);
+    memset(&hal_fake_USART2, 0, sizeof hal_fake_USART2);
+    memset(&hal_fake_EXTI, 0, sizeof hal_fake_EXTI);
+    memset(&hal_fake_SYSCFG, 0, sizeof hal_fake_SYSCFG);
+    memset(&hal_fake_DWT, 0, sizeof hal_fake_DWT);
+    memset(&hal_fake_CoreDebug, 0, sizeof hal_fake_CoreDebug);
+    memset(&hal_fake_SCB, 0, sizeof hal_fake_SCB);
+
+    s_rtc_at -= (int64_t)s_now;                  /* RTC はリセットを跨いで進み続ける */
+    s_now = 0; s_primask = 0; s_in_isr = 0; s_wfi = 0; s_woke = 0;
+    memset(s_irq_en, 0, sizeof s_irq_en);
+    s_pend[0] = s_pend[1] = 0;
+    memset(s_irq_prio, 0, sizeof s_irq_prio);
+    memset(s_isr, 0, sizeof s_isr);
+    memset(s_tim_sr, 0, sizeof s_tim_sr);
+    memset(s_psc_acc, 0, sizeof s_psc_acc);
+    memset(s_dma_off, 0, sizeof s_dma_off);
+    memset(s_dma_len, 0, sizeof s_dma_len);
+    memset(s_dma_ndtr, 0, sizeof s_dma_ndtr);
+    s_dma_isr = 0; s_urx_pos = 0;
+    s_utx_n[0] = s_utx_n[1] = 0;
+    s_utx_due = 0;
+    s_gpio_hook = NULL; s_gpio_ctx = NULL;
+    s_in_fn = NULL; s_in_ctx = NULL; s_in_due = UINT64_MAX; s_in_busy = 0;
+    hal_fake_gpio_writes = 0;
+    hal_fake_uart_dropped = 0;
+
+    memset(&hdma_usart1_rx, 0, sizeof hdma_usart1_rx);
+    hdma_usart1_rx.Instance = DMA1_Channel5;
+    memset(&huart1, 0, sizeof huart1);
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = 9600;
+    huart1.hdmarx = &hdma_usart1_rx;
+    huart1.gState = huart1.RxState = HAL_UART_STATE_READY;
+    memset(&huart2, 0, sizeof huart2);
+    huart2.Instance = USART2;
+    huart2.Init.BaudRate = 38400;
+    huart2.gState = huart2.RxState = HAL_UART_STATE_READY;
+}
+
+uint64_t hal_fake_now_ticks(void){ return s_now; }
+
+static void input_run(void)
+{
+    if(!s_in_fn || s_in_busy || s_now < s_in_due) return;
+    s_in_busy = 1;
+    s_in_due = s_in_fn(s_in_ctx, s_now);
+    s_in_busy = 0;
+}
+
+void hal_fake_set_input(hal_fake_input_t fn, void *ctx)
+{
+    s_in_fn = fn; s_in_ctx = ctx; s_in_due = 0;
+    input_run();
+}
+
+void     hal_fake_advance_us(uint64_t us){ hal_fake_advance_ticks(us * (HAL_FAKE_TIM_HZ / 1000000U)); }
+
+void hal_fake_advance_ticks(uint64_t ticks)
+{
+    regs_sync();
+    while(ticks){
+        uint64_t step = ticks;
+        for(int i=1;i<4;i++){
+            if(!(S_TIM[i]->CR1 & TIM_CR1_CEN)) continue;
+            uint64_t u = tim_to_update(i);
+            if(u < step) step = u;
+        }
+        if(s_utx_due && s_utx_due - s_now < step) step = s_utx_due - s_now;
+        if(s_in_fn && !s_in_busy && s_in_due - s_now < step) step = s_in_due - s_now;
+        if(S_TIM[0]->CR1 & TIM_CR1_CEN) step = tim1_run(step);   /* s_now も進む */
+        else                            s_now += step;
+        uint8_t upd = 0;
+        for(int i=1;i<4;i++){
+            if((S_TIM[i]->CR1 & TIM_CR1_CEN) && tim_step(i, step)) upd |= (uint8_t)(1U << i);
+        }
+        ticks -= step;
+
+        for(int i=1;i<4;i++){
+            if(!(upd & (1U << i))) continue;
+            tim_flag(i, TIM_SR_UIF);
+            if(i == 3 && (S_TIM[3]->DIER & TIM_DIER_UIE)) hal_fake_raise(TIM6_DAC1_IRQn);
+        }
+        if(s_utx_due && s_now >= s_utx_due){
+            dma_request(6);
+            s_utx_due = utx_dma_on() ? s_utx_due + utx_byte_ticks() : 0U;
+        }
+        irq_dispatch();
+        input_run();
+        if(s_wfi && (s_woke || irq_pending())) break;   /* WFI は割込みで戻る */
+    }
+}
+
+void hal_fake_set_isr(IRQn_Type irq, hal_fake_isr_t fn)
+{
+    if((int)irq >= 0 && (int)irq < NIRQ) s_isr[irq] = fn;
+}
+
+void hal_fake_raise(IRQn_Type irq)
+{
+    if((int)irq < 0 || (int)irq >= NIRQ) return;
+    s_pend[irq / 64] |= 1ULL << (irq % 64);
+    if(!s_hold) irq_dispatch();
+}
+
+void hal_fake_tim_capture(TIM_TypeDef *tim, uint8_t ch)
+{
+    int ti = tim_index(tim);
+    if(ti < 0 || ch < 1U || ch > 4U) return;
+    regs_sync();
+    volatile uint32_t *ccr[4] = { &tim->CCR1, &tim->CCR2, &tim->CCR3, &tim->CCR4 };
+    *ccr[ch-1U] = tim->CNT;
+    uint32_t f = TIM_SR_CC1IF << (ch-1U);
+    if(s_tim_sr[ti] & f) tim_flag(ti, TIM_SR_CC1OF << (ch-1U));
+    tim_flag(ti, f);
+    if(tim->DIER & (TIM_DIER_CC1IE << (ch-1U))){
+        static const IRQn_Type IRQ[4] = { TIM1_CC_IRQn, TIM2_IRQn, TIM3_IRQn, TIM6_DAC1_IRQn };
+        hal_fake_raise(IRQ[ti]);
+    }
+}
+
+void hal_fake_set_gpio_hook(hal_fake_gpio_hook_t fn, void *ctx){ s_gpio_hook = fn; s_gpio_ctx = ctx; }
+
+void hal_fake_gpio_bsrr(GPIO_TypeDef *port, uint32_t w)
+{
+    int pi = port_index(port);
+    uint16_t before = (uint16_t)port->ODR;
+    uint16_t after  = (uint16_t)((before & ~(w >> 16)) | (w & 0xFFFFU));   /* set が優先 */
+    port->ODR = after;
+    hal_fake_gpio_writes++;
+    if(after != before && s_gpio_hook && pi >= 0) s_gpio_hook(s_gpio_ctx, (uint8_t)pi, before, after);
+}
+
+void hal_fake_gpio_input(GPIO_TypeDef *port, uint16_t pin, uint8_t level)
+{
+    if(level) port->IDR |= pin; else port->IDR &= ~(uint32_t)pin;
+}
+
+void hal_fake_exti(uint16_t pin)
+{
+    s_woke = 1;
+    s_in_isr++;
+    HAL_GPIO_EXTI_Callback(pin);
+    s_in_isr--;
+    regs_sync();
+    irq_dispatch();
+}
+
+void hal_fake_uart_inject(UART_HandleTypeDef *hu, const uint8_t *p, uint32_t n)
+{
+    uint16_t since = 0;           /* 直近の RxEvent 以降に DMA で入ったバイト */
+    s_woke = 1;
+    s_in_isr++;
+    for(uint32_t i=0;i<n;i++){
+        if(hu->RxState != HAL_UART_STATE_BUSY_RX){ hal_fake_uart_dropped++; continue; }
+        if(hu->ReceptionType == HAL_UART_RECEPTION_TOIDLE && hu->hdmarx){
+            DMA_Channel_TypeDef *ch = hu->hdmarx->Instance;
+            hu->pRxBuffPtr[s_urx_pos++] = p[i];
+            since++;
+            if(--ch->CNDTR == 0U){
+                ch->CNDTR = hu->RxXferSize; s_urx_pos = 0; since = 0;
+                HAL_UARTEx_RxEventCallback(hu, hu->RxXferSize);
+            }else if(s_urx_pos == hu->RxXferSize / 2U){
+                since = 0;
+                HAL_UARTEx_RxEventCallback(hu, s_urx_pos);
+            }
+        }else{
+            *hu->pRxBuffPtr++ = p[i];
+            if(--hu->RxXferCount == 0U){
+                hu->RxState = HAL_UART_STATE_READY;
+                HAL_UART_RxCpltCallback(hu);
+            }
+        }
+    }
+    if(since) HAL_UARTEx_RxEventCallback(hu, s_urx_pos);   /* 行末の IDLE */
+    s_in_isr--;
+    regs_sync();
+    irq_dispatch();
+}
+
+/* ==== core_cm4.h の代用 ============================================== */
+uint32_t hal_fake_get_primask(void){ return s_primask; }
+void hal_fake_set_primask(uint32_t pm)
+{
+    s_primask = pm & 1U;
+    if(!s_primask && (s_pend[0] | s_pend[1])){ regs_sync(); irq_dispatch(); }   /* 時間を進めるときにも同期する */
+}
+/* 次の割込み（マスク中なら保留）か 1ms 境界（SysTick）まで眠る */
+void hal_fake_wfi(void)
+{
+    uint64_t ms = HAL_FAKE_TIM_HZ / 1000U;
+    if(irq_pending()) return;
+    s_wfi = 1; s_woke = 0;
+    hal_fake_advance_ticks(ms - (s_now % ms));
+    s_wfi = 0;
+}
+
+/* ==== HAL 関数 ======================================================= */
+uint32_t HAL_GetTick(void){ return (uint32_t)(s_now / (HAL_FAKE_TIM_HZ / 1000U)); }
+void     HAL_Delay(uint32_t ms){ hal_fake_advance_ticks((uint64_t)ms * (HAL_FAKE_TIM_HZ / 1000U)); }
+
+uint32_t HAL_RCC_GetSysClockFreq(void){ return 2U * HAL_FAKE_TIM_HZ; }
+uint32_t HAL_RCC_GetHCLKFreq(void){ return HAL_FAKE_TIM_HZ; }
+uint32_t HAL_RCC_GetPCLK1Freq(void){ return HAL_FAKE_TIM_HZ; }
+uint32_t HAL_RCC_GetPCLK2Freq(void){ return HAL_FAKE_TIM_HZ; }
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t pre, uint32_t sub)
+{
+    if((int)irq >= 0 && (int)irq < NIRQ) s_irq_prio[irq] = (uint8_t)((pre << 4) | (sub & 0xFU));
+}
+void HAL_NVIC_EnableIRQ(IRQn_Type irq){ if((int)irq >= 0 && (int)irq < NIRQ){ s_irq_en[irq] = 1; irq_dispatch(); } }
+void HAL_NVIC_DisableIRQ(IRQn_Type irq){ if((int)irq >= 0 && (int)irq < NIRQ) s_irq_en[irq] = 0; }
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init){ (void)port; (void)init; }
+void HAL_GPIO_DeInit(GPIO_TypeDef *port, uint32_t pin){ (void)port; (void)pin; }
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState st)
+{
+    hal_fake_gpio_bsrr(port, (st == GPIO_PIN_RESET) ? ((uint32_t)pin << 16) : pin);
+}
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    uint32_t odr = port->ODR;
+    hal_fake_gpio_bsrr(port, ((odr & pin) << 16) | (~odr & pin));
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *hu, uint8_t *p, uint16_t n)
+{
+    if(hu->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if(!p || n == 0U) return HAL_ERROR;
+    hu->pRxBuffPtr = p; hu->RxXferSize = n; hu->RxXferCount = n;
+    hu->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    hu->RxState = HAL_UART_STATE_BUSY_RX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *hu, uint8_t *p, uint16_t n)
+{
+    if(hu->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+    if(!p || n == 0U || !hu->hdmarx) return HAL_ERROR;
+    hu->pRxBuffPtr = p; hu->RxXferSize = n;
+    hu->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    hu->RxState = HAL_UART_STATE_BUSY_RX;
+    hu->hdmarx->Instance->CNDTR = n;
+    s_urx_pos = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *hu, const uint8_t *p, uint16_t n, uint32_t timeout)
+{
+    int u = (hu->Instance == USART1) ? 0 : (hu->Instance == USART2) ? 1 : -1;
+    if(u < 0 || !p || n == 0U) return HAL_ERROR;
+    if(hu->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+    for(uint16_t i=0;i<n;i++) utx_put(u, p[i]);
+    /* 8N1 の送出時間だけ仮想時間を進める（ブロッキング送信） */
+    if(hu->Init.BaudRate) hal_fake_advance_ticks((uint64_t)n * 10U * HAL_FAKE_TIM_HZ / hu->Init.BaudRate);
+    return HAL_OK;
+}
+
+uint32_t hal_fake_uart_sent(UART_HandleTypeDef *hu, uint8_t *out, uint32_t cap)
+{
+    int u = (hu->Instance == USART1) ? 0 : (hu->Instance == USART2) ? 1 : -1;
+    if(u < 0) return 0;
+    uint32_t n = (s_utx_n[u] < cap) ? s_utx_n[u] : cap;
+    if(out) memcpy(out, s_utx[u], n);
+    memmove(s_utx[u], s_utx[u] + n, s_utx_n[u] - n);
+    s_utx_n[u] -= n;
+    return n;
+}
+
+/* ==== フラッシュ模型 ================================================= */
+void hal_fake_flash_wipe(void)
+{
+    s_flash_on = 1;
+    memset(s_flash, 0xFF, sizeof s_flash);
+    memset(hal_fake_flash_erases, 0, sizeof hal_fake_flash_erases);
+    hal_fake_flash_progs = 0;
+    s_flash_cut = -1;
+    s_flash_dead = 0;
+}
+
+void    hal_fake_flash_cut_after(int32_t n){ s_flash_cut = n; if(n < 0) s_flash_dead = 0; }
+uint8_t hal_fake_flash_dead(void){ return s_flash_dead; }
+uint32_t hal_fake_flash_base(void)
+{
+    if(!s_flash_on){ s_flash_on = 1; memset(s_flash, 0xFF, sizeof s_flash); }
+    return (uint32_t)(uintptr_t)s_flash;
+}
+
+/* 返値: 1=この操作は最後まで済む、0=電源断（この操作の途中で切れた、または既に切れている） */
+static uint8_t flash_power(void)
+{
+    if(s_flash_dead) return 0;
+    if(s_flash_cut >= 0 && s_flash_cut-- == 0){ s_flash_dead = 1; return 0; }
+    return 1;
+}
+
+static int32_t flash_index(uint32_t addr)
+{
+    uint32_t off = addr - hal_fake_flash_base();
+    if((addr & 1U) || off >= sizeof s_flash){
+        fprintf(stderr, "hal_fake: kv のページ外のフラッシュ操作 (%08x)\n", (unsigned)addr);
+        abort();
+    }
+    return (int32_t)(off / 2U);
+}
+
+uint8_t hal_fake_flash_prog16(uint32_t addr, uint16_t v)
+{
+    int32_t i = flash_index(addr);
+    uint8_t dead = s_flash_dead;
+    if(!flash_power()){
+        if(!dead && s_flash[i] == 0xFFFFU) s_flash[i] = (uint16_t)(v | 0x5A5AU);   /* 書きかけ：一部のビットだけ落ちる */
+        return 0;
+    }
+    if(s_flash[i] != 0xFFFFU) return 0;                 /* PGERR */
+    s_flash[i] = v;
+    hal_fake_flash_progs++;
+    return 1;
+}
+
+uint8_t hal_fake_flash_erase(uint32_t addr)
+{
+    int32_t i = flash_index(addr), words = FLASH_PAGE / 2U;
+    if((i * 2) % FLASH_PAGE){ fprintf(stderr, "hal_fake: ページ境界でない消去\n"); abort(); }
+    uint8_t dead = s_flash_dead;
+    if(!flash_power()){
+        if(!dead) memset(&s_flash[i], 0xFF, (size_t)words);   /* 前半だけ消えた */
+        return 0;
+    }
+    memset(&s_flash[i], 0xFF, (size_t)words * 2U);
+    hal_fake_flash_erases[(i * 2) / FLASH_PAGE]++;
+    return 1;
+}
+
+/* ==== RTC 模型 ====================================================== */
+void hal_fake_rtc_lose(void){ s_rtc_on = 0; }
+
+uint8_t hal_fake_rtc_read(int64_t *utc_s)
+{
+    if(!s_rtc_on) return 0;
+    *utc_s = s_rtc_s + ((int64_t)s_now - s_rtc_at) / (int64_t)HAL_FAKE_TIM_HZ;
+    return 1;
+}
+
+void hal_fake_rtc_write(int64_t utc_s)
+{
+    s_rtc_on = 1;
+    s_rtc_s  = utc_s;
+    s_rtc_at = (int64_t)s_now;
+}
+
+/* prof.c の時刻源：ホストの単調時計を SYSCLK 換算したサイクル数 */
+uint32_t hal_fake_cyccnt(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    return (uint32_t)(ns * (SystemCoreClock / 1000000U) / 1000U);
+}
+
+/* 本体が定義しなければ何もしない */
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *hu){ (void)hu; }
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *hu, uint16_t pos){ (void)hu; (void)pos; }
+__weak void HAL_GPIO_EXTI_Callback(uint16_t pin){ (void)pin; }
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "hal_fake: Error_Handler\n");
+    abort();
+}
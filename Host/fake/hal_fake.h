@@ -0,0 +1,79 @@
+#pragma once
+#include "main.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== ホスト用 HAL 代用品：試験ハーネス向け API =====
+   時間は仮想（タイマクロック 32MHz 単位）で、hal_fake_advance_*() を呼んだ分だけ進む。
+   その間に TIM1/TIM2/TIM3/TIM6 のカウンタと更新イベント、TIM1 の比較一致で起動する DMA 転送を
+   模擬し、登録された割込みハンドラを呼ぶ。GPIO の出力変化はフックへ通知する */
+
+#define HAL_FAKE_TIM_HZ  32000000U    /* APB1/APB2 タイマクロック */
+
+/* main.c にある実体の代わり */
+extern UART_HandleTypeDef huart1;     /* GPS（DMA 循環受信） */
+extern UART_HandleTypeDef huart2;     /* VCP */
+extern DMA_HandleTypeDef  hdma_usart1_rx;
+
+void     hal_fake_reset(void);                       /* 全レジスタ・時間・フックを初期化 */
+
+/* ==== 仮想時間 ==== */
+void     hal_fake_advance_ticks(uint64_t ticks);
+void     hal_fake_advance_us(uint64_t us);
+uint64_t hal_fake_now_ticks(void);
+
+/* ==== 割込み ==== */
+typedef void (*hal_fake_isr_t)(void);
+void     hal_fake_set_isr(IRQn_Type irq, hal_fake_isr_t fn);  /* NVIC 許可済みなら配送される */
+void     hal_fake_raise(IRQn_Type irq);              /* マスク中・ハンドラ実行中は保留 */
+void     hal_fake_tim_capture(TIM_TypeDef *tim, uint8_t ch); /* 入力捕捉（PPS など） */
+
+/* ==== 外部入力の予定 ==== */
+/* 仮想時間を進める途中、予定の時刻ちょうどで止まって fn を呼ぶ。fn はその時刻までの入力
+   （hal_fake_uart_inject・hal_fake_exti・hal_fake_tim_capture）を入れ、次の予定の時刻を
+   返す（UINT64_MAX=もう無い）。登録した時点でも1回呼ぶ。入力は割込みなので WFI を起こす */
+typedef uint64_t (*hal_fake_input_t)(void *ctx, uint64_t now);
+void     hal_fake_set_input(hal_fake_input_t fn, void *ctx);
+
+/* ==== GPIO ==== */
+/* port: 0=GPIOA, 1=GPIOB, 2=GPIOF。出力が変化したときだけ呼ばれる */
+typedef void (*hal_fake_gpio_hook_t)(void *ctx, uint8_t port, uint16_t before, uint16_t after);
+void     hal_fake_set_gpio_hook(hal_fake_gpio_hook_t fn, void *ctx);
+void     hal_fake_gpio_input(GPIO_TypeDef *port, uint16_t pin, uint8_t level); /* IDR を設定 */
+void     hal_fake_exti(uint16_t pin);                /* HAL_GPIO_EXTI_Callback を割込み文脈で */
+extern uint32_t hal_fake_gpio_writes;                /* BSRR/BRR 相当の書込み回数 */
+
+/* ==== UART 受信 ==== */
+/* 受信待ち（IT 1バイト、または ReceiveToIdle_DMA 循環）へ n バイト流し込む。
+   DMA は半分・満了・末尾（IDLE）で RxEvent を、IT は1バイトごとに RxCplt を呼ぶ。
+   受信待ちでないときのバイトは捨て、hal_fake_uart_dropped に数える */
+void     hal_fake_uart_inject(UART_HandleTypeDef *hu, const uint8_t *p, uint32_t n);
+extern uint32_t hal_fake_uart_dropped;
+
+/* ==== UART 送信 ==== */
+/* HAL_UART_Transmit、または USART2 送信 DMA（DMA1 Ch7、CR3.DMAT 時に1文字時間ごと）で
+   送られたバイトを取り出す（取り出した分は消える）。返値=バイト数 */
+uint32_t hal_fake_uart_sent(UART_HandleTypeDef *hu, uint8_t *out, uint32_t cap);
+
+/* ==== フラッシュ（kv.c の2ページ） ==== */
+/* 書込みは消去済み（0xFFFF）の半語にだけ効き、消去は 0xFF に戻す。hal_fake_reset() では
+   消えない（電源断を跨いで残る）。cut_after(n) は n 回目の操作の途中で電源を落とす：
+   書込みは一部のビットだけ、消去はページの前半だけ済ませ、以後の操作はすべて失敗する */
+#define HAL_FAKE_FLASH_PAGES 2U
+void     hal_fake_flash_wipe(void);                  /* 全面消去、計数と電源断も解除 */
+void     hal_fake_flash_cut_after(int32_t n);        /* -1=解除（電源を戻す） */
+uint8_t  hal_fake_flash_dead(void);                  /* 1=電源断の後 */
+extern uint32_t hal_fake_flash_progs;                /* 書けた半語の数 */
+extern uint32_t hal_fake_flash_erases[HAL_FAKE_FLASH_PAGES];
+
+/* ==== RTC（rtc.c） ==== */
+/* 仮想時間で進み、hal_fake_reset() を跨いで残る（バックアップ領域）。
+   lose() は VBAT の無い電源断：書いた時刻を失い、rtc_get() は 0 を返す */
+void     hal_fake_rtc_lose(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/* ホスト用 stm32f3xx_hal.h。
+   型・定数は本物の CMSIS デバイスヘッダと HAL ヘッダをそのまま使い、
+   周辺レジスタの実体だけを hal_fake.c の変数へ差し替える。
+   HAL 関数の実装は hal_fake.c（本体コードが使うものだけ） */
+#ifndef HOST_FAKE_STM32F3XX_HAL_H
+#define HOST_FAKE_STM32F3XX_HAL_H
+
+#include "stm32f3xx.h"
+
+/* ==== 周辺レジスタをホストのメモリへ ==== */
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern GPIO_TypeDef        hal_fake_GPIOA, hal_fake_GPIOB, hal_fake_GPIOF;
+extern TIM_TypeDef         hal_fake_TIM1, hal_fake_TIM2, hal_fake_TIM3, hal_fake_TIM6;
+extern DMA_TypeDef         hal_fake_DMA1;
+extern DMA_Channel_TypeDef hal_fake_DMA1_Ch[7];
+extern RCC_TypeDef         hal_fake_RCC;
+extern USART_TypeDef       hal_fake_USART1, hal_fake_USART2;
+extern EXTI_TypeDef        hal_fake_EXTI;
+extern SYSCFG_TypeDef      hal_fake_SYSCFG;
+#ifdef __cplusplus
+}
+#endif
+
+#undef GPIOA
+#undef GPIOB
+#undef GPIOF
+#undef TIM1
+#undef TIM2
+#undef TIM3
+#undef TIM6
+#undef DMA1
+#undef DMA1_Channel1
+#undef DMA1_Channel2
+#undef DMA1_Channel3
+#undef DMA1_Channel4
+#undef DMA1_Channel5
+#undef DMA1_Channel6
+#undef DMA1_Channel7
+#undef RCC
+#undef USART1
+#undef USART2
+#undef EXTI
+#undef SYSCFG
+#define GPIOA          (&hal_fake_GPIOA)
+#define GPIOB          (&hal_fake_GPIOB)
+#define GPIOF          (&hal_fake_GPIOF)
+#define TIM1           (&hal_fake_TIM1)
+#define TIM2           (&hal_fake_TIM2)
+#define TIM3           (&hal_fake_TIM3)
+#define TIM6           (&hal_fake_TIM6)
+#define DMA1           (&hal_fake_DMA1)
+#define DMA1_Channel1  (&hal_fake_DMA1_Ch[0])
+#define DMA1_Channel2  (&hal_fake_DMA1_Ch[1])
+#define DMA1_Channel3  (&hal_fake_DMA1_Ch[2])
+#define DMA1_Channel4  (&hal_fake_DMA1_Ch[3])
+#define DMA1_Channel5  (&hal_fake_DMA1_Ch[4])
+#define DMA1_Channel6  (&hal_fake_DMA1_Ch[5])
+#define DMA1_Channel7  (&hal_fake_DMA1_Ch[6])
+#define RCC            (&hal_fake_RCC)
+#define USART1         (&hal_fake_USART1)
+#define USART2         (&hal_fake_USART2)
+#define EXTI           (&hal_fake_EXTI)
+#define SYSCFG         (&hal_fake_SYSCFG)
+
+/* 本物の HAL 宣言（stm32f3xx_hal_conf.h 経由で各モジュールのヘッダ） */
+#include_next "stm32f3xx_hal.h"
+
+/* ==== 本体コード側のフック ==== */
+#ifdef __cplusplus
+extern "C" {
+#endif
+void hal_fake_gpio_bsrr(GPIO_TypeDef *port, uint32_t w);
+uint32_t hal_fake_cyccnt(void);
+uint32_t hal_fake_flash_base(void);
+uint8_t  hal_fake_flash_prog16(uint32_t addr, uint16_t v);
+uint8_t  hal_fake_flash_erase(uint32_t addr);
+uint8_t  hal_fake_rtc_read(int64_t *utc_s);
+void     hal_fake_rtc_write(int64_t utc_s);
+#ifdef __cplusplus
+}
+#endif
+/* nixie.c の BSRR/BRR 書込みをトレースへ通す */
+#define NIXIE_GPIO_BSRR(port, w)  hal_fake_gpio_bsrr((port), (uint32_t)(w))
+#define NIXIE_GPIO_BRR(port, w)   hal_fake_gpio_bsrr((port), (uint32_t)(w) << 16)
+/* prof.c の計測はホストの実時間で（仮想時間は本体の処理中に進まない） */
+#define PROF_CYCCNT()             hal_fake_cyccnt()
+/* kv.c のフラッシュ操作は模型へ（電源断を注入できる） */
+#define KV_FLASH_BASE             hal_fake_flash_base()
+#define KV_FLASH_PROG16(a, v)     hal_fake_flash_prog16((a), (v))
+#define KV_FLASH_ERASE(a)         hal_fake_flash_erase(a)
+/* rtc.c の暦は模型へ（仮想時間で進む） */
+#define RTC_HW_START()            ((void)0)
+#define RTC_HW_READ(t)            hal_fake_rtc_read(t)
+#define RTC_HW_WRITE(t)           hal_fake_rtc_write(t)
+
+#endif /* HOST_FAKE_STM32F3XX_HAL_H */
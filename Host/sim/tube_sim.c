@@ -0,0 +1,111 @@
+#include "tube_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SR_SHIFT   3U                 /* SR0 = PA3 */
+#define CODE_MASK  0x0FFFU
+#define DIGITS     0x09FFU            /* bit0..8=1..9, bit11=0 */
+#define DOT_L      0x0200U
+#define DOT_R      0x0400U
+
+static inline uint16_t positive(uint16_t c)
+{
+#ifdef NIXIE_ACTIVE_LOW
+    return (uint16_t)(~c & CODE_MASK);
+#else
+    return c;
+#endif
+}
+
+static inline uint32_t span(uint64_t a, uint64_t b){ return (uint32_t)((b > a) ? b - a : 0U); }
+
+void tube_sim_attach(tube_sim_t *s, ts_frame_t *log, uint32_t log_cap)
+{
+    memset(s, 0, sizeof *s);
+    s->log = log; s->log_cap = log ? log_cap : 0U;
+    s->din = (uint16_t)((hal_fake_GPIOA.ODR >> SR_SHIFT) & 0xFFU);
+    hal_fake_set_gpio_hook(tube_sim_gpio, s);
+}
+
+static void on_shcp(tube_sim_t *s, uint64_t now)
+{
+    for(int k=0;k<8;k++) s->sh[k] = (uint16_t)(((s->sh[k] << 1) | ((s->din >> k) & 1U)) & CODE_MASK);
+    if(s->n_sh == 0U) s->t_sh0 = now;
+    s->t_sh1 = now;
+    s->n_sh++;
+    s->n_shcp++;
+}
+
+static void on_stcp(tube_sim_t *s, uint64_t now)
+{
+    memcpy(s->out, s->sh, sizeof s->out);
+
+    ts_frame_t f;
+    f.t = now;
+    tube_sim_shown(s, f.code);
+    f.shifts      = (uint8_t)(s->n_sh > 255U ? 255U : s->n_sh);
+    f.shift_ticks = s->n_sh ? span(s->t_sh0, s->t_sh1) : 0U;
+    f.latch_ticks = s->n_sh ? span(s->t_sh1, now) : 0U;
+    f.glitch = 0;
+    if(s->n_sh % 12U) f.glitch |= TS_GL_PARTIAL;
+    for(int i=0;i<8;i++){
+        uint16_t d = (uint16_t)(f.code[i] & DIGITS);
+        if(d & (d - 1U)) f.glitch |= TS_GL_MULTI;
+    }
+
+    s->n_stcp++;
+    if(f.glitch) s->n_glitch++;
+    if(f.shift_ticks > s->max_shift) s->max_shift = f.shift_ticks;
+    if(f.latch_ticks > s->max_latch) s->max_latch = f.latch_ticks;
+    if(s->n_sh == 12U){ s->sum_shift += f.shift_ticks; s->n_full++; }
+    if(s->n_log < s->log_cap) s->log[s->n_log++] = f;
+    s->n_sh = 0;
+}
+
+void tube_sim_gpio(void *ctx, uint8_t port, uint16_t before, uint16_t after)
+{
+    tube_sim_t *s = (tube_sim_t*)ctx;
+    uint64_t now = hal_fake_now_ticks();
+    if(port == 0U){
+        s->din = (uint16_t)((after >> SR_SHIFT) & 0xFFU);
+        return;
+    }
+    if(port != 1U) return;
+    uint16_t rise = (uint16_t)(~before & after);
+    if(rise & SHCP_Pin) on_shcp(s, now);
+    if(rise & STCP_Pin) on_stcp(s, now);
+}
+
+void tube_sim_shown(const tube_sim_t *s, uint16_t code_lr[8])
+{
+    for(int i=0;i<8;i++) code_lr[i] = positive(s->out[7 - i]);
+}
+
+int tube_sim_render(const uint16_t code_lr[8], char *buf, size_t n)
+{
+    static const char DIG[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    if(n < 25U){ if(n) buf[0] = '\0'; return 0; }
+    char *p = buf;
+    for(int i=0;i<8;i++){
+        uint16_t c = code_lr[i];
+        uint16_t d = (uint16_t)(c & DIGITS);
+        char ch = ' ';
+        if(d & (d - 1U))   ch = '#';
+        else if(d & 0x0800U) ch = '0';
+        else if(d){ for(int b=0;b<9;b++) if(d & (1U << b)) ch = DIG[b]; }
+        *p++ = (c & DOT_L) ? '.' : ' ';
+        *p++ = ch;
+        *p++ = (c & DOT_R) ? '.' : ' ';
+    }
+    *p = '\0';
+    return (int)(p - buf);
+}
+
+int tube_sim_render_frame(const ts_frame_t *f, char *buf, size_t n)
+{
+    char tubes[32];
+    tube_sim_render(f->code, tubes, sizeof tubes);
+    return snprintf(buf, n, "%10.1fus sh=%-3u %c%c |%s|",
+                    (double)f->t * 1e6 / (double)HAL_FAKE_TIM_HZ, (unsigned)f->shifts,
+                    (f->glitch & TS_GL_PARTIAL) ? 'P' : '-', (f->glitch & TS_GL_MULTI) ? 'M' : '-', tubes);
+}
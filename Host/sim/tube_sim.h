@@ -0,0 +1,67 @@
+#pragma once
+#include "hal_fake.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===== 74HC595 ×12bit ×8列と IN-14 ×8本の模型 =====
+   HAL 代用品の GPIO フック（hal_fake_set_gpio_hook）で SR0..SR7=PA3..PA10、SHCP=PB0、
+   STCP=PB1 の変化を受け、SHCP↑でシフト、STCP↑でラッチして、その時点で点いている
+   カソードとドットを1フレームとして記録する。時間は仮想時間 [tick]（HAL_FAKE_TIM_HZ）。
+
+   フレームごとに：前のラッチからのシフト回数、最初と最後の SHCP↑の間（シフト時間）、
+   最後の SHCP↑から STCP↑まで（ラッチの遅れ）を持つ。次のものはグリッチとして印を付ける：
+     TS_GL_PARTIAL  12の倍数でないシフト回数でラッチした（前後のフレームが混ざる）
+     TS_GL_MULTI    どれかの管で数字のカソードが2本以上点いた
+   代用品の TIM1 は比較一致の DMA をその一致の時刻（CCR1 でデータ、CCR2 で SHCP）に出すので
+   DMA 送出のセットアップは 8tick に見える。CPU 直書きは仮想時間を使わないので、そちらの
+   データ線と SHCP の間の時間は測れない。順序だけが正しい。
+
+   表示コードの形は nixie.c と同じ（bit0..8=1..9、bit9=左ドット、bit10=右ドット、bit11=0、
+   NIXIE_ACTIVE_LOW なら反転）。SR0 が右端の管 */
+
+#define TS_GL_PARTIAL 0x01U
+#define TS_GL_MULTI   0x02U
+
+typedef struct {
+    uint64_t t;                 /* STCP↑の時刻 [tick] */
+    uint16_t code[8];           /* 点いているもの（左→右、正論理の表示コード） */
+    uint8_t  shifts;            /* 前のラッチからの SHCP↑の数（255 で頭打ち） */
+    uint8_t  glitch;            /* TS_GL_* */
+    uint32_t shift_ticks;       /* 最初 → 最後の SHCP↑（シフトなしは 0） */
+    uint32_t latch_ticks;       /* 最後の SHCP↑ → STCP↑ */
+} ts_frame_t;
+
+typedef struct {
+    uint16_t sh[8], out[8];     /* SR0..SR7 のシフト段と出力段 */
+    uint16_t din;               /* データ線（bit k = SRk） */
+    uint64_t t_sh0, t_sh1;      /* 今のフレームの最初と最後の SHCP↑ */
+    uint32_t n_sh;              /* 前のラッチからの SHCP↑ */
+
+    ts_frame_t *log;            /* 記録先（NULL 可）。満杯になったら以後は数えるだけ */
+    uint32_t    log_cap, n_log;
+
+    /* 集計 */
+    uint32_t n_shcp, n_stcp, n_glitch;
+    uint32_t max_shift, max_latch;
+    uint64_t sum_shift;         /* 12回シフトしたフレームのシフト時間の合計 */
+    uint32_t n_full;            /* その数 */
+} tube_sim_t;
+
+/* 初期化して GPIO フックに付ける（hal_fake_reset() の後で） */
+void tube_sim_attach(tube_sim_t *s, ts_frame_t *log, uint32_t log_cap);
+/* フック本体。別のフックと重ねるときは自分のフックから呼ぶ */
+void tube_sim_gpio(void *ctx, uint8_t port, uint16_t before, uint16_t after);
+/* 今点いているもの（左→右） */
+void tube_sim_shown(const tube_sim_t *s, uint16_t code_lr[8]);
+/* 1管を3字 [左ドット][数字][右ドット] で。数字なしは ' '、2本以上は '#'。返値: 書いた字数 */
+int  tube_sim_render(const uint16_t code_lr[8], char *buf, size_t n);
+/* フレームを1行で（時刻 [µs]・シフト回数・グリッチ・管の絵） */
+int  tube_sim_render_frame(const ts_frame_t *f, char *buf, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
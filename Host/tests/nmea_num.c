@@ -0,0 +1,309 @@
+/* NMEA の数値欄（緯度経度 ddmm.mmmm / dddmm.mmmm、速度・高度・DOP）の固定小数点解析を揺さぶる。
+   乱数で作った欄（正しい形・範囲外・59.9999995 の丸め上がり・桁の多すぎ・符号・空欄・壊れた字）を
+   gps_dm_parse() / gps_fx_parse() と、このファイルの整数だけの参照実装に通し、受理と値が完全に
+   一致することを確かめる。同じ欄を基準線の strtof の経路（nmea_legacy.c）にも通して誤差と、
+   固定小数点が弾くのに strtof が通してしまう数を報告し、両方の所要時間を比べる。
+
+     nmea_num                    既定（各 200000 欄）
+     nmea_num -n 2000000 -s 7
+
+   不一致があれば終了コード 1 */
+#include "gps.h"
+#include "nmea_legacy.h"
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int s_fail = 0;
+#define CHECK(c) do{ if(!(c)){ printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); s_fail++; } }while(0)
+
+#define FLD_MAX 24
+#define M_PER_DEG 111319.49           /* 子午線方向（赤道の経度方向も同じ） */
+
+static uint32_t s_rng;
+static uint32_t rnd(void){ s_rng = s_rng * 1664525U + 1013904223U; return s_rng >> 8; }
+static uint32_t rn(uint32_t n){ return rnd() % n; }
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ==== 参照実装（整数だけ、文字列を前から素直に読む） ================ */
+static const char DIG[] = "0123456789";
+
+/* 小数部の先頭 frac 桁を詰め、その次の桁で四捨五入した値 */
+static uint64_t ref_frac(const char *f, size_t nf, unsigned frac)
+{
+    uint64_t v = 0;
+    for(unsigned i=0;i<frac;i++) v = v*10U + (i < nf ? (uint64_t)(f[i] - '0') : 0U);
+    if(nf > frac && f[frac] >= '5') v++;
+    return v;
+}
+
+/* [+-]digits[.digits]、数字が少なくとも1つ。値×10^frac が int32 に収まること */
+static int ref_fx(const char *s, unsigned frac, int32_t *out)
+{
+    int neg = 0;
+    if(*s == '-' || *s == '+'){ neg = (*s == '-'); ++s; }
+    size_t ni = strspn(s, DIG);
+    const char *f = s + ni;
+    size_t nf = 0;
+    if(*f == '.'){ ++f; nf = strspn(f, DIG); }
+    if(f[nf] != '\0' || ni + nf == 0) return 0;
+
+    while(ni > 0 && *s == '0'){ ++s; --ni; }        /* 先頭の0は値に効かない */
+    if(ni > 10) return 0;
+    uint64_t ip = 0;
+    for(size_t i=0;i<ni;i++) ip = ip*10U + (uint64_t)(s[i] - '0');
+    uint64_t p10 = 1;
+    for(unsigned i=0;i<frac;i++) p10 *= 10U;
+    uint64_t v = ip * p10 + ref_frac(f, nf, frac);
+    if(v > 2147483647U) return 0;
+    *out = neg ? -(int32_t)v : (int32_t)v;
+    return 1;
+}
+
+/* 整数部 3..4桁（経度 3..5桁）[.digits]。分 < 60、丸めて 60分に届くものと deg_max 超えは不正 */
+static int ref_dm(const char *s, char hemi_neg, char hemi, unsigned deg_max, gps_dm_t *out)
+{
+    size_t ni = strspn(s, DIG);
+    if(ni < 3 || ni > (deg_max > 99U ? 5U : 4U)) return 0;
+    const char *f = s + ni;
+    size_t nf = 0;
+    if(*f == '.'){ ++f; nf = strspn(f, DIG); }
+    if(f[nf] != '\0') return 0;
+
+    unsigned ip = 0;
+    for(size_t i=0;i<ni;i++) ip = ip*10U + (unsigned)(s[i] - '0');
+    unsigned deg = ip / 100U, mm = ip % 100U;
+    uint64_t fr = ref_frac(f, nf, 6);
+    if(mm >= 60U || fr >= 1000000U) return 0;
+    if(deg > deg_max || (deg == deg_max && (mm || fr))) return 0;
+    int32_t umin = (int32_t)(mm * 1000000U + fr);
+    out->deg  = (int16_t)(hemi == hemi_neg ? -(int)deg : (int)deg);
+    out->umin = hemi == hemi_neg ? -umin : umin;
+    return 1;
+}
+
+/* ==== 欄の合成 ======================================================= */
+static void put_digits(char *s, size_t *n, unsigned k, int nines)
+{
+    for(unsigned i=0;i<k && *n < FLD_MAX-1;i++) s[(*n)++] = nines ? '9' : DIG[rn(10)];
+}
+
+/* 壊す：1字を差し替える・挟む・末尾を切る */
+static void mutate(char *s)
+{
+    static const char JUNK[] = "0123456789.-+x, ";
+    size_t n = strlen(s);
+    switch(rn(3)){
+    case 0: if(n) s[rn((uint32_t)n)] = JUNK[rn(sizeof JUNK - 1U)]; break;
+    case 1: if(n < FLD_MAX-1){ size_t i = rn((uint32_t)n + 1U); memmove(s+i+1, s+i, n-i+1); s[i] = JUNK[rn(sizeof JUNK - 1U)]; } break;
+    default: s[rn((uint32_t)n + 1U)] = '\0'; break;
+    }
+}
+
+static const char *const DM_EDGE[] = {
+    "5959.9999995", "5959.9999994", "5959.999999", "0000", "000", "00", "0000.", "0000.0",
+    "9000", "9000.0000004", "9000.0000005", "9000.000001", "8959.99999949", "8959.9999995",
+    "18000", "18000.0000004", "18000.0000005", "17959.9999995", "09000", "000000", ".5", "",
+    "4807.", "4807..1", "4807.-1", "-4807.038", "+4807.038", "4807.038 ", " 4807.038",
+};
+
+static void gen_dm(char *s, unsigned deg_max)
+{
+    uint32_t mode = rn(16);
+    if(mode == 0){ snprintf(s, FLD_MAX, "%s", DM_EDGE[rn(sizeof DM_EDGE / sizeof DM_EDGE[0])]); return; }
+
+    unsigned w   = (deg_max > 99U ? 5U : 4U) + rn(3) - 1U;   /* 既定の幅 ±1 */
+    unsigned deg = rn(deg_max + 3U), mm = rn(62);
+    int n = snprintf(s, FLD_MAX, "%0*u%02u", (int)(w - 2U), deg, mm);
+    size_t len = (size_t)n;
+    if(rn(6)){
+        s[len++] = '.';
+        put_digits(s, &len, rn(10), rn(6) == 0);
+    }
+    s[len] = '\0';
+    if(mode == 1){ memmove(s+1, s, len+1); s[0] = rn(2) ? '-' : '+'; }
+    if(mode >= 2 && mode <= 4) mutate(s);
+}
+
+static const char *const FX_EDGE[] = {
+    "", ".", "-", "+", "-.", "0", "-0", "+0.0", "0.0005", "0.0004999", "0.00049", "5.", ".5",
+    "2147483.647", "2147483.6474", "2147483.6475", "2147483.648", "-2147483.647", "-2147483.648",
+    "21474836.47", "21474836.475", "00000000000000001.5", "1e3", "12.3x", " 1", "1 ", "--1", "1.2.3",
+};
+
+static void gen_fx(char *s)
+{
+    uint32_t mode = rn(16);
+    if(mode == 0){ snprintf(s, FLD_MAX, "%s", FX_EDGE[rn(sizeof FX_EDGE / sizeof FX_EDGE[0])]); return; }
+
+    size_t len = 0;
+    if(rn(6) == 0) s[len++] = rn(3) ? '-' : '+';
+    put_digits(s, &len, rn(12) < 9 ? rn(5) : rn(12), 0);       /* 大抵は4桁まで、時々は桁あふれ */
+    if(rn(4)){
+        s[len++] = '.';
+        put_digits(s, &len, rn(8), rn(8) == 0);
+    }
+    s[len] = '\0';
+    if(mode <= 3) mutate(s);
+}
+
+/* ==== 突き合わせ ===================================================== */
+static void test_dm(const char *name, char hemi_neg, char hemi_pos, unsigned deg_max, uint32_t n)
+{
+    uint32_t ok = 0, bad = 0, loose = 0, over1m = 0;
+    double emax = 0.0, esum = 0.0;
+    char s[FLD_MAX], worst[FLD_MAX] = "";
+    for(uint32_t i=0;i<n;i++){
+        gen_dm(s, deg_max);
+        char hemi = rn(2) ? hemi_neg : hemi_pos;
+        gps_dm_t got = { 0, GPS_FX_INVALID }, ref = { 0, GPS_FX_INVALID };
+        int g = gps_dm_parse(s, hemi_neg, hemi, (uint16_t)deg_max, &got);
+        int r = ref_dm(s, hemi_neg, hemi, deg_max, &ref);
+        if(g != r || (r && (got.deg != ref.deg || got.umin != ref.umin))){
+            if(bad++ < 5) printf("FAIL %s \"%s\" %c: got %d %d/%ld ref %d %d/%ld\n", name, s, hemi,
+                                 g, got.deg, (long)got.umin, r, ref.deg, (long)ref.umin);
+            continue;
+        }
+
+        /* 基準線：符号は半球で付ける */
+        float old = nmea_legacy_dm_to_deg(s);
+        if(hemi == hemi_neg) old = -old;
+        if(!r){ if(!isnan(old)) loose++; continue; }
+        ok++;
+        double exact = (double)ref.deg + (double)ref.umin / 60e6;
+        double e = isnan(old) ? INFINITY : fabs((double)old - exact) * M_PER_DEG;
+        esum += isfinite(e) ? e : 0.0;
+        if(e > 1.0) over1m++;
+        if(e > emax){ emax = e; snprintf(worst, sizeof worst, "%s", s); }
+    }
+    s_fail += (int)bad;
+    printf("%-5s n=%u accepted=%u mismatch=%u | strtof: max %.3f m (\"%s\") mean %.3f m, >1m %u, "
+           "passes what fixed point rejects %u\n",
+           name, n, ok, bad, emax, worst, ok ? esum / ok : 0.0, over1m, loose);
+}
+
+static void test_fx(const char *name, unsigned frac, uint32_t n)
+{
+    uint32_t ok = 0, bad = 0, loose = 0;
+    double emax = 0.0;
+    char s[FLD_MAX], worst[FLD_MAX] = "";
+    double scale = pow(10.0, frac);
+    for(uint32_t i=0;i<n;i++){
+        gen_fx(s);
+        int32_t got = 0, ref = 0;
+        int g = gps_fx_parse(s, (uint8_t)frac, &got);
+        int r = ref_fx(s, frac, &ref);
+        if(g != r || (r && got != ref)){
+            if(bad++ < 5) printf("FAIL %s \"%s\": got %d %ld ref %d %ld\n", name, s, g, (long)got, r, (long)ref);
+            continue;
+        }
+
+        /* 基準線は strtof が1字でも読めれば受ける */
+        char *ep = NULL;
+        float old = *s ? strtof(s, &ep) : 0.0f;
+        int old_ok = *s && ep != s;
+        if(!r){ if(old_ok) loose++; continue; }
+        ok++;
+        double e = fabs((double)old * scale - (double)ref);   /* 固定小数点の最下位桁を単位に */
+        if(e > emax){ emax = e; snprintf(worst, sizeof worst, "%s", s); }
+    }
+    s_fail += (int)bad;
+    printf("%-5s n=%u accepted=%u mismatch=%u | strtof: max %.1f LSB (1e-%u, \"%s\"), passes what fixed point rejects %u\n",
+           name, n, ok, bad, emax, frac, worst, loose);
+}
+
+/* 決まった値（仕様の確認。乱数に頼らない） */
+static void test_fixed(void)
+{
+    gps_dm_t d;
+    int32_t v;
+    CHECK(gps_dm_parse("4807.038", 'S', 'N', 90, &d) && d.deg == 48 && d.umin == 7038000);
+    CHECK(gps_dm_parse("01131.000", 'W', 'W', 180, &d) && d.deg == -11 && d.umin == -31000000);
+    CHECK(gps_dm_parse("5959.9999994", 'S', 'N', 90, &d) && d.umin == 59999999);
+    CHECK(!gps_dm_parse("5959.9999995", 'S', 'N', 90, &d));     /* 60分へ丸め上がる */
+    CHECK(gps_dm_parse("9000.0000004", 'S', 'N', 90, &d) && d.deg == 90 && d.umin == 0);
+    CHECK(!gps_dm_parse("9000.0000005", 'S', 'N', 90, &d));
+    CHECK(!gps_dm_parse("04807.038", 'S', 'N', 90, &d));        /* 緯度は4桁まで */
+    CHECK(!gps_dm_parse("4807.03x", 'S', 'N', 90, &d));
+    CHECK(gps_fx_parse("-12.3456", 3, &v) && v == -12346);
+    CHECK(gps_fx_parse("0.0005", 3, &v) && v == 1);
+    CHECK(gps_fx_parse("2147483.647", 3, &v) && v == 2147483647);
+    CHECK(!gps_fx_parse("2147483.6475", 3, &v));
+    CHECK(!gps_fx_parse("", 3, &v) && !gps_fx_parse(".", 3, &v) && !gps_fx_parse("-", 3, &v));
+    CHECK(!gps_fx_parse("12.3x", 3, &v) && !gps_fx_parse("1e3", 3, &v));
+}
+
+/* ==== 所要時間 ======================================================= */
+static void bench(uint32_t n)
+{
+    char (*lat)[FLD_MAX] = malloc((size_t)n * FLD_MAX);
+    char (*kn)[FLD_MAX]  = malloc((size_t)n * FLD_MAX);
+    if(!lat || !kn){ perror("malloc"); exit(2); }
+    for(uint32_t i=0;i<n;i++){
+        snprintf(lat[i], FLD_MAX, "%02u%02u.%06u", rn(90), rn(60), rn(1000000));
+        snprintf(kn[i],  FLD_MAX, "%u.%03u", rn(100), rn(1000));
+    }
+
+    volatile int32_t sink_i = 0;
+    volatile float   sink_f = 0.0f;
+    gps_dm_t d;
+    int32_t v;
+    uint64_t t0 = now_ns();
+    for(uint32_t i=0;i<n;i++){ (void)gps_dm_parse(lat[i], 'S', 'N', 90, &d); sink_i += d.umin; }
+    uint64_t t1 = now_ns();
+    for(uint32_t i=0;i<n;i++) sink_f += nmea_legacy_dm_to_deg(lat[i]);
+    uint64_t t2 = now_ns();
+    for(uint32_t i=0;i<n;i++){ (void)gps_fx_parse(kn[i], 3, &v); sink_i += v; }
+    uint64_t t3 = now_ns();
+    for(uint32_t i=0;i<n;i++) sink_f += strtof(kn[i], NULL);
+    uint64_t t4 = now_ns();
+    (void)sink_i; (void)sink_f;
+
+    printf("time  ddmm.mmmmmm: dm_parse %.1f ns  strtof route %.1f ns  (x%.2f)\n",
+           (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t2 - t1) / (double)(t1 - t0));
+    printf("time  knots:       fx_parse %.1f ns  strtof       %.1f ns  (x%.2f)\n",
+           (double)(t3 - t2) / n, (double)(t4 - t3) / n, (double)(t4 - t3) / (double)(t3 - t2));
+    free(lat);
+    free(kn);
+}
+
+static void usage(void)
+{
+    fputs("usage: nmea_num [-n fields] [-s seed]\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n = 200000U, seed = 1U;
+    int o;
+    while((o = getopt(argc, argv, "n:s:h")) != -1){
+        switch(o){
+        case 'n': n = (uint32_t)atoi(optarg); break;
+        case 's': seed = (uint32_t)atoi(optarg); break;
+        default:  usage();
+        }
+    }
+    if(n == 0U) usage();
+    s_rng = seed;
+
+    test_fixed();
+    test_dm("lat", 'S', 'N', 90U, n);
+    test_dm("lon", 'W', 'E', 180U, n);
+    test_fx("x1e3", 3U, n);             /* 速度（RMC/VTG のミリノット）・高度（GGA の mm） */
+    test_fx("x1e2", 2U, n);             /* DOP・針路（×100） */
+    bench(n);
+
+    if(s_fail){ printf("%d failure(s)\n", s_fail); return 1; }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,622 @@
+/* ホストビルドの通し確認：HAL 代用品の上で GPS 受信（DMA 循環）→ 解析 → 時刻保持、
+   表示フレームの DMA 送出と PWM リフレッシュが実機と同じ経路で動くこと */
+#include "hal_fake.h"
+#include "gps.h"
+#include "nixie.h"
+#include "timekeep.h"
+#include "telem.h"
+#include "idle.h"
+#include "civil.h"
+#include "kv.h"
+#include "rtc.h"
+#include "tz.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_fail = 0;
+#define CHECK(c) do{ if(!(c)){ printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); s_fail++; } }while(0)
+
+/* ==== 74HC595 ×12bit ×8列の簡易モデル（SR0..SR7=PA3..PA10, SHCP=PB0, STCP=PB1） ==== */
+typedef struct {
+    uint16_t shift[8], latch[8];
+    uint32_t n_shcp, n_stcp;
+} sr_model_t;
+
+static void on_gpio(void *ctx, uint8_t port, uint16_t before, uint16_t after)
+{
+    sr_model_t *m = (sr_model_t*)ctx;
+    uint16_t rise = (uint16_t)(~before & after);
+    if(port != 1U) return;
+    if(rise & SHCP_Pin){
+        uint16_t din = (uint16_t)(hal_fake_GPIOA.ODR >> 3);
+        for(int k=0;k<8;k++) m->shift[k] = (uint16_t)(((m->shift[k] << 1) | ((din >> k) & 1U)) & 0x0FFFU);
+        m->n_shcp++;
+    }
+    if(rise & STCP_Pin){
+        memcpy(m->latch, m->shift, sizeof m->latch);
+        m->n_stcp++;
+    }
+}
+
+static void setup(sr_model_t *m)
+{
+    hal_fake_reset();
+    memset(m, 0, sizeof *m);
+    hal_fake_set_gpio_hook(on_gpio, m);
+    hal_fake_set_isr(TIM3_IRQn, tk_capture_irq);
+    hal_fake_set_isr(TIM6_DAC1_IRQn, nixie_pwm_irq);
+#if NIXIE_USE_DMA
+    hal_fake_set_isr(DMA1_Channel3_IRQn, nixie_dma_irq);
+#endif
+}
+
+static void test_frame(void)
+{
+    sr_model_t m;
+    setup(&m);
+    nixie_init();
+
+    uint16_t exp[8];
+    nixie_time_codes(12, 34, 56, exp);
+    nixie_show_time_hms(12, 34, 56);
+    hal_fake_advance_us(100);
+
+    CHECK(m.n_shcp == 12U);
+    CHECK(m.n_stcp == 1U);
+    for(int k=0;k<8;k++) CHECK(m.latch[k] == exp[7-k]);   /* SR0 が右端 */
+}
+
+static void test_pwm(void)
+{
+    sr_model_t m;
+    setup(&m);
+    nixie_init();
+    nixie_pwm_start();
+    nixie_show_digits_lr(1,2,3,4,5,6,7,8);
+    nixie_set_brightness(NIXIE_PWM_STEPS / 2U);
+
+    const uint32_t slot_us = 1000000U / (NIXIE_PWM_FRAME_HZ * NIXIE_PWM_STEPS);
+    hal_fake_advance_us(20000U + slot_us / 2U);
+    uint32_t lit[8] = {0};
+    for(uint32_t s=0;s<NIXIE_PWM_STEPS;s++){
+        for(int k=0;k<8;k++) if(m.latch[k] != 0U) lit[k]++;
+        hal_fake_advance_us(slot_us);
+    }
+    for(int k=0;k<8;k++) CHECK(lit[k] == NIXIE_PWM_STEPS / 2U);
+}
+
+static void test_gps(void)
+{
+    sr_model_t m;
+    setup(&m);
+    gps_init(&huart1);
+    tk_init();
+
+    static const char RMC[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+    uint8_t upd = 0;
+    for(int rep=0;rep<40 && !(upd & GPS_UPD_RMC);rep++){   /* 循環バッファを何周かさせる */
+        hal_fake_uart_inject(&huart1, (const uint8_t*)RMC, sizeof RMC - 1U);
+        upd = gps_poll_line();
+        if(rep < 39) upd = 0;
+    }
+    CHECK(upd & GPS_UPD_RMC);
+    CHECK(gps_rmc_ok == 40U);
+    CHECK(hal_fake_uart_dropped == 0U);
+
+    gps_fix_t fx;
+    CHECK(gps_get_snapshot(&fx) != 0U);
+    CHECK(fx.utc_hh == 12 && fx.utc_mm == 35 && fx.utc_ss == 19);
+    CHECK(fx.utc_YYYY == 2094 && fx.utc_MM == 3 && fx.utc_DD == 23);
+    CHECK(fx.lat.deg == 48 && fx.lat.umin == 7038000);
+    CHECK(fx.lon.deg == 11 && fx.lon.umin == 31000000);
+    CHECK(fx.tz_min == 60 && fx.lcl_hh == 13 && fx.lcl_mm == 35 && fx.lcl_DD == 23);
+
+    tk_on_fix(&fx);
+    CHECK(tk_state() == TK_NMEA);
+    CHECK(tk_utc_sod() == 12*3600 + 35*60 + 19);
+    hal_fake_advance_us(1000000U);
+    CHECK(tk_poll() == 1U);
+    CHECK(tk_utc_sod() == 12*3600 + 35*60 + 20);
+}
+
+/* 通日⇔年月日を1日ずつ数えた暦と突き合わせ、分単位の時差・ISO 週の境目を確かめる */
+static void test_civil(void)
+{
+    int y = 1900, mo = 1, d = 1;
+    uint8_t wd = 1;                                /* 1900-01-01 は月曜 */
+    civil_t c;
+    for(int32_t z = civil_to_days(1900, 1, 1); y < 2200; z++){
+        civil_from_days(z, &c);
+        if(c.YYYY != y || c.MM != mo || c.DD != d || c.wday != wd || civil_to_days(y, mo, d) != z){
+            CHECK(!"civil round trip"); printf("  %04d-%02d-%02d z=%ld\n", y, mo, d, (long)z); break;
+        }
+        if(++d > civil_dim(y, mo)){ d = 1; if(++mo > 12){ mo = 1; y++; } }
+        wd = (uint8_t)((wd + 1U) % 7U);
+    }
+    CHECK(civil_to_days(1970, 1, 1) == 0 && civil_to_days(2000, 3, 1) == 11017);
+
+    int16_t iy;
+    civil_from_days(civil_to_days(2021, 1, 3), &c);
+    CHECK(civil_iso_week(&c, &iy) == 53U && iy == 2020);
+    civil_from_days(civil_to_days(2024, 12, 30), &c);
+    CHECK(civil_iso_week(&c, &iy) == 1U && iy == 2025);
+    civil_from_days(civil_to_days(2026, 10, 17), &c);
+    CHECK(civil_iso_week(&c, &iy) == 42U && iy == 2026 && c.wday == 6U && civil_yday(&c) == 289U);
+
+    utc_to_local(civil_epoch(2024, 12, 31, 23, 30, 0), 5*60 + 45, &c);      /* ネパール */
+    CHECK(c.YYYY == 2025 && c.MM == 1 && c.DD == 1 && c.hh == 5 && c.mm == 15 && c.ss == 0);
+    utc_to_local(civil_epoch(2024, 3, 1, 5, 0, 0), -(9*60 + 30), &c);      /* マルキーズ */
+    CHECK(c.YYYY == 2024 && c.MM == 2 && c.DD == 29 && c.hh == 19 && c.mm == 30);
+    utc_to_local(-1, 0, &c);
+    CHECK(c.YYYY == 1969 && c.MM == 12 && c.DD == 31 && c.ss == 59 && c.wday == 3U);
+    utc_to_local(civil_epoch(2100, 2, 28, 12, 0, 0), 14*60, &c);           /* 2100 は平年 */
+    CHECK(c.MM == 3 && c.DD == 1 && c.hh == 2);
+}
+
+/* 本体ループが止まってリングが周回されても、欠落を数えて次の '$' から正しく再開する */
+static void test_gps_overflow(void)
+{
+    sr_model_t m;
+    setup(&m);
+    gps_init(&huart1);
+
+    static const char RMC[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+    const uint32_t n = 3U * gps_rx_capacity() / (sizeof RMC - 1U) + 1U;
+    for(uint32_t i=0;i<n;i++) hal_fake_uart_inject(&huart1, (const uint8_t*)RMC, sizeof RMC - 1U);
+    (void)gps_poll_line();
+
+    CHECK(gps_rx_dropped > 0U);
+    CHECK(gps_rx_overflows == 1U);
+    CHECK(gps_rx_hwm <= gps_rx_capacity());
+    CHECK(gps_rx_pending() == 0U);
+    CHECK(gps_rmc_bad == 0U);
+    CHECK(gps_rmc_ok >= 1U && gps_rmc_ok < n);
+
+    uint32_t ok = gps_rmc_ok;
+    hal_fake_uart_inject(&huart1, (const uint8_t*)RMC, sizeof RMC - 1U);
+    CHECK(gps_poll_line() & GPS_UPD_RMC);
+    CHECK(gps_rmc_ok == ok + 1U);
+    CHECK(gps_rx_overflows == 1U);
+}
+
+/* 解析器は互いに独立：2台目の受信機（USART2、1バイト割込み）とリングを通さない feed が
+   既定の解析器（USART1、DMA）と状態・時差・カウンタを共有しない */
+static void on_fix_count(const gps_fix_t *fx, void *ctx)
+{
+    uint32_t *n = (uint32_t*)ctx;
+    if(fx->upd & GPS_UPD_RMC) (*n)++;
+}
+
+static void test_gps_parsers(void)
+{
+    sr_model_t m;
+    setup(&m);
+    gps_init(&huart1);
+
+    static gps_parser_t b, c;
+    uint32_t nb = 0;
+    gps_parser_init(&b);
+    gps_parser_on_fix(&b, on_fix_count, &nb);
+    CHECK(gps_parser_attach(&b, &huart2));
+    gps_parser_init(&c);
+
+    static const char MUC[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+    static const char NYC[] = "$GPRMC,123519,A,4042.768,N,07400.360,W,000.5,000.0,230394,,*05\r\n";
+    hal_fake_uart_inject(&huart1, (const uint8_t*)MUC, sizeof MUC - 1U);
+    hal_fake_uart_inject(&huart2, (const uint8_t*)NYC, sizeof NYC - 1U);
+    CHECK(gps_parser_pending(&b) == sizeof NYC - 1U);
+    CHECK(gps_poll_line() == GPS_UPD_RMC);
+    CHECK(gps_parser_poll(&b) == GPS_UPD_RMC);
+    CHECK(nb == 1U);
+
+    gps_fix_t fa, fb, fc;
+    CHECK(gps_get_snapshot(&fa) == 1U && gps_parser_snapshot(&b, &fb) == 1U);
+    CHECK(fa.tz_min == 60 && fa.lcl_hh == 13);      /* 表は今の規則：欧州は標準時、米東部は夏時間 */
+    CHECK(fb.tz_min == -240 && fb.lcl_hh == 8);
+    CHECK(tz_offset(civil_epoch(1994, 3, 23, 12, 35, 19)) == 60);   /* 既定の時差は USART1 側 */
+    CHECK(gps_rmc_ok == 1U && b.st.ok[GPS_ST_RMC] == 1U);
+    CHECK(gps_rx_bytes == sizeof MUC - 1U && b.st.rx_bytes == sizeof NYC - 1U);
+
+    /* feed：1バイトずつ渡しても、途中の '\0'（欠落）で文を捨てても同じ */
+    uint8_t upd = 0;
+    for(uint32_t i=0;i<sizeof NYC - 1U;i++) upd |= gps_parser_feed(&c, &NYC[i], 1U);
+    CHECK(upd == GPS_UPD_RMC && gps_parser_snapshot(&c, &fc) == 1U);
+    CHECK(fc.lcl_hh == 8 && fc.lat.deg == 40 && fc.lon.deg == -74);
+    CHECK(gps_parser_feed(&c, "$GPRMC,1235\0", 12U) == 0U && c.st.rx_resync == 1U);
+    CHECK(gps_parser_feed(&c, MUC, sizeof MUC - 1U) == GPS_UPD_RMC);
+    CHECK(gps_parser_snapshot(&c, &fc) == 2U && fc.tz_min == 60);
+    CHECK(gps_parser_snapshot(&b, &fb) == 1U && fb.tz_min == -240);
+
+    /* 暦に無い RMC の日付（34月）は受けても日付を据え置く */
+    static const char BADDATE[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,173426,003.1,W*60\r\n";
+    CHECK(gps_parser_feed(&c, BADDATE, sizeof BADDATE - 1U) == GPS_UPD_RMC);
+    CHECK(gps_parser_snapshot(&c, &fc) == 3U && fc.utc_YYYY == 2094 && fc.utc_MM == 3 && fc.utc_DD == 23);
+
+    /* 範囲外の緯度経度（91度・181度、5桁の緯度）は受けても位置を据え置く */
+    static const char BADPOS[] = "$GPRMC,123519,A,9100.000,N,18100.000,E,022.4,084.4,230394,003.1,W*68\r\n";
+    static const char LAT5[]   = "$GPRMC,123519,A,00107.038,N,01131.000,E,022.4,084.4,230394,003.1,W*57\r\n";
+    CHECK(gps_parser_feed(&c, BADPOS, sizeof BADPOS - 1U) == GPS_UPD_RMC);
+    CHECK(gps_parser_snapshot(&c, &fc) == 4U && fc.lat.deg == 48 && fc.lon.deg == 11);
+    CHECK(gps_parser_feed(&c, LAT5, sizeof LAT5 - 1U) == GPS_UPD_RMC);
+    CHECK(gps_parser_snapshot(&c, &fc) == 5U && fc.lat.deg == 48 && fc.lat.umin == 7038000);
+
+    /* 時刻の空の RMC（途絶中の受信機）は前の時刻を残さない（UTC も現地も） */
+    static const char VOID[] = "$GPRMC,,V,,,,,,,,,,N*53\r\n";
+    CHECK(gps_parser_feed(&c, VOID, sizeof VOID - 1U) == GPS_UPD_RMC);
+    CHECK(gps_parser_snapshot(&c, &fc) == 6U && fc.utc_hh < 0 && fc.utc_ss < 0 && fc.lcl_hh < 0 && fc.lcl_ss < 0);
+
+    /* 系ごとの GSA の合計は連続が切れたところで確定：途中の公開は前のエポックの合計のまま */
+    static const char GP12[] = "$GPGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.20,0.80,0.90*03\r\n";
+    static const char GL12[] = "$GLGSA,A,3,65,66,67,68,69,70,71,72,73,74,75,76,1.20,0.80,0.90*1F\r\n";
+    static const char GP3[]  = "$GPGSA,A,3,01,02,03,,,,,,,,,,2.10,1.20,1.70*04\r\n";
+    static const char GL2[]  = "$GLGSA,A,3,65,66,,,,,,,,,,,2.10,1.20,1.70*1B\r\n";
+    CHECK(gps_parser_feed(&c, GP12, sizeof GP12 - 1U) == GPS_UPD_GSA);
+    CHECK(gps_parser_feed(&c, GL12, sizeof GL12 - 1U) == GPS_UPD_GSA);
+    CHECK(gps_parser_snapshot(&c, &fc) == 8U && fc.sat_used < 0);
+    CHECK(gps_parser_feed(&c, MUC, sizeof MUC - 1U) == (GPS_UPD_RMC | GPS_UPD_GSA));
+    CHECK(gps_parser_snapshot(&c, &fc) == 9U && fc.sat_used == 24);
+    CHECK(gps_parser_feed(&c, GP3, sizeof GP3 - 1U) == GPS_UPD_GSA);
+    CHECK(gps_parser_snapshot(&c, &fc) == 10U && fc.sat_used == 24 && fc.pdop_c == 210);
+    CHECK(gps_parser_feed(&c, GL2, sizeof GL2 - 1U) == GPS_UPD_GSA);
+    CHECK(gps_parser_snapshot(&c, &fc) == 11U && fc.sat_used == 24);
+    CHECK(gps_parser_feed(&c, MUC, sizeof MUC - 1U) == (GPS_UPD_RMC | GPS_UPD_GSA));
+    CHECK(gps_parser_snapshot(&c, &fc) == 12U && fc.sat_used == 5);
+}
+
+#if TELEM_ENABLE
+/* テレメトリ：USART2 送信 DMA で出たバイト列を COBS/CRC で戻し、種別と中身を確かめる */
+static int uncobs(const uint8_t *in, uint32_t n, uint8_t *out)
+{
+    uint32_t i = 0, o = 0;
+    while(i < n){
+        uint8_t code = in[i++];
+        if(code == 0U || i + code - 1U > n) return -1;
+        for(uint8_t k=1;k<code;k++) out[o++] = in[i++];
+        if(code != 0xFFU && i < n) out[o++] = 0U;
+    }
+    return (int)o;
+}
+
+static uint16_t crc16(const uint8_t *p, int n)
+{
+    uint16_t c = 0xFFFFU;
+    while(n--){
+        c ^= (uint16_t)(*p++ << 8);
+        for(int b=0;b<8;b++) c = (c & 0x8000U) ? (uint16_t)((c << 1) ^ 0x1021U) : (uint16_t)(c << 1);
+    }
+    return c;
+}
+
+static void test_telem(void)
+{
+    sr_model_t m;
+    setup(&m);
+    hal_fake_set_isr(DMA1_Channel7_IRQn, telem_dma_irq);
+    nixie_init();
+    gps_init(&huart1);
+    tk_init();
+    telem_init(&huart2);
+
+    static const char RMC[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+    hal_fake_uart_inject(&huart1, (const uint8_t*)RMC, sizeof RMC - 1U);
+    (void)gps_poll_line();
+    nixie_show_time_hms(12, 35, 19);
+
+    for(uint32_t s=0;s<TELEM_SLOW_EVERY_S;s++){
+        telem_poll(1U, TM_DISP_UTC);
+        hal_fake_advance_us(200000U);
+    }
+    CHECK(!telem_busy());
+    CHECK(telem_drops == 0U);
+
+    static uint8_t rx[4096];
+    uint32_t n = hal_fake_uart_sent(&huart2, rx, sizeof rx);
+    uint32_t cnt[8] = {0}, frames = 0, start = 0;
+    uint8_t  seq = 0;
+    for(uint32_t i=0;i<n;i++){
+        if(rx[i] != 0U) continue;
+        uint8_t raw[128];
+        int k = uncobs(&rx[start], i - start, raw);
+        start = i + 1U;
+        CHECK(k >= 4);
+        if(k < 4) continue;
+        CHECK(crc16(raw, k - 2) == (uint16_t)(raw[k-2] | (raw[k-1] << 8)));
+        CHECK(raw[1] == seq);
+        seq = (uint8_t)(raw[1] + 1U);
+        if(raw[0] < 8U) cnt[raw[0]]++;
+        frames++;
+        if(raw[0] == TM_FIX){
+            CHECK(k - 4 == 47);
+            CHECK(raw[2+36] == 12 && raw[2+37] == 35 && raw[2+38] == 19);
+        }
+        if(raw[0] == TM_DISP){
+            uint16_t exp[8];
+            nixie_time_codes(12, 35, 19, exp);
+            CHECK((uint16_t)(raw[2] | (raw[3] << 8)) == exp[0]);
+            CHECK(raw[2+24] == TM_DISP_UTC);
+        }
+        if(raw[0] == TM_NMEA) CHECK(memcmp(&raw[2], "$GPRMC,123519", 13) == 0);
+    }
+    CHECK(start == n);                             /* 区切りで終わる */
+    CHECK(frames == telem_frames);
+    CHECK(cnt[TM_FIX] == TELEM_SLOW_EVERY_S && cnt[TM_TIME] == TELEM_SLOW_EVERY_S);
+    CHECK(cnt[TM_DISP] == TELEM_SLOW_EVERY_S);
+    CHECK(cnt[TM_GPS] == 1U && cnt[TM_NMEA] == 1U);
+}
+#endif
+
+#if IDLE_ENABLE
+/* 仕事が無ければ次の 1ms まで眠り（TIM6 だけで起きても眠り直す）、
+   受信の区切り・PPS の知らせがあれば時間を進めずに戻る */
+static void test_idle(void)
+{
+    sr_model_t m;
+    setup(&m);
+    nixie_init();
+    nixie_pwm_start();
+    gps_init(&huart1);
+    tk_init();
+    idle_init();
+
+    uint32_t t0 = HAL_GetTick();
+    idle_wait();
+    CHECK(HAL_GetTick() == t0 + 1U);
+    CHECK(idle_wakeups >= 2U);                     /* TIM6 と SysTick */
+
+    static const char RMC[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+    hal_fake_uart_inject(&huart1, (const uint8_t*)RMC, sizeof RMC - 1U);
+    uint64_t n0 = hal_fake_now_ticks();
+    idle_wait();
+    CHECK(hal_fake_now_ticks() == n0);
+    hal_fake_tim_capture(TIM3, 2U);                /* PPS */
+    idle_wait();
+    CHECK(hal_fake_now_ticks() == n0);
+
+    for(int i=0;i<1100;i++) idle_wait();
+    CHECK(idle_busy_pm < 10U);                     /* 本体の仕事は仮想時間を使わない */
+}
+#endif
+
+#if KV_ENABLE
+/* 書き込んだ値が「起動し直し」（kv_init）後に読めるか */
+static uint32_t kv_read32(uint16_t key)
+{
+    uint32_t v = 0;
+    return kv_get(key, &v, sizeof v) ? v : 0xDEADBEEFU;
+}
+
+static void test_kv(void)
+{
+    hal_fake_flash_wipe();
+    kv_init();
+    uint8_t b = 0;
+    CHECK(kv_seq == 1U && !kv_pending() && kv_get(KV_DISP_MODE, &b, 1U) == 0U);
+
+    /* 遅延書込み：kv_set だけではフラッシュは動かず、kv_poll 1回は KV_PROG_PER_POLL 半語まで */
+    uint32_t p0 = hal_fake_flash_progs;
+    b = 1U;
+    CHECK(kv_set(KV_DISP_MODE, &b, 1U) && kv_pending() && hal_fake_flash_progs == p0);
+    kv_poll(0);
+    CHECK(hal_fake_flash_progs - p0 <= KV_PROG_PER_POLL);
+    kv_fix_t pos = { 3568000, 13969000, 1792227600U, 540, 0U }, pr;
+    CHECK(kv_set(KV_LAST_FIX, &pos, sizeof pos));
+    kv_flush();
+    CHECK(!kv_pending());
+    p0 = hal_fake_flash_progs;
+    CHECK(kv_set(KV_DISP_MODE, &b, 1U) && !kv_pending());          /* 同じ値は書かない */
+
+    kv_init();
+    b = 0;
+    CHECK(kv_get(KV_DISP_MODE, &b, 1U) == 1U && b == 1U);
+    CHECK(kv_get(KV_LAST_FIX, &pr, sizeof pr) == sizeof pr && memcmp(&pr, &pos, sizeof pr) == 0);
+    CHECK(kv_get(KV_LAST_FIX, &b, 1U) == 0U);                      /* 長さ違いは読まない */
+    CHECK(hal_fake_flash_progs == p0);
+
+    /* 摩耗の均し：更新を重ねると2ページを交互に詰め直し、消去回数は揃う */
+    for(uint32_t i = 0; i < 3000U; i++){ CHECK(kv_set(0x0100U, &i, sizeof i)); kv_flush(); }
+    CHECK(kv_seq >= 10U);
+    int32_t de = (int32_t)hal_fake_flash_erases[0] - (int32_t)hal_fake_flash_erases[1];
+    CHECK(de >= -1 && de <= 1);
+    kv_init();
+    CHECK(kv_read32(0x0100U) == 2999U && kv_get(KV_DISP_MODE, &b, 1U) && b == 1U);
+
+    /* 消去が許されない間は満杯でも待ち、値は RAM に残る */
+    uint32_t e0 = hal_fake_flash_erases[0] + hal_fake_flash_erases[1];
+    for(uint32_t i = 0; i < 400U; i++){ (void)kv_set(0x0101U, &i, sizeof i); for(int k = 0; k < 8; k++) kv_poll(0); }
+    CHECK(hal_fake_flash_erases[0] + hal_fake_flash_erases[1] == e0 && kv_read32(0x0101U) == 399U);
+    kv_flush();
+    CHECK(!kv_pending());
+
+    /* 電源断：書込み・詰め直し・消去のどの操作の途中で切れても、再起動後は
+       各キーが直前に確定した値かその次の値で、その後も書き続けられる */
+    uint32_t bad = 0;
+    for(int32_t cut = 0; cut < 700; cut += 3){
+        hal_fake_flash_wipe();
+        kv_init();
+        uint32_t v = 0;
+        for(; v < 95U; v++){ (void)kv_set(0x0100U, &v, sizeof v); (void)kv_set(0x0102U, &v, sizeof v); kv_flush(); }
+        hal_fake_flash_cut_after(cut);
+        for(; v < 400U && !hal_fake_flash_dead(); v++){
+            (void)kv_set(0x0100U, &v, sizeof v);
+            (void)kv_set(0x0102U, &v, sizeof v);
+            kv_flush();
+        }
+        uint32_t last = v - 1U;                                     /* 切れた時に書いていた値 */
+        hal_fake_flash_cut_after(-1);
+        kv_init();
+        uint32_t a = kv_read32(0x0100U), c = kv_read32(0x0102U);
+        if(!(a == last || a + 1U == last) || !(c == last || c + 1U == last) || (a == last && c + 1U < last)) bad++;
+        uint32_t w = 1000U;
+        (void)kv_set(0x0100U, &w, sizeof w);
+        kv_flush();
+        kv_init();
+        if(kv_read32(0x0100U) != 1000U || kv_read32(0x0102U) != c) bad++;
+    }
+    CHECK(bad == 0U);
+    hal_fake_flash_wipe();
+}
+#endif
+
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+/* 次の秒を先送りし、PPS の割込みでは STCP だけ叩く。リフレッシュで上書きされても送り直す */
+static void test_pps_latch(void)
+{
+    sr_model_t m;
+    setup(&m);
+    nixie_init();
+    nixie_pwm_start();
+    tk_init();
+    tk_set_pps_hook(nixie_latch_armed);
+
+    gps_fix_t fx;
+    memset(&fx, 0xFF, sizeof fx);
+    fx.utc_hh = 12; fx.utc_mm = 35; fx.utc_ss = 19;
+    hal_fake_tim_capture(TIM3, 2U);
+    tk_on_fix(&fx);
+    CHECK(tk_state() == TK_PPS);
+    hal_fake_advance_us(1000000U);
+    hal_fake_tim_capture(TIM3, 2U);                /* 周期が測れて窓ができる */
+    CHECK(tk_poll() == 1U && tk_utc_sod() == 12*3600 + 35*60 + 20);
+
+    uint16_t now[8], nxt[8];
+    nixie_time_codes(12, 35, 20, now);
+    nixie_time_codes(12, 35, 21, nxt);
+    nixie_show_codes(now);
+    CHECK(nixie_arm_codes(nxt) == 1U);
+    hal_fake_advance_us(200U);
+    CHECK(nixie_arm_state() == NIXIE_ARM_READY);
+    for(int k=0;k<8;k++) CHECK(m.latch[k] == now[7-k]);    /* 送っただけでは変わらない */
+
+    nixie_set_enable_mask(0xFEU);                  /* 次のスロットでリフレッシュが上書き */
+    hal_fake_advance_us(2000U);
+    CHECK(nixie_arm_state() == NIXIE_ARM_READY);
+    CHECK(m.latch[0] == 0U);
+
+    hal_fake_advance_us(1000000U - 2200U);
+    uint32_t w0 = hal_fake_gpio_writes, l0 = m.n_stcp, s0 = m.n_shcp;
+    hal_fake_tim_capture(TIM3, 2U);
+    CHECK(hal_fake_gpio_writes - w0 == 2U);        /* STCP の ↑↓ だけ */
+    CHECK(m.n_stcp == l0 + 1U && m.n_shcp == s0);
+    CHECK(nixie_arm_state() == NIXIE_ARM_SHOWN);
+    CHECK(m.latch[0] == 0U);
+    for(int k=1;k<8;k++) CHECK(m.latch[k] == nxt[7-k]);
+    CHECK(tk_poll() == 1U && tk_utc_sod() == 12*3600 + 35*60 + 21);
+
+    /* 他の表示が入れば取消し、PPS では何も叩かない */
+    CHECK(nixie_arm_codes(now) == 1U);
+    nixie_show_codes(nxt);
+    hal_fake_advance_us(1000000U);
+    l0 = m.n_stcp;
+    hal_fake_tim_capture(TIM3, 2U);
+    CHECK(m.n_stcp == l0);
+    CHECK(nixie_arm_state() == NIXIE_ARM_NONE);
+}
+#endif
+
+/* 起動直後の推定時刻（tk_seed）から GPS の時刻へ。表示は1ずつしか進まず戻らない */
+static int32_t warm_label(int32_t sod)
+{
+    gps_fix_t fx;
+    memset(&fx, 0xFF, sizeof fx);                  /* 未取得は -1 */
+    fx.utc_hh = (int8_t)(sod / 3600); fx.utc_mm = (int8_t)((sod / 60) % 60); fx.utc_ss = (int8_t)(sod % 60);
+    tk_on_fix(&fx);
+
+    /* 10ms ごとに見て、表示の秒の変わり方を確かめる */
+    int32_t shown = tk_utc_sod(), bad = 0;
+    for(int i=0;i<3000 && tk_unsynced();i++){
+        hal_fake_advance_us(10000U);
+        (void)tk_poll();
+        int32_t s = tk_utc_sod();
+        if(s != shown && s != shown + 1) bad++;
+        shown = s;
+    }
+    return bad;
+}
+
+/* t0 の秒境界に lbl を付けたときの今の UTC 通日秒 */
+static int32_t sod_of(uint64_t t0, int32_t lbl){ return lbl + (int32_t)((hal_fake_now_ticks() - t0) / HAL_FAKE_TIM_HZ); }
+
+static void test_warm(void)
+{
+    sr_model_t m;
+    const int32_t LBL = 12*3600 + 35*60 + 19;
+
+    /* 遅れ3秒：半秒ごとに追いつく */
+    setup(&m);
+    tk_init();
+    tk_seed(civil_epoch(1994, 3, 23, 12, 35, 15));
+    CHECK(tk_state() == TK_ESTIMATE && tk_unsynced());
+    CHECK(tk_poll() == 1U && tk_utc_sod() == LBL - 4);
+    hal_fake_tim_capture(TIM3, 2U);                /* ラベルの無い PPS では推定のまま */
+    CHECK(tk_state() == TK_ESTIMATE);
+    hal_fake_advance_us(1000000U);
+    CHECK(tk_poll() == 1U && tk_utc_sod() == LBL - 3);
+    uint64_t t0 = hal_fake_now_ticks();
+    CHECK(warm_label(LBL) == 0);
+    CHECK(!tk_unsynced() && tk_state() == TK_NMEA);
+    CHECK(hal_fake_now_ticks() - t0 <= 3U * HAL_FAKE_TIM_HZ);
+    hal_fake_advance_us(1000000U);
+    (void)tk_poll();
+    CHECK(tk_utc_sod() == sod_of(t0, LBL));
+
+    /* 進み7秒：2秒に1度据え置いて待つ */
+    setup(&m);
+    tk_init();
+    tk_seed(civil_epoch(1994, 3, 23, 12, 35, 26));
+    (void)tk_poll();
+    t0 = hal_fake_now_ticks();
+    CHECK(warm_label(LBL) == 0);
+    CHECK(!tk_unsynced());
+    CHECK(hal_fake_now_ticks() - t0 <= 15U * HAL_FAKE_TIM_HZ);
+    CHECK(tk_utc_sod() == sod_of(t0, LBL));
+
+    /* 差が大きければ跳ぶ */
+    setup(&m);
+    tk_init();
+    tk_seed(civil_epoch(1994, 3, 23, 13, 0, 0));
+    (void)tk_poll();
+    CHECK(warm_label(LBL) == 0);
+    CHECK(!tk_unsynced() && tk_utc_sod() == LBL);
+    CHECK(tk_state() == TK_NMEA);
+
+#if RTC_ENABLE
+    /* RTC はリセットを跨いで進み、VBAT の無い電源断で失う */
+    int64_t t;
+    hal_fake_rtc_lose();
+    rtc_init();
+    CHECK(rtc_get(&t) == 0U);
+    rtc_set(civil_epoch(2026, 10, 17, 9, 0, 0));
+    hal_fake_advance_us(5000000U);
+    setup(&m);
+    rtc_init();
+    CHECK(rtc_get(&t) == 1U && t == civil_epoch(2026, 10, 17, 9, 0, 5));
+    hal_fake_rtc_lose();
+    CHECK(rtc_get(&t) == 0U);
+#endif
+}
+
+int main(void)
+{
+    test_frame();
+    test_pwm();
+    test_gps();
+    test_civil();
+    test_gps_overflow();
+    test_gps_parsers();
+#if TELEM_ENABLE
+    test_telem();
+#endif
+#if IDLE_ENABLE
+    test_idle();
+#endif
+#if KV_ENABLE
+    test_kv();
+#endif
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+    test_pps_latch();
+#endif
+    test_warm();
+    if(s_fail){ printf("%d check(s) failed\n", s_fail); return 1; }
+    puts("host_smoke: OK");
+    return 0;
+}
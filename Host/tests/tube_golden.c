@@ -0,0 +1,209 @@
+/* 表示の黄金フレーム：nixie.c の GPIO 書込みを tube_sim で管の点灯へ戻し、ラッチごとの
+   1行（時刻・シフト回数・グリッチ・管の絵）を下の期待値と突き合わせる。
+   送出の手順や PWM の並びを変えたら tube_golden -u で今の出力を出し、確かめて貼り替える */
+#include "hal_fake.h"
+#include "nixie.h"
+#include "timekeep.h"
+#include "tube_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_fail = 0;
+#define CHECK(c) do{ if(!(c)){ printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); s_fail++; } }while(0)
+
+#define LOG_MAX 64
+static tube_sim_t s_sim;
+static ts_frame_t s_log[LOG_MAX];
+
+static void setup(void)
+{
+    hal_fake_reset();
+    tube_sim_attach(&s_sim, s_log, LOG_MAX);
+    hal_fake_set_isr(TIM3_IRQn, tk_capture_irq);
+    hal_fake_set_isr(TIM6_DAC1_IRQn, nixie_pwm_irq);
+#if NIXIE_USE_DMA
+    hal_fake_set_isr(DMA1_Channel3_IRQn, nixie_dma_irq);
+#endif
+    nixie_init();
+}
+
+/* ==== 場面 ============================================================ */
+static void scene_time(void)
+{
+    nixie_show_time_hms(12, 34, 56);
+    hal_fake_advance_us(100);
+    nixie_show_integer8_str("-1234567");
+    hal_fake_advance_us(100);
+    nixie_show_decimal_str("3.1415926");
+    hal_fake_advance_us(100);
+}
+
+/* 半分の輝度：桁ごとに 1/8 周期ずれた点灯窓（1フレーム = NIXIE_PWM_STEPS スロット） */
+static void scene_pwm(void)
+{
+    nixie_pwm_start();
+    nixie_show_digits_lr(1, 2, 3, 4, 5, 6, 7, 8);
+    nixie_set_brightness(NIXIE_PWM_STEPS / 2U);
+    hal_fake_advance_us(1000000U / NIXIE_PWM_FRAME_HZ);
+}
+
+/* カソード巡回：1周（10ステップ）、最後に元の表示へ戻る */
+static void scene_acp(void)
+{
+    nixie_pwm_start();
+    nixie_show_digits_lr(2, 0, 2, 6, 1, 0, 1, 7);
+    hal_fake_advance_us(100);
+    CHECK(nixie_acp_start(1, 2));
+    hal_fake_advance_us(25000U);
+    CHECK(!nixie_acp_active());
+}
+
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+/* 先送り：シフトは前もって済み、PPS でラッチだけ（シフト回数 12、ラッチの遅れが長い） */
+static void scene_arm(void)
+{
+    nixie_show_time_hms(23, 59, 59);
+    hal_fake_advance_us(100);
+    uint16_t v[8];
+    nixie_time_codes(0, 0, 0, v);
+    CHECK(nixie_arm_codes(v));
+    hal_fake_advance_us(500000U);
+    CHECK(nixie_arm_state() == NIXIE_ARM_READY);
+    nixie_latch_armed();
+    CHECK(nixie_arm_state() == NIXIE_ARM_SHOWN);
+}
+#endif
+
+/* ==== 期待値 ========================================================== */
+/* NIXIE_USE_DMA=1：送出に 11.8µs（最後の SHCP↑が 23周期＋CCR2 の後）、PWM の最初のスロットより前に全桁のフレームが1枚出る */
+#if NIXIE_USE_DMA
+static const char *const G_TIME[] = {
+    "      11.8us sh=12  -- | 1  2 .   3  4 .   5  6 |",
+    "     111.8us sh=12  -- |. . 1  2  3  4  5  6  7 |",
+    "     211.8us sh=12  -- | 3 .   1  4  1  5  9  2 |",
+    NULL
+};
+static const char *const G_PWM[] = {
+    "      11.8us sh=12  -- | 1  2  3  4  5  6  7  8 |",
+    "     636.8us sh=12  -- | 1  2  3  4             |",
+    "    1261.8us sh=12  -- | 1  2  3              8 |",
+    "    2511.8us sh=12  -- | 1  2              7  8 |",
+    "    3761.8us sh=12  -- | 1              6  7  8 |",
+    "    5011.8us sh=12  -- |             5  6  7  8 |",
+    "    6261.8us sh=12  -- |          4  5  6  7    |",
+    "    7511.8us sh=12  -- |       3  4  5  6       |",
+    "    8761.8us sh=12  -- |    2  3  4  5          |",
+    NULL
+};
+static const char *const G_ACP[] = {
+    "      11.8us sh=12  -- | 2  0  2  6  1  0  1  7 |",
+    "     636.8us sh=12  -- | 0  1  2  3  4  5  6  7 |",
+    "    1886.8us sh=12  -- | 1  2  3  4  5  6  7  8 |",
+    "    3761.8us sh=12  -- | 2  3  4  5  6  7  8  9 |",
+    "    5636.8us sh=12  -- | 3  4  5  6  7  8  9  0 |",
+    "    7511.8us sh=12  -- | 4  5  6  7  8  9  0  1 |",
+    "    9386.8us sh=12  -- | 5  6  7  8  9  0  1  2 |",
+    "   11261.8us sh=12  -- | 6  7  8  9  0  1  2  3 |",
+    "   13136.8us sh=12  -- | 7  8  9  0  1  2  3  4 |",
+    "   15011.8us sh=12  -- | 8  9  0  1  2  3  4  5 |",
+    "   16886.8us sh=12  -- | 9  0  1  2  3  4  5  6 |",
+    "   18761.8us sh=12  -- | 2  0  2  6  1  0  1  7 |",
+    NULL
+};
+#if NIXIE_PPS_LATCH
+static const char *const G_ARM[] = {
+    "      11.8us sh=12  -- | 2  3 .   5  9 .   5  9 |",
+    "  500100.0us sh=12  -- | 0  0 .   0  0 .   0  0 |",
+    NULL
+};
+#endif
+
+#else
+/* NIXIE_USE_DMA=0：CPU の直書きは仮想時間を使わない。PWM 中の表示は割込み側が送る */
+static const char *const G_TIME[] = {
+    "       0.0us sh=12  -- | 1  2 .   3  4 .   5  6 |",
+    "     100.0us sh=12  -- |. . 1  2  3  4  5  6  7 |",
+    "     200.0us sh=12  -- | 3 .   1  4  1  5  9  2 |",
+    NULL
+};
+static const char *const G_PWM[] = {
+    "     625.0us sh=12  -- | 1  2  3  4             |",
+    "    1250.0us sh=12  -- | 1  2  3              8 |",
+    "    2500.0us sh=12  -- | 1  2              7  8 |",
+    "    3750.0us sh=12  -- | 1              6  7  8 |",
+    "    5000.0us sh=12  -- |             5  6  7  8 |",
+    "    6250.0us sh=12  -- |          4  5  6  7    |",
+    "    7500.0us sh=12  -- |       3  4  5  6       |",
+    "    8750.0us sh=12  -- |    2  3  4  5          |",
+    "   10000.0us sh=12  -- | 1  2  3  4             |",
+    NULL
+};
+static const char *const G_ACP[] = {
+    "     625.0us sh=12  -- | 0  1  2  3  4  5  6  7 |",
+    "    1875.0us sh=12  -- | 1  2  3  4  5  6  7  8 |",
+    "    3750.0us sh=12  -- | 2  3  4  5  6  7  8  9 |",
+    "    5625.0us sh=12  -- | 3  4  5  6  7  8  9  0 |",
+    "    7500.0us sh=12  -- | 4  5  6  7  8  9  0  1 |",
+    "    9375.0us sh=12  -- | 5  6  7  8  9  0  1  2 |",
+    "   11250.0us sh=12  -- | 6  7  8  9  0  1  2  3 |",
+    "   13125.0us sh=12  -- | 7  8  9  0  1  2  3  4 |",
+    "   15000.0us sh=12  -- | 8  9  0  1  2  3  4  5 |",
+    "   16875.0us sh=12  -- | 9  0  1  2  3  4  5  6 |",
+    "   18750.0us sh=12  -- | 2  0  2  6  1  0  1  7 |",
+    NULL
+};
+#endif
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+    const char *const *golden;
+} scene_t;
+
+static const scene_t SCENES[] = {
+    { "time", scene_time, G_TIME },
+    { "pwm",  scene_pwm,  G_PWM  },
+    { "acp",  scene_acp,  G_ACP  },
+#if NIXIE_USE_DMA && NIXIE_PPS_LATCH
+    { "arm",  scene_arm,  G_ARM  },
+#endif
+};
+
+static void run_scene(const scene_t *sc, int update)
+{
+    setup();
+    sc->run();
+
+    char line[96];
+    uint32_t i = 0;
+    if(update) printf("/* %s */\n", sc->name);
+    for(; i < s_sim.n_log; i++){
+        tube_sim_render_frame(&s_log[i], line, sizeof line);
+        if(update){ printf("    \"%s\",\n", line); continue; }
+        if(!sc->golden[i]){ printf("FAIL %s: extra frame %u: %s\n", sc->name, (unsigned)i, line); s_fail++; break; }
+        if(strcmp(line, sc->golden[i]) != 0){
+            printf("FAIL %s: frame %u\n  want %s\n  got  %s\n", sc->name, (unsigned)i, sc->golden[i], line);
+            s_fail++;
+        }
+    }
+    if(!update && i == s_sim.n_log && sc->golden[i]){
+        printf("FAIL %s: missing frame %u: %s\n", sc->name, (unsigned)i, sc->golden[i]);
+        s_fail++;
+    }
+    CHECK(s_sim.n_log < LOG_MAX);
+    CHECK(s_sim.n_glitch == 0U);
+#if NIXIE_USE_DMA
+    /* 半ステップ NIXIE_DMA_STEP_TICKS(16) ×2 ごとに SHCP↑、最後の半ステップで STCP↑ */
+    CHECK(s_sim.n_full == 0U || s_sim.sum_shift == (uint64_t)s_sim.n_full * 11U * 32U);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    int update = (argc > 1 && strcmp(argv[1], "-u") == 0);
+    for(size_t i=0;i<sizeof SCENES/sizeof SCENES[0];i++) run_scene(&SCENES[i], update);
+    if(update) return 0;
+    if(s_fail){ printf("%d check(s) failed\n", s_fail); return 1; }
+    puts("tube_golden: OK");
+    return 0;
+}
@@ -0,0 +1,360 @@
+/* 時差表（tz_table.c）と規則計算（tz.c）を、ホストの tzdata（glibc の localtime_r）と突き合わせる。
+   ・規則ごと：代表区域の時差を 2026〜2037年の6時間おき＋各切替の前後1秒で比べる
+   ・都市ごと：矩形の照合で引いた規則の時差を、その都市の本来の区域と1月・7月で比べる
+   ・海上の航海時、移動量による引き直しの省略、照合の所要時間
+   /usr/share/zoneinfo が無い環境では SKIP（77） */
+#define _GNU_SOURCE
+#include "tz.h"
+#include "civil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static int s_fail = 0;
+#define CHECK(c) do{ if(!(c)){ printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); s_fail++; } }while(0)
+
+/* モロッコ（ラマダン中の切替）は POSIX 文字列に出ないので比べない */
+static int skip_zone(const char *z){ return !strcmp(z, "Africa/Casablanca") || !strcmp(z, "Africa/El_Aaiun"); }
+
+static int ref_offset(const char *zone, int64_t t)
+{
+    static char cur[64];
+    if(strcmp(cur, zone)){
+        snprintf(cur, sizeof cur, "%s", zone);
+        setenv("TZ", zone, 1);
+        tzset();
+    }
+    time_t tt = (time_t)t;
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    return (int)(tm.tm_gmtoff / 60);
+}
+
+static void test_rules(void)
+{
+    const int64_t t0 = civil_epoch(2026, 1, 1, 0, 0, 0), t1 = civil_epoch(2038, 1, 1, 0, 0, 0);
+    int n = 0;
+
+    for(uint8_t r = 0; r < TZ_N_RULES; r++){
+        const char *z = TZ_NAMES[r];
+        if(skip_zone(z)) continue;
+        int bad = 0;
+        for(int64_t t = t0; t < t1 && bad < 3; t += 6 * 3600){
+            int ref = ref_offset(z, t), got = tz_rule_offset(r, t);
+            if(ref != got){ printf("FAIL %-22s t=%lld ref=%d got=%d\n", z, (long long)t, ref, got); bad++; }
+            n++;
+        }
+        const tz_rule_t *ru = &TZ_RULES[r];
+        if(ru->start.mon){
+            for(int y = 2026; y < 2038; y++){
+                int64_t e[2] = { tz_when_utc(&ru->start, y, ru->std_min), tz_when_utc(&ru->end, y, ru->dst_min) };
+                for(int k = 0; k < 2; k++){
+                    for(int d = -1; d <= 0; d++){
+                        int ref = ref_offset(z, e[k] + d), got = tz_rule_offset(r, e[k] + d);
+                        if(ref != got){ printf("FAIL %-22s %d %s%+d ref=%d got=%d\n", z, y, k ? "end" : "start", d, ref, got); bad++; }
+                        n++;
+                    }
+                    CHECK(ref_offset(z, e[k] - 1) != ref_offset(z, e[k]));   /* 本当に切替の瞬間 */
+                }
+            }
+        }
+        s_fail += bad;
+    }
+    printf("rules: %u rules, %d instants\n", TZ_N_RULES, n);
+}
+
+typedef struct { const char *name; double lat, lon; const char *zone; } city_t;
+
+static const city_t CITIES[] = {
+    { "Reykjavik",      64.15, -21.94, "Atlantic/Reykjavik" },
+    { "Lisbon",         38.72,  -9.14, "Europe/Lisbon" },
+    { "Porto",          41.15,  -8.61, "Europe/Lisbon" },
+    { "Funchal",        32.65, -16.91, "Atlantic/Madeira" },
+    { "Ponta Delgada",  37.74, -25.67, "Atlantic/Azores" },
+    { "Las Palmas",     28.12, -15.43, "Atlantic/Canary" },
+    { "Madrid",         40.42,  -3.70, "Europe/Madrid" },
+    { "Barcelona",      41.39,   2.17, "Europe/Madrid" },
+    { "Dublin",         53.35,  -6.26, "Europe/Dublin" },
+    { "London",         51.51,  -0.13, "Europe/London" },
+    { "Edinburgh",      55.95,  -3.19, "Europe/London" },
+    { "Belfast",        54.60,  -5.93, "Europe/London" },
+    { "Paris",          48.86,   2.35, "Europe/Paris" },
+    { "Brussels",       50.85,   4.35, "Europe/Brussels" },
+    { "Amsterdam",      52.37,   4.90, "Europe/Amsterdam" },
+    { "Berlin",         52.52,  13.40, "Europe/Berlin" },
+    { "Munich",         48.14,  11.58, "Europe/Berlin" },
+    { "Copenhagen",     55.68,  12.57, "Europe/Copenhagen" },
+    { "Oslo",           59.91,  10.75, "Europe/Oslo" },
+    { "Stockholm",      59.33,  18.07, "Europe/Stockholm" },
+    { "Warsaw",         52.23,  21.01, "Europe/Warsaw" },
+    { "Vienna",         48.21,  16.37, "Europe/Vienna" },
+    { "Rome",           41.90,  12.50, "Europe/Rome" },
+    { "Belgrade",       44.79,  20.45, "Europe/Belgrade" },
+    { "Helsinki",       60.17,  24.94, "Europe/Helsinki" },
+    { "Tallinn",        59.44,  24.75, "Europe/Tallinn" },
+    { "Riga",           56.95,  24.11, "Europe/Riga" },
+    { "Vilnius",        54.69,  25.28, "Europe/Vilnius" },
+    { "Kaliningrad",    54.71,  20.51, "Europe/Kaliningrad" },
+    { "Minsk",          53.90,  27.57, "Europe/Minsk" },
+    { "Kyiv",           50.45,  30.52, "Europe/Kyiv" },
+    { "Chisinau",       47.01,  28.86, "Europe/Chisinau" },
+    { "Bucharest",      44.43,  26.10, "Europe/Bucharest" },
+    { "Sofia",          42.70,  23.32, "Europe/Sofia" },
+    { "Athens",         37.98,  23.73, "Europe/Athens" },
+    { "Thessaloniki",   40.64,  22.94, "Europe/Athens" },
+    { "Istanbul",       41.01,  28.98, "Europe/Istanbul" },
+    { "Ankara",         39.93,  32.86, "Europe/Istanbul" },
+    { "Nicosia",        35.17,  33.36, "Asia/Nicosia" },
+    { "Beirut",         33.89,  35.50, "Asia/Beirut" },
+    { "Jerusalem",      31.77,  35.21, "Asia/Jerusalem" },
+    { "Tel Aviv",       32.09,  34.78, "Asia/Jerusalem" },
+    { "Cairo",          30.04,  31.24, "Africa/Cairo" },
+    { "Riyadh",         24.71,  46.68, "Asia/Riyadh" },
+    { "Dammam",         26.43,  50.10, "Asia/Riyadh" },
+    { "Doha",           25.29,  51.53, "Asia/Qatar" },
+    { "Dubai",          25.20,  55.27, "Asia/Dubai" },
+    { "Muscat",         23.59,  58.41, "Asia/Muscat" },
+    { "Tehran",         35.69,  51.39, "Asia/Tehran" },
+    { "Tabriz",         38.08,  46.29, "Asia/Tehran" },
+    { "Bandar Abbas",   27.18,  56.27, "Asia/Tehran" },
+    { "Tbilisi",        41.72,  44.79, "Asia/Tbilisi" },
+    { "Moscow",         55.76,  37.62, "Europe/Moscow" },
+    { "St Petersburg",  59.93,  30.34, "Europe/Moscow" },
+    { "Samara",         53.20,  50.15, "Europe/Samara" },
+    { "Yekaterinburg",  56.84,  60.61, "Asia/Yekaterinburg" },
+    { "Omsk",           54.99,  73.37, "Asia/Omsk" },
+    { "Novosibirsk",    55.01,  82.93, "Asia/Novosibirsk" },
+    { "Krasnoyarsk",    56.01,  92.89, "Asia/Krasnoyarsk" },
+    { "Irkutsk",        52.29, 104.28, "Asia/Irkutsk" },
+    { "Yakutsk",        62.03, 129.73, "Asia/Yakutsk" },
+    { "Vladivostok",    43.12, 131.89, "Asia/Vladivostok" },
+    { "Magadan",        59.56, 150.80, "Asia/Magadan" },
+    { "Petropavlovsk",  53.02, 158.65, "Asia/Kamchatka" },
+    { "Anadyr",         64.73, 177.51, "Asia/Anadyr" },
+    { "Almaty",         43.24,  76.89, "Asia/Almaty" },
+    { "Tashkent",       41.30,  69.24, "Asia/Tashkent" },
+    { "Bishkek",        42.87,  74.59, "Asia/Bishkek" },
+    { "Ashgabat",       37.95,  58.38, "Asia/Ashgabat" },
+    { "Kabul",          34.56,  69.21, "Asia/Kabul" },
+    { "Karachi",        24.86,  67.01, "Asia/Karachi" },
+    { "Lahore",         31.55,  74.34, "Asia/Karachi" },
+    { "Delhi",          28.61,  77.21, "Asia/Kolkata" },
+    { "Mumbai",         19.08,  72.88, "Asia/Kolkata" },
+    { "Kolkata",        22.57,  88.36, "Asia/Kolkata" },
+    { "Chennai",        13.08,  80.27, "Asia/Kolkata" },
+    { "Guwahati",       26.14,  91.74, "Asia/Kolkata" },
+    { "Colombo",         6.93,  79.86, "Asia/Colombo" },
+    { "Kathmandu",      27.72,  85.32, "Asia/Kathmandu" },
+    { "Thimphu",        27.47,  89.64, "Asia/Thimphu" },
+    { "Dhaka",          23.81,  90.41, "Asia/Dhaka" },
+    { "Yangon",         16.87,  96.20, "Asia/Yangon" },
+    { "Mandalay",       21.97,  96.08, "Asia/Yangon" },
+    { "Bangkok",        13.76, 100.50, "Asia/Bangkok" },
+    { "Chiang Mai",     18.79,  98.98, "Asia/Bangkok" },
+    { "Hanoi",          21.03, 105.85, "Asia/Bangkok" },
+    { "Ho Chi Minh",    10.82, 106.63, "Asia/Ho_Chi_Minh" },
+    { "Kuala Lumpur",    3.14, 101.69, "Asia/Kuala_Lumpur" },
+    { "Singapore",       1.35, 103.82, "Asia/Singapore" },
+    { "Jakarta",        -6.21, 106.85, "Asia/Jakarta" },
+    { "Denpasar",       -8.65, 115.22, "Asia/Makassar" },
+    { "Manila",         14.60, 120.98, "Asia/Manila" },
+    { "Beijing",        39.90, 116.41, "Asia/Shanghai" },
+    { "Shanghai",       31.23, 121.47, "Asia/Shanghai" },
+    { "Urumqi",         43.83,  87.62, "Asia/Shanghai" },
+    { "Kunming",        25.04, 102.71, "Asia/Shanghai" },
+    { "Harbin",         45.80, 126.53, "Asia/Shanghai" },
+    { "Hong Kong",      22.32, 114.17, "Asia/Hong_Kong" },
+    { "Taipei",         25.03, 121.57, "Asia/Taipei" },
+    { "Ulaanbaatar",    47.89, 106.91, "Asia/Ulaanbaatar" },
+    { "Seoul",          37.57, 126.98, "Asia/Seoul" },
+    { "Busan",          35.18, 129.08, "Asia/Seoul" },
+    { "Pyongyang",      39.04, 125.76, "Asia/Pyongyang" },
+    { "Tokyo",          35.68, 139.69, "Asia/Tokyo" },
+    { "Sapporo",        43.06, 141.35, "Asia/Tokyo" },
+    { "Naha",           26.21, 127.68, "Asia/Tokyo" },
+    { "Perth",         -31.95, 115.86, "Australia/Perth" },
+    { "Darwin",        -12.46, 130.84, "Australia/Darwin" },
+    { "Adelaide",      -34.93, 138.60, "Australia/Adelaide" },
+    { "Brisbane",      -27.47, 153.03, "Australia/Brisbane" },
+    { "Sydney",        -33.87, 151.21, "Australia/Sydney" },
+    { "Melbourne",     -37.81, 144.96, "Australia/Melbourne" },
+    { "Hobart",        -42.88, 147.33, "Australia/Hobart" },
+    { "Port Moresby",   -9.44, 147.18, "Pacific/Port_Moresby" },
+    { "Auckland",      -36.85, 174.76, "Pacific/Auckland" },
+    { "Christchurch",  -43.53, 172.64, "Pacific/Auckland" },
+    { "Suva",          -18.14, 178.44, "Pacific/Fiji" },
+    { "Apia",          -13.83,-171.76, "Pacific/Apia" },
+    { "Honolulu",       21.31,-157.86, "Pacific/Honolulu" },
+    { "Anchorage",      61.22,-149.90, "America/Anchorage" },
+    { "Vancouver",      49.28,-123.12, "America/Vancouver" },
+    { "Seattle",        47.61,-122.33, "America/Los_Angeles" },
+    { "San Francisco",  37.77,-122.42, "America/Los_Angeles" },
+    { "Los Angeles",    34.05,-118.24, "America/Los_Angeles" },
+    { "Las Vegas",      36.17,-115.14, "America/Los_Angeles" },
+    { "Phoenix",        33.45,-112.07, "America/Phoenix" },
+    { "Salt Lake City", 40.76,-111.89, "America/Denver" },
+    { "Denver",         39.74,-104.99, "America/Denver" },
+    { "Calgary",        51.05,-114.07, "America/Edmonton" },
+    { "Regina",         50.45,-104.62, "America/Regina" },
+    { "Winnipeg",       49.90, -97.14, "America/Winnipeg" },
+    { "Dallas",         32.78, -96.80, "America/Chicago" },
+    { "Chicago",        41.88, -87.63, "America/Chicago" },
+    { "Minneapolis",    44.98, -93.27, "America/Chicago" },
+    { "New Orleans",    29.95, -90.07, "America/Chicago" },
+    { "Atlanta",        33.75, -84.39, "America/New_York" },
+    { "Miami",          25.76, -80.19, "America/New_York" },
+    { "Washington",     38.91, -77.04, "America/New_York" },
+    { "New York",       40.71, -74.01, "America/New_York" },
+    { "Boston",         42.36, -71.06, "America/New_York" },
+    { "Detroit",        42.33, -83.05, "America/Detroit" },
+    { "Toronto",        43.65, -79.38, "America/Toronto" },
+    { "Montreal",       45.50, -73.57, "America/Toronto" },
+    { "Halifax",        44.65, -63.57, "America/Halifax" },
+    { "St John's",      47.56, -52.71, "America/St_Johns" },
+    { "Nuuk",           64.18, -51.72, "America/Nuuk" },
+    { "Havana",         23.11, -82.37, "America/Havana" },
+    { "Nassau",         25.05, -77.35, "America/Nassau" },
+    { "Kingston",       17.97, -76.79, "America/Jamaica" },
+    { "Port-au-Prince", 18.59, -72.31, "America/Port-au-Prince" },
+    { "Santo Domingo",  18.49, -69.93, "America/Santo_Domingo" },
+    { "San Juan",       18.47, -66.11, "America/Puerto_Rico" },
+    { "Tijuana",        32.51,-117.04, "America/Tijuana" },
+    { "Hermosillo",     29.07,-110.96, "America/Hermosillo" },
+    { "Mazatlan",       23.25,-106.41, "America/Mazatlan" },
+    { "Mexico City",    19.43, -99.13, "America/Mexico_City" },
+    { "Monterrey",      25.69,-100.32, "America/Monterrey" },
+    { "Cancun",         21.16, -86.85, "America/Cancun" },
+    { "Guatemala",      14.63, -90.51, "America/Guatemala" },
+    { "San Jose CR",     9.93, -84.08, "America/Costa_Rica" },
+    { "Panama",          8.98, -79.52, "America/Panama" },
+    { "Bogota",          4.71, -74.07, "America/Bogota" },
+    { "Caracas",        10.48, -66.90, "America/Caracas" },
+    { "Quito",          -0.18, -78.47, "America/Guayaquil" },
+    { "Lima",          -12.05, -77.04, "America/Lima" },
+    { "La Paz",        -16.49, -68.12, "America/La_Paz" },
+    { "Santiago",      -33.45, -70.67, "America/Santiago" },
+    { "Punta Arenas",  -53.16, -70.92, "America/Punta_Arenas" },
+    { "Asuncion",      -25.26, -57.58, "America/Asuncion" },
+    { "Buenos Aires",  -34.60, -58.38, "America/Argentina/Buenos_Aires" },
+    { "Montevideo",    -34.90, -56.16, "America/Montevideo" },
+    { "Sao Paulo",     -23.55, -46.63, "America/Sao_Paulo" },
+    { "Rio de Janeiro",-22.91, -43.17, "America/Sao_Paulo" },
+    { "Manaus",         -3.12, -60.02, "America/Manaus" },
+    { "Cuiaba",        -15.60, -56.10, "America/Cuiaba" },
+    { "Algiers",        36.75,   3.06, "Africa/Algiers" },
+    { "Tunis",          36.81,  10.18, "Africa/Tunis" },
+    { "Tripoli",        32.89,  13.19, "Africa/Tripoli" },
+    { "Dakar",          14.72, -17.47, "Africa/Dakar" },
+    { "Abidjan",         5.36,  -4.01, "Africa/Abidjan" },
+    { "Accra",           5.60,  -0.19, "Africa/Accra" },
+    { "Lagos",           6.52,   3.38, "Africa/Lagos" },
+    { "Kinshasa",       -4.44,  15.27, "Africa/Kinshasa" },
+    { "Lubumbashi",    -11.66,  27.48, "Africa/Lubumbashi" },
+    { "Khartoum",       15.50,  32.56, "Africa/Khartoum" },
+    { "Addis Ababa",     9.03,  38.74, "Africa/Addis_Ababa" },
+    { "Nairobi",        -1.29,  36.82, "Africa/Nairobi" },
+    { "Dar es Salaam",  -6.79,  39.21, "Africa/Dar_es_Salaam" },
+    { "Luanda",         -8.84,  13.23, "Africa/Luanda" },
+    { "Windhoek",      -22.56,  17.07, "Africa/Windhoek" },
+    { "Johannesburg",  -26.20,  28.05, "Africa/Johannesburg" },
+    { "Cape Town",     -33.92,  18.42, "Africa/Johannesburg" },
+    { "Maputo",        -25.97,  32.57, "Africa/Maputo" },
+    { "Antananarivo",  -18.88,  47.51, "Indian/Antananarivo" },
+    { "Port Louis",    -20.16,  57.50, "Indian/Mauritius" },
+};
+
+static int32_t cdeg(double d){ return (int32_t)(d * 100.0 + (d < 0 ? -0.5 : 0.5)); }
+
+static void test_cities(void)
+{
+    const int64_t ts[2] = { civil_epoch(2026, 1, 15, 12, 0, 0), civil_epoch(2026, 7, 15, 12, 0, 0) };
+    unsigned n = sizeof CITIES / sizeof CITIES[0], bad = 0;
+
+    for(unsigned i = 0; i < n; i++){
+        const city_t *c = &CITIES[i];
+        if(skip_zone(c->zone)) continue;
+        uint8_t r = tz_lookup(cdeg(c->lat), cdeg(c->lon));
+        for(int k = 0; k < 2; k++){
+            int ref = ref_offset(c->zone, ts[k]), got = tz_rule_offset(r, ts[k]);
+            if(r == TZ_NONE || ref != got){
+                printf("FAIL %-15s %s: %s ref=%d got=%d (%s)\n", c->name, k ? "Jul" : "Jan", c->zone, ref, got,
+                       r == TZ_NONE ? "none" : TZ_NAMES[r]);
+                bad++;
+                break;
+            }
+        }
+    }
+    s_fail += (int)bad;
+    printf("cities: %u points, %u wrong\n", n, bad);
+}
+
+static void test_state(void)
+{
+    tz_update(cdeg(35.68), cdeg(139.69));                   /* 東京 */
+    CHECK(tz_rule() != TZ_NONE && tz_std_offset() == 540);
+    CHECK(!strcmp(TZ_NAMES[tz_rule()], tz_name()));
+    tz_update(cdeg(35.68) + 3, cdeg(139.69) + 1);           /* 4 < TZ_MOVE_CDEG：引き直さない */
+    tz_update(cdeg(0.0), cdeg(-140.0));                     /* 太平洋の真ん中：航海時 -9h */
+    CHECK(tz_rule() == TZ_NONE && tz_offset(0) == -540 && tz_name()[0] == '\0');
+    tz_update(cdeg(0.0), cdeg(-140.0) + 4);                 /* 少し動いただけなら据え置き */
+    CHECK(tz_rule() == TZ_NONE);
+    tz_update(cdeg(30.0), cdeg(-45.0));                     /* 大西洋 -3h */
+    CHECK(tz_offset(0) == -180);
+    tz_update(cdeg(-10.0), cdeg(179.9));                    /* 日付変更線の手前 +12h */
+    CHECK(tz_std_offset() == 720);
+
+    /* 夏時間の切替（ベルリン、2026-03-29 01:00Z / 2026-10-25 01:00Z）。キャッシュを跨いで */
+    tz_update(cdeg(52.52), cdeg(13.40));
+    int64_t on = civil_epoch(2026, 3, 29, 1, 0, 0), off = civil_epoch(2026, 10, 25, 1, 0, 0);
+    CHECK(tz_offset(on - 1) == 60 && tz_offset(on) == 120);
+    CHECK(tz_offset(off - 1) == 120 && tz_offset(off) == 60);
+    CHECK(tz_offset(civil_epoch(2027, 7, 1, 0, 0, 0)) == 120 && tz_offset(civil_epoch(2026, 12, 31, 23, 30, 0)) == 60);
+    /* 南半球（シドニー）：年を跨いで夏時間 */
+    tz_update(cdeg(-33.87), cdeg(151.21));
+    CHECK(tz_offset(civil_epoch(2026, 1, 1, 0, 0, 0)) == 660 && tz_offset(civil_epoch(2026, 7, 1, 0, 0, 0)) == 600);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(void)
+{
+    const int N = 200000;
+    volatile uint32_t sink = 0;
+
+    double t = now_s();
+    for(int i = 0; i < N; i++) sink += tz_lookup(0, -14000 + (i & 7));    /* 海上：全矩形を見て外れる */
+    double worst = (now_s() - t) / N * 1e9;
+
+    tz_update(cdeg(52.52), cdeg(13.40));
+    int64_t e = civil_epoch(2026, 6, 1, 0, 0, 0);
+    t = now_s();
+    for(int i = 0; i < N; i++){ tz_update(cdeg(52.52) + (i & 1), cdeg(13.40)); sink += (uint32_t)tz_offset(e + i); }
+    double per_fix = (now_s() - t) / N * 1e9;
+    (void)sink;
+
+    printf("lookup: %u boxes, worst %.0f ns; per fix (update+offset, cached) %.0f ns; table %zu bytes\n",
+           TZ_N_BOXES, worst, per_fix,
+           (size_t)TZ_N_BOXES * sizeof(tz_box_t) + (size_t)TZ_N_RULES * sizeof(tz_rule_t));
+}
+
+int main(void)
+{
+    if(access("/usr/share/zoneinfo/Europe/Berlin", R_OK) != 0){
+        printf("SKIP: no tzdata in /usr/share/zoneinfo\n");
+        return 77;
+    }
+    test_rules();
+    test_cities();
+    test_state();
+    bench();
+    if(s_fail){ printf("%d failure(s)\n", s_fail); return 1; }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,664 @@
+/* 全体の模擬（Linux）。本体（user_setup / user_loop と割込み）を HAL 代用品の仮想時間で回し、
+   GPS の NMEA（USART1）・PPS（TIM3 CH2 の捕捉）・ボタン（EXTI）を台本か記録した時系列から
+   その時刻ちょうどに入れる。本体の処理は仮想時間を使わず、時間は idle_wait の WFI の間だけ進む。
+   同じ入力なら結果は毎回同じ（乱数は種から、本体の srand も仮想時間から）。
+
+     nixie_sim -d 7d                     1週間（既定の台本：ベルリン、夏時間の切替を跨ぐ）
+     nixie_sim -d 2h -b 30 -O 12 -x 5    ボタン 30回/時、GPS の途絶 12回/日、チェックサム誤り 5‰
+     nixie_sim -d 1h -w run.tl           入れた時系列と結果の要約値を書き出す
+     nixie_sim -r run.tl                 書き出した時系列を入れ直す（要約値が違えば終了コード 1）
+
+   台本：電源投入は GPS の秒の途中、-C 秒の冷起動（測位なし・PPS なし）の後、毎秒 PPS と
+   RMC/GGA/GSA/GSV×3 を 9600bps で 50〜150ms 遅れて送る。各行は最後のバイトが届く時刻に
+   まとめて入れる（行末を IDLE とみなす）。途絶の間は PPS が無く、文は測位なし。
+   -f はボードの水晶の誤差（PPS の間隔が仮想時間でずれる）、-R は RTC が動いていた起動。
+
+   時系列の形式（1行1件、時刻は仮想時間 [tick]＝1/32MHz、'#' は注釈）：
+     @nixie_sim 1             @end <tick>            @rtc <UTC エポック秒>     @digest <16進>
+     <tick> sec <UTC エポック秒>    本当の秒の始まり（入力ではなく測定の基準）
+     <tick> pps                     PPS の立下り
+     <tick> rx <文>                 USART1 へ1行（CRLF は付けて入れる）
+     <tick> btn UTC|EX|LLA|DATE|SPD
+
+   報告：表示の遅れ（本当の秒の始まりから、右端の管にその秒の1の位が点くまで）の分布を
+   秒の始まりでの timekeep の状態ごとに、その秒の間に一度も点かなかった秒（取りこぼし）、
+   GPS 受信リングの使用量（本体ループ1周ごと）の分布、ラッチ・グリッチの数。
+   推定時刻・寄せている間・演出とカソード巡回の間の秒は遅れを測らない。要約値は全ラッチの
+   時刻と表示の FNV-1a。
+   終了コード: 0=正常 1=グリッチ・要約値の不一致 2=引数や時系列の誤り */
+#include "hal_fake.h"
+#include "gps.h"
+#include "nixie.h"
+#include "anim.h"
+#include "timekeep.h"
+#include "telem.h"
+#include "idle.h"
+#include "civil.h"
+#include "tube_sim.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TICK_HZ     ((uint64_t)HAL_FAKE_TIM_HZ)
+#define LINE_MAX    128
+#define BATCH_MAX   32
+#define RING_BINS   16
+
+/* ==== 入力の1件 ====================================================== */
+typedef enum { EV_SEC, EV_PPS, EV_RX, EV_BTN } ev_kind_t;
+
+typedef struct {
+    uint64_t t;
+    uint8_t  kind;
+    uint16_t pin;                      /* EV_BTN */
+    int64_t  utc;                      /* EV_SEC */
+    char     s[LINE_MAX];              /* EV_RX（CRLF なし） */
+} ev_t;
+
+static const struct { const char *name; uint16_t pin; } BTN[] = {
+    { "UTC", SW_UTC_Pin }, { "EX", SW_EX_Pin }, { "LLA", SW_LLA_Pin }, { "DATE", SW_DATE_Pin }, { "SPD", SW_SPD_Pin },
+};
+#define N_BTN (sizeof BTN / sizeof BTN[0])
+
+/* ==== 台本 =========================================================== */
+typedef struct {
+    uint64_t seed;
+    int64_t  t0;                       /* 最初の秒の UTC */
+    double   lat, lon;
+    double   ppm;                      /* 水晶の誤差（+ = 速い） */
+    uint32_t cold_s;                   /* 冷起動の秒数 */
+    double   outages_day;              /* 途絶の回数/日 */
+    double   btn_hour;                 /* ボタン/時 */
+    uint32_t ckerr_pm;                 /* 壊す文 [‰] */
+} scn_t;
+
+typedef struct {
+    const scn_t *c;
+    uint64_t rng;
+    uint64_t t_first;                  /* 最初の秒の始まり [tick] */
+    double   period;                   /* 1秒 [tick] */
+    uint64_t k;                        /* 次に作る秒 */
+    uint64_t out_from, out_to;         /* 次の途絶 [k] */
+    ev_t     batch[BATCH_MAX];
+    uint32_t n, i;
+} gen_t;
+
+static uint64_t rnd(uint64_t *s)      /* xorshift64* */
+{
+    *s ^= *s >> 12; *s ^= *s << 25; *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1DULL;
+}
+static double rnd01(uint64_t *s){ return (double)(rnd(s) >> 11) * (1.0 / 9007199254740992.0); }
+static uint32_t rnd_in(uint64_t *s, uint32_t lo, uint32_t hi){ return lo + (uint32_t)(rnd(s) % (hi - lo + 1U)); }
+
+static void gen_outage(gen_t *g, uint64_t from)
+{
+    if(g->c->outages_day <= 0.0){ g->out_from = g->out_to = UINT64_MAX; return; }
+    double gap = -log(1.0 - rnd01(&g->rng)) * 86400.0 / g->c->outages_day;
+    g->out_from = from + (uint64_t)gap;
+    g->out_to   = g->out_from + rnd_in(&g->rng, 10U, 1200U);
+}
+
+static void gen_init(gen_t *g, const scn_t *c)
+{
+    memset(g, 0, sizeof *g);
+    g->c = c;
+    g->rng = c->seed * 0x9E3779B97F4A7C15ULL + 1U;
+    g->period = (double)TICK_HZ * (1.0 + c->ppm * 1e-6);
+    g->t_first = TICK_HZ / 4U + rnd(&g->rng) % (TICK_HZ / 2U);   /* 電源投入は秒の途中 */
+    gen_outage(g, c->cold_s);
+}
+
+static ev_t *gen_push(gen_t *g, uint64_t t, uint8_t kind)
+{
+    ev_t *e = &g->batch[g->n++];
+    e->t = t; e->kind = kind; e->pin = 0; e->utc = 0; e->s[0] = '\0';
+    return e;
+}
+
+/* "$...*hh" に仕上げる */
+static void nmea_fin(char *s)
+{
+    uint8_t ck = 0;
+    size_t n = strlen(s);
+    for(size_t i=1;i<n;i++) ck ^= (uint8_t)s[i];
+    snprintf(s + n, LINE_MAX - n, "*%02X", ck);
+}
+
+static void fmt_dm(char *o, size_t n, double v, int deg_w, char pos, char neg)
+{
+    double a = fabs(v);
+    int d = (int)a;
+    snprintf(o, n, "%0*d%07.4f,%c", deg_w, d, (a - d) * 60.0, v < 0.0 ? neg : pos);
+}
+
+/* 秒 k の入力（秒の始まり・PPS・文・ボタン）を時刻順に */
+static void gen_second(gen_t *g)
+{
+    const scn_t *c = g->c;
+    uint64_t k = g->k++;
+    uint64_t t = g->t_first + (uint64_t)llround((double)k * g->period);
+    int64_t  utc = c->t0 + (int64_t)k;
+    g->n = g->i = 0;
+
+    if(k >= g->out_to) gen_outage(g, k);
+    uint8_t fix = (k >= c->cold_s) && !(k >= g->out_from && k < g->out_to);
+
+    gen_push(g, t, EV_SEC)->utc = utc;
+    if(fix) gen_push(g, t, EV_PPS);
+
+    civil_t cv;
+    utc_to_local(utc, 0, &cv);
+    char hms[16], date[16], la[24], lo[24];
+    snprintf(hms, sizeof hms, "%02d%02d%02d.00", cv.hh, cv.mm, cv.ss);
+    snprintf(date, sizeof date, "%02d%02d%02d", cv.DD, cv.MM, cv.YYYY % 100);
+    double jit = ((double)(rnd(&g->rng) % 2001U) - 1000.0) * 1e-7;   /* ±0.0001度（≒10m） */
+    fmt_dm(la, sizeof la, c->lat + jit, 2, 'N', 'S');
+    fmt_dm(lo, sizeof lo, c->lon - jit, 3, 'E', 'W');
+
+    char lines[6][LINE_MAX];
+    int nl = 0;
+    if(fix){
+        snprintf(lines[nl++], LINE_MAX, "$GPRMC,%s,A,%s,%s,0.02,,%s,,,A", hms, la, lo, date);
+        snprintf(lines[nl++], LINE_MAX, "$GPGGA,%s,%s,%s,1,09,0.92,41.3,M,45.0,M,,", hms, la, lo);
+        snprintf(lines[nl++], LINE_MAX, "$GPGSA,A,3,02,05,07,09,13,15,20,29,30,,,,1.61,0.92,1.32");
+        static const char *const GSV[3] = {
+            "$GPGSV,3,1,12,02,48,063,41,05,27,196,38,07,12,317,33,09,35,108,40",
+            "$GPGSV,3,2,12,13,76,245,45,15,22,041,36,20,61,297,44,29,08,150,29",
+            "$GPGSV,3,3,12,30,53,212,43,11,03,011,,18,05,276,,25,01,122,",
+        };
+        for(int i=0;i<3;i++) snprintf(lines[nl++], LINE_MAX, "%s", GSV[i]);
+    }else{
+        snprintf(lines[nl++], LINE_MAX, "$GPRMC,,V,,,,,,,,,,N");
+        snprintf(lines[nl++], LINE_MAX, "$GPGGA,,,,,,0,00,99.99,,,,,,");
+    }
+
+    /* 9600bps の 8N1 で秒の始まりから 50〜150ms 後に続けて送る */
+    uint32_t baud = huart1.Init.BaudRate ? huart1.Init.BaudRate : 9600U;
+    uint64_t tx = t + TICK_HZ / 1000U * rnd_in(&g->rng, 50U, 150U);
+    for(int i=0;i<nl;i++){
+        nmea_fin(lines[i]);
+        if(c->ckerr_pm && rnd(&g->rng) % 1000U < c->ckerr_pm){
+            size_t n = strlen(lines[i]), p = 1U + rnd(&g->rng) % (n - 4U);   /* '*hh' は残す */
+            lines[i][p] = (lines[i][p] == '0') ? '1' : '0';
+        }
+        tx += (uint64_t)(strlen(lines[i]) + 2U) * 10U * TICK_HZ / baud;
+        snprintf(gen_push(g, tx, EV_RX)->s, LINE_MAX, "%s", lines[i]);
+    }
+
+    /* ボタン：押した瞬間に 1〜3 回のはね（0.2〜2ms おき） */
+    if(c->btn_hour > 0.0 && rnd01(&g->rng) < c->btn_hour / 3600.0){
+        uint16_t pin = BTN[rnd(&g->rng) % N_BTN].pin;
+        uint64_t tb = t + (uint64_t)(rnd01(&g->rng) * 0.9 * g->period);
+        uint32_t edges = rnd_in(&g->rng, 1U, 3U);
+        for(uint32_t e=0;e<edges && g->n<BATCH_MAX;e++){
+            gen_push(g, tb, EV_BTN)->pin = pin;
+            tb += TICK_HZ / 1000000U * rnd_in(&g->rng, 200U, 2000U);
+        }
+    }
+
+    /* 挿入整列（同じ時刻は入れた順：秒の始まり → PPS） */
+    for(uint32_t i=1;i<g->n;i++){
+        ev_t e = g->batch[i];
+        uint32_t j = i;
+        while(j > 0U && g->batch[j-1U].t > e.t){ g->batch[j] = g->batch[j-1U]; j--; }
+        g->batch[j] = e;
+    }
+}
+
+static int gen_next(gen_t *g, ev_t *e)
+{
+    if(g->i >= g->n) gen_second(g);
+    *e = g->batch[g->i++];
+    return 1;
+}
+
+/* ==== 記録した時系列 ================================================= */
+typedef struct {
+    FILE    *f;
+    const char *path;
+    uint32_t line;
+    uint64_t end;
+    int64_t  rtc;                      /* INT64_MIN=RTC なし */
+    uint64_t digest;
+    uint8_t  have_digest, eof;
+} tl_t;
+
+static const char *btn_name(uint16_t pin)
+{
+    for(size_t i=0;i<N_BTN;i++) if(BTN[i].pin == pin) return BTN[i].name;
+    return "?";
+}
+
+static void tl_fail(const tl_t *r, const char *what)
+{
+    fprintf(stderr, "%s:%u: %s\n", r->path, (unsigned)r->line, what);
+    exit(2);
+}
+
+/* 次の入力。'@' の指示は読んで覚える。返値: 0=終わり */
+static int tl_next(tl_t *r, ev_t *e)
+{
+    char buf[LINE_MAX + 64];
+    while(!r->eof){
+        if(!fgets(buf, sizeof buf, r->f)){ r->eof = 1; break; }
+        r->line++;
+        buf[strcspn(buf, "\r\n")] = '\0';
+        if(buf[0] == '\0' || buf[0] == '#') continue;
+        if(buf[0] == '@'){
+            char key[16];
+            unsigned long long v;
+            long long sv;
+            if(sscanf(buf, "@%15s", key) != 1) tl_fail(r, "bad directive");
+            if(!strcmp(key, "end") && sscanf(buf, "@end %llu", &v) == 1) r->end = v;
+            else if(!strcmp(key, "rtc") && sscanf(buf, "@rtc %lld", &sv) == 1) r->rtc = sv;
+            else if(!strcmp(key, "digest") && sscanf(buf, "@digest %llx", &v) == 1){ r->digest = v; r->have_digest = 1; }
+            else if(strcmp(key, "nixie_sim") != 0) tl_fail(r, "unknown directive");
+            continue;
+        }
+        unsigned long long t;
+        char kind[8];
+        int off = 0;
+        if(sscanf(buf, "%llu %7s %n", &t, kind, &off) < 2) tl_fail(r, "bad event");
+        const char *arg = buf + off;
+        memset(e, 0, sizeof *e);
+        e->t = t;
+        if(!strcmp(kind, "sec")){
+            long long u;
+            if(sscanf(arg, "%lld", &u) != 1) tl_fail(r, "sec needs UTC seconds");
+            e->kind = EV_SEC; e->utc = u;
+        }else if(!strcmp(kind, "pps")){
+            e->kind = EV_PPS;
+        }else if(!strcmp(kind, "rx")){
+            if(strlen(arg) >= LINE_MAX - 2U) tl_fail(r, "rx line too long");
+            e->kind = EV_RX;
+            snprintf(e->s, LINE_MAX, "%s", arg);
+        }else if(!strcmp(kind, "btn")){
+            size_t i = 0;
+            while(i < N_BTN && strcmp(arg, BTN[i].name) != 0) i++;
+            if(i == N_BTN) tl_fail(r, "unknown button");
+            e->kind = EV_BTN; e->pin = BTN[i].pin;
+        }else{
+            tl_fail(r, "unknown event");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void tl_write(FILE *f, const ev_t *e)
+{
+    switch(e->kind){
+    case EV_SEC: fprintf(f, "%" PRIu64 " sec %" PRId64 "\n", e->t, e->utc); break;
+    case EV_PPS: fprintf(f, "%" PRIu64 " pps\n", e->t); break;
+    case EV_RX:  fprintf(f, "%" PRIu64 " rx %s\n", e->t, e->s); break;
+    case EV_BTN: fprintf(f, "%" PRIu64 " btn %s\n", e->t, btn_name(e->pin)); break;
+    }
+}
+
+/* ==== 測定 =========================================================== */
+#define N_TK 5
+static const char *const TK_NAME[N_TK] = { "UNSYNC", "NMEA", "PPS", "HOLDOVER", "ESTIMATE" };
+
+typedef struct {
+    int32_t *v;                        /* 遅れ [tick]（負 = 秒の始まりより前に点いた） */
+    uint32_t n, cap;
+    uint64_t missed;
+} lat_t;
+
+typedef struct {
+    gen_t    gen;
+    tl_t     tl;
+    uint8_t  replay;
+    FILE    *rec;
+
+    ev_t     ev;
+    uint8_t  have;
+    uint64_t end;
+
+    tube_sim_t tube;
+    uint32_t last_stcp;
+    int8_t   cur_d;                    /* 右端の管の今の数字（-1=不明） */
+    uint64_t t_cur;                    /* それに変わった時刻 */
+    uint64_t digest;
+
+    /* 秒ごとの測定 */
+    uint8_t  pending;                  /* 今の秒の数字をまだ見ていない */
+    int8_t   want, want_st;
+    uint64_t t_sec;
+    uint64_t secs, masked, secs_st[N_TK];
+    lat_t    lat[N_TK];
+    uint64_t first_sync;               /* 初めて遅れを測れた秒 [tick]（0=まだ） */
+
+    /* 入力の数 */
+    uint64_t n_pps, n_rx, n_btn;
+
+    /* 本体ループ */
+    uint64_t loops;
+    uint64_t ring_hist[RING_BINS], ring_sum;
+    uint16_t ring_max;
+} sim_t;
+
+static void fnv(uint64_t *h, const void *p, size_t n)
+{
+    const uint8_t *b = (const uint8_t*)p;
+    for(size_t i=0;i<n;i++){ *h ^= b[i]; *h *= 0x100000001B3ULL; }
+}
+
+static int8_t ones_digit(uint16_t code)
+{
+    uint16_t d = (uint16_t)(code & 0x09FFU);
+    if(d == 0U || (d & (d - 1U))) return -1;
+    if(d & 0x0800U) return 0;
+    int8_t i = 1;
+    while(!(d & 1U)){ d >>= 1; i++; }
+    return i;
+}
+
+static void lat_add(lat_t *l, int64_t v)
+{
+    if(l->n == l->cap){
+        l->cap = l->cap ? l->cap * 2U : 4096U;
+        l->v = (int32_t*)realloc(l->v, l->cap * sizeof *l->v);
+        if(!l->v){ perror("realloc"); exit(2); }
+    }
+    l->v[l->n++] = (int32_t)v;
+}
+
+static void on_gpio(void *ctx, uint8_t port, uint16_t before, uint16_t after)
+{
+    sim_t *s = (sim_t*)ctx;
+    tube_sim_gpio(&s->tube, port, before, after);
+    if(s->tube.n_stcp == s->last_stcp) return;
+    s->last_stcp = s->tube.n_stcp;
+
+    uint64_t now = hal_fake_now_ticks();
+    uint16_t code[8];
+    tube_sim_shown(&s->tube, code);
+    fnv(&s->digest, &now, sizeof now);
+    fnv(&s->digest, code, sizeof code);
+
+    int8_t d = ones_digit(code[7]);
+    if(d < 0 || d == s->cur_d) return;      /* PWM で消えている間は数えない */
+    s->cur_d = d; s->t_cur = now;
+    if(s->pending && d == s->want){
+        lat_add(&s->lat[s->want_st], (int64_t)(now - s->t_sec));
+        s->pending = 0;
+    }
+}
+
+/* 本当の秒の始まり：前の秒を締め、この秒の数字を待つ */
+static void on_second(sim_t *s, const ev_t *e)
+{
+    uint8_t busy = anim_busy() || nixie_acp_active();
+    if(s->pending){
+        if(busy) s->masked++;
+        else     s->lat[s->want_st].missed++;
+        s->pending = 0;
+    }
+
+    tk_state_t st = tk_state();
+    s->secs++;
+    if((unsigned)st < N_TK) s->secs_st[st]++;
+    if(st == TK_UNSYNC || st == TK_ESTIMATE || (unsigned)st >= N_TK || tk_unsynced()) return;
+    if(busy){ s->masked++; return; }
+
+    if(!s->first_sync) s->first_sync = e->t;
+    s->want = (int8_t)(((e->utc % 10) + 10) % 10);
+    s->want_st = (int8_t)st;
+    s->t_sec = e->t;
+    if(s->cur_d == s->want && e->t - s->t_cur < TICK_HZ){   /* 秒の始まりより前に切替わっていた */
+        lat_add(&s->lat[st], -(int64_t)(e->t - s->t_cur));
+        return;
+    }
+    s->pending = 1;
+}
+
+static void deliver(sim_t *s, const ev_t *e)
+{
+    if(s->rec) tl_write(s->rec, e);
+    switch(e->kind){
+    case EV_SEC:
+        on_second(s, e);
+        break;
+    case EV_PPS:
+        s->n_pps++;
+        hal_fake_tim_capture(TIM3, 2U);
+        break;
+    case EV_RX: {
+        uint8_t b[LINE_MAX + 2];
+        size_t n = strlen(e->s);
+        memcpy(b, e->s, n);
+        b[n++] = '\r'; b[n++] = '\n';
+        s->n_rx++;
+        hal_fake_uart_inject(&huart1, b, (uint32_t)n);
+        break;
+    }
+    case EV_BTN:
+        s->n_btn++;
+        hal_fake_exti(e->pin);
+        break;
+    }
+}
+
+static int src_next(sim_t *s, ev_t *e)
+{
+    return s->replay ? tl_next(&s->tl, e) : gen_next(&s->gen, e);
+}
+
+static uint64_t on_input(void *ctx, uint64_t now)
+{
+    sim_t *s = (sim_t*)ctx;
+    while(s->have && s->ev.t <= now){
+        deliver(s, &s->ev);
+        s->have = (uint8_t)(src_next(s, &s->ev) && s->ev.t < s->end);
+    }
+    return s->have ? s->ev.t : UINT64_MAX;
+}
+
+/* ==== 実行 =========================================================== */
+static void run(sim_t *s, int64_t rtc)
+{
+    hal_fake_reset();
+    hal_fake_flash_wipe();                 /* 設定なしの新品 */
+    if(rtc != INT64_MIN) hal_fake_rtc_write(rtc);
+    else                 hal_fake_rtc_lose();
+
+    tube_sim_attach(&s->tube, NULL, 0U);
+    hal_fake_set_gpio_hook(on_gpio, s);
+    /* stm32f3xx_it.c と同じ割込み（USART1 の受信は hal_fake_uart_inject が直接配る） */
+    hal_fake_set_isr(TIM3_IRQn, tk_capture_irq);
+    hal_fake_set_isr(TIM6_DAC1_IRQn, nixie_pwm_irq);
+#if NIXIE_USE_DMA
+    hal_fake_set_isr(DMA1_Channel3_IRQn, nixie_dma_irq);
+#endif
+#if TELEM_ENABLE
+    hal_fake_set_isr(DMA1_Channel7_IRQn, telem_dma_irq);
+#endif
+    s->cur_d = -1;
+    s->digest = 0xCBF29CE484222325ULL;
+
+    user_setup();
+    s->have = (uint8_t)(src_next(s, &s->ev) && s->ev.t < s->end);
+    hal_fake_set_input(on_input, s);
+
+    while(hal_fake_now_ticks() < s->end){
+        uint16_t r = gps_rx_pending();
+        s->ring_hist[(uint32_t)r * RING_BINS / GPS_RX_BUF_SZ]++;
+        s->ring_sum += r;
+        if(r > s->ring_max) s->ring_max = r;
+        user_loop();
+#if !IDLE_ENABLE
+        hal_fake_wfi();                    /* 眠らない本体は回り続ける。次の割込みか 1ms まで飛ばす */
+#endif
+        s->loops++;
+        (void)hal_fake_uart_sent(&huart2, NULL, UINT32_MAX);   /* テレメトリは捨てる */
+    }
+    hal_fake_set_input(NULL, NULL);
+}
+
+/* ==== 報告 =========================================================== */
+static int cmp_i32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double us(int64_t ticks){ return (double)ticks * 1e6 / (double)TICK_HZ; }
+
+static void report(const sim_t *s, double wall)
+{
+    double sim_s = (double)hal_fake_now_ticks() / (double)TICK_HZ;
+    printf("simulated %.0f s in %.2f s (x%.0f), %" PRIu64 " loops",
+           sim_s, wall, wall > 0.0 ? sim_s / wall : 0.0, s->loops);
+#if IDLE_ENABLE
+    printf(", %u wakeups", (unsigned)idle_wakeups);
+#endif
+    printf("\n");
+    printf("inputs: pps=%" PRIu64 " rx=%" PRIu64 " btn=%" PRIu64 "  first synced second at %.3f s\n",
+           s->n_pps, s->n_rx, s->n_btn, s->first_sync ? us((int64_t)s->first_sync) / 1e6 : -1.0);
+
+    printf("seconds: %" PRIu64 " (", s->secs);
+    for(int i=0;i<N_TK;i++) printf("%s%s=%" PRIu64, i ? " " : "", TK_NAME[i], s->secs_st[i]);
+    printf(") masked=%" PRIu64 "\n", s->masked);
+
+    printf("display latency [us] (second start -> ones digit lit):\n");
+    printf("  %-9s %9s %7s %7s %10s %10s %10s %10s %10s\n", "state", "shown", "missed", "early", "min", "p50", "p90", "p99", "max");
+    uint64_t missed = 0;
+    for(int i=0;i<N_TK;i++){
+        const lat_t *l = &s->lat[i];
+        missed += l->missed;
+        if(!l->n && !l->missed) continue;
+        int32_t *v = (int32_t*)malloc((l->n ? l->n : 1U) * sizeof *v);
+        if(l->n) memcpy(v, l->v, l->n * sizeof *v);
+        qsort(v, l->n, sizeof *v, cmp_i32);
+        uint32_t early = 0;
+        while(early < l->n && v[early] < 0) early++;
+#define PCT(p) (l->n ? us(v[(uint64_t)(l->n - 1U) * (p) / 100U]) : 0.0)
+        printf("  %-9s %9u %7" PRIu64 " %7u %10.1f %10.1f %10.1f %10.1f %10.1f\n", TK_NAME[i], l->n, l->missed, early,
+               PCT(0), PCT(50), PCT(90), PCT(99), PCT(100));
+#undef PCT
+        free(v);
+    }
+
+    printf("gps ring [byte of %u] per loop: mean %.1f max %u (hwm %u) overflows=%u dropped=%u\n",
+           (unsigned)GPS_RX_BUF_SZ, s->loops ? (double)s->ring_sum / (double)s->loops : 0.0,
+           (unsigned)s->ring_max, (unsigned)gps_rx_hwm, (unsigned)gps_rx_overflows, (unsigned)gps_rx_dropped);
+    printf("  ");
+    for(int i=0;i<RING_BINS;i++){
+        if(!s->ring_hist[i]) continue;
+        printf(" <%u:%.4f%%", (unsigned)((i + 1) * GPS_RX_BUF_SZ / RING_BINS),
+               100.0 * (double)s->ring_hist[i] / (double)(s->loops ? s->loops : 1U));
+    }
+    printf("\n");
+    printf("gps: lines=%u ckerr=%u  uart dropped=%u\n",
+           (unsigned)gps_default.st.rx_lines, (unsigned)gps_default.st.rx_ckerr, (unsigned)hal_fake_uart_dropped);
+    printf("display: latches=%u glitches=%u missed=%" PRIu64 "\n",
+           (unsigned)s->tube.n_stcp, (unsigned)s->tube.n_glitch, missed);
+    printf("digest %016" PRIx64 "\n", s->digest);
+}
+
+/* ==== 引数 =========================================================== */
+static uint64_t parse_dur(const char *a)
+{
+    char *e;
+    double v = strtod(a, &e);
+    double m = (*e == 'd') ? 86400.0 : (*e == 'h') ? 3600.0 : (*e == 'm') ? 60.0 : 1.0;
+    if(v <= 0.0 || (*e && strchr("dhms", *e) == NULL)) return 0;
+    return (uint64_t)(v * m * (double)TICK_HZ);
+}
+
+static int parse_utc(const char *a, int64_t *out)
+{
+    int y, mo, d, h = 0, mi = 0, se = 0;
+    if(sscanf(a, "%d-%d-%dT%d:%d:%d", &y, &mo, &d, &h, &mi, &se) < 3) return 0;
+    *out = civil_epoch(y, mo, d, h, mi, se);
+    return 1;
+}
+
+static void usage(void)
+{
+    fputs("usage: nixie_sim [-d dur(s/m/h/d)] [-s seed] [-t YYYY-MM-DDTHH:MM:SS] [-L lat,lon]\n"
+          "                 [-f ppm] [-C cold_s] [-O outages/day] [-b presses/hour] [-x ckerr_permille]\n"
+          "                 [-R rtc_offset_s] [-w timeline]\n"
+          "       nixie_sim -r timeline\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static sim_t s;
+    scn_t c = { 1U, 0, 52.5200, 13.4050, 0.0, 30U, 0.0, 0.0, 0U };
+    (void)parse_utc("2026-03-28T12:00:00", &c.t0);   /* 翌日 01:00 UTC に CET→CEST */
+    uint64_t dur = 600U * TICK_HZ;
+    int64_t rtc = INT64_MIN;
+    const char *rec = NULL, *play = NULL;
+    int o;
+    while((o = getopt(argc, argv, "d:s:t:L:f:C:O:b:x:R:w:r:h")) != -1){
+        switch(o){
+        case 'd': if(!(dur = parse_dur(optarg))) usage(); break;
+        case 's': c.seed = strtoull(optarg, NULL, 0); break;
+        case 't': if(!parse_utc(optarg, &c.t0)) usage(); break;
+        case 'L': if(sscanf(optarg, "%lf,%lf", &c.lat, &c.lon) != 2) usage(); break;
+        case 'f': c.ppm = atof(optarg); break;
+        case 'C': c.cold_s = (uint32_t)atoi(optarg); break;
+        case 'O': c.outages_day = atof(optarg); break;
+        case 'b': c.btn_hour = atof(optarg); break;
+        case 'x': c.ckerr_pm = (uint32_t)atoi(optarg); break;
+        case 'R': rtc = c.t0 + atoll(optarg); break;
+        case 'w': rec = optarg; break;
+        case 'r': play = optarg; break;
+        default:  usage();
+        }
+    }
+    if(optind != argc) usage();
+
+    if(play){
+        s.replay = 1;
+        s.tl.path = play;
+        s.tl.rtc = INT64_MIN;
+        if(!(s.tl.f = fopen(play, "r"))){ perror(play); return 2; }
+        ev_t e;
+        (void)tl_next(&s.tl, &e);          /* 頭の指示（@end・@rtc）を先に読む */
+        if(!s.tl.end){ fprintf(stderr, "%s: no @end\n", play); return 2; }
+        rewind(s.tl.f); s.tl.line = 0; s.tl.eof = 0; s.tl.have_digest = 0;
+        dur = s.tl.end; rtc = s.tl.rtc;
+    }else{
+        gen_init(&s.gen, &c);
+    }
+    s.end = dur;
+
+    if(rec){
+        if(!(s.rec = fopen(rec, "w"))){ perror(rec); return 2; }
+        fprintf(s.rec, "@nixie_sim 1\n@end %" PRIu64 "\n", s.end);
+        if(rtc != INT64_MIN) fprintf(s.rec, "@rtc %" PRId64 "\n", rtc);
+    }
+
+    struct timespec w0, w1;
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+    run(&s, rtc);
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    report(&s, (double)(w1.tv_sec - w0.tv_sec) + (double)(w1.tv_nsec - w0.tv_nsec) * 1e-9);
+
+    int rc = s.tube.n_glitch ? 1 : 0;
+    if(s.rec){
+        fprintf(s.rec, "@digest %016" PRIx64 "\n", s.digest);
+        fclose(s.rec);
+    }
+    if(s.replay){
+        ev_t e;
+        while(tl_next(&s.tl, &e)) ;
+        fclose(s.tl.f);
+        if(s.tl.have_digest && s.tl.digest != s.digest){
+            printf("replay: digest differs from the recording (%016" PRIx64 ")\n", s.tl.digest);
+            rc = 1;
+        }else if(s.tl.have_digest){
+            printf("replay: digest matches the recording\n");
+        }
+    }
+    return rc;
+}
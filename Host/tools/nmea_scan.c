@@ -0,0 +1,363 @@
+/* 記録した NMEA ログを本体と同じ解析器（gps.c）と時差計算（tz.c）で読み直す（Linux）。
+   ファイルは mmap し、文の境目（行頭）で CHUNK ずつに切って作業スレッドへ配る。
+   チャンクごとに gps_parser_t を1つ作り、1行ずつ gps_parser_feed() して公開のたびに集計する。
+   結果は最後にファイルの順へつなぐので、スレッド数を変えても出力は同じ。
+
+     nmea_scan log1.nmea log2.nmea ...
+     nmea_scan -j 8 -s 64M -G 2 -E 20 *.nmea
+     nmea_scan -q ...            ファイルごとに1行の要約だけ
+
+   ファイルごとに、文種別の受理/不正、チェックサム不一致の率、測位（RMC）の件数と
+   位置・日付・2D/3D・HDOP・使用衛星数、UTC の範囲と時差、時刻の飛び（-G 秒を超える欠けと逆行）
+   を出す。飛びは先頭から -E 件までファイル内の位置つきで並べる。
+   チャンクの先頭では解析器が新しいので、境目を跨ぐ GSA の合算・GSV の系ごとの数・日付は
+   次の該当文まで欠ける。時刻の連続性はチャンクの境目でもつないで見る。
+   解析はチャンク単位で独立なので、速度はほぼコア数に比例する（cmake -DCMAKE_BUILD_TYPE=Release で）。
+   終了コード: 0=正常 1=読めないファイルがあった 2=引数の誤り */
+#include "gps.h"
+#include "civil.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define T_NONE INT64_MIN
+
+typedef struct {
+    uint64_t off;                      /* その文のファイル内の位置 */
+    int64_t  t0, t1;                   /* 前の時刻 → この時刻（UTC エポック秒） */
+} event_t;
+
+typedef struct {
+    uint64_t bytes, lines, ckerr, resync;
+    uint64_t ok[GPS_ST_N], bad[GPS_ST_N];
+    uint64_t fixes, pos, dated, fix2d, fix3d;   /* RMC の公開ごと */
+    uint64_t hdop_sum, hdop_n, sat_sum, sat_n;
+    int64_t  t_first, t_last;          /* 日付つきの UTC（T_NONE=無し） */
+    uint64_t off_first;
+    int16_t  tz_first, tz_last;
+    uint64_t tz_changes, gaps, backs;
+    event_t *ev;                       /* 先頭から s_ev_max 件 */
+    uint32_t n_ev;
+} tally_t;
+
+typedef struct {
+    const char    *path;
+    const uint8_t *map;
+    uint64_t       size;
+    int            ok;
+} file_t;
+
+typedef struct {
+    uint32_t file;
+    uint64_t lo, hi;                   /* [lo, hi)、lo は行頭 */
+    tally_t  t;
+} chunk_t;
+
+static uint32_t s_gap_s  = 1;          /* これを超える UTC の進みを欠けとする */
+static uint32_t s_ev_max = 10;
+static file_t  *s_files;
+static chunk_t *s_chunks;
+static size_t   s_nchunks;
+static atomic_size_t s_next;
+
+static const char *const ST_NAME[GPS_ST_N] = { "RMC", "GGA", "ZDA", "VTG", "GSA", "GSV", "GLL" };
+
+/* ==== 集計 =========================================================== */
+static void tally_init(tally_t *t)
+{
+    memset(t, 0, sizeof *t);
+    t->t_first = t->t_last = T_NONE;
+    t->ev = (event_t*)calloc(s_ev_max ? s_ev_max : 1U, sizeof *t->ev);
+    if(!t->ev){ perror("calloc"); exit(1); }
+}
+
+/* 前の時刻 t0 から t1 への進みを見る（同じ秒の繰返しは 1Hz 超の出力なので正常） */
+static void step(tally_t *t, uint64_t off, int64_t t0, int64_t t1)
+{
+    int64_t dt = t1 - t0;
+    if(dt < 0)                    t->backs++;
+    else if(dt > (int64_t)s_gap_s) t->gaps++;
+    else return;
+    if(t->n_ev < s_ev_max) t->ev[t->n_ev++] = (event_t){ off, t0, t1 };
+}
+
+typedef struct {
+    tally_t *t;
+    uint64_t off;                      /* 今 feed している行の位置 */
+} scan_t;
+
+static void on_fix(const gps_fix_t *fx, void *ctx)
+{
+    scan_t  *s = (scan_t*)ctx;
+    tally_t *t = s->t;
+
+    if(fx->upd & GPS_UPD_RMC){
+        t->fixes++;
+        if(fx->lat.umin != GPS_FX_INVALID && fx->lon.umin != GPS_FX_INVALID) t->pos++;
+        if(fx->utc_YYYY >= 0) t->dated++;
+        if(fx->fix_type == 3) t->fix3d++;
+        else if(fx->fix_type == 2) t->fix2d++;
+        if(fx->hdop_c >= 0){ t->hdop_sum += (uint64_t)fx->hdop_c; t->hdop_n++; }
+        if(fx->sat_used >= 0){ t->sat_sum += (uint64_t)fx->sat_used; t->sat_n++; }
+    }
+
+    if(!(fx->upd & (GPS_UPD_RMC | GPS_UPD_ZDA | GPS_UPD_GLL))) return;
+    if(fx->utc_YYYY < 0 || fx->utc_hh < 0) return;
+    int64_t now = civil_epoch(fx->utc_YYYY, fx->utc_MM, fx->utc_DD, fx->utc_hh, fx->utc_mm, fx->utc_ss);
+    if(t->t_first == T_NONE){
+        t->t_first = now; t->off_first = s->off; t->tz_first = fx->tz_min;
+    }else{
+        step(t, s->off, t->t_last, now);
+        if(fx->tz_min != t->tz_last) t->tz_changes++;
+    }
+    t->t_last = now; t->tz_last = fx->tz_min;
+}
+
+static void scan_chunk(chunk_t *k)
+{
+    const file_t *f = &s_files[k->file];
+    gps_parser_t p;
+    scan_t s = { &k->t, 0 };
+    gps_parser_init(&p);
+    gps_parser_on_fix(&p, on_fix, &s);
+
+    const uint8_t *b = f->map + k->lo, *end = f->map + k->hi;
+    while(b < end){
+        const uint8_t *nl = (const uint8_t*)memchr(b, '\n', (size_t)(end - b));
+        const uint8_t *e  = nl ? nl + 1 : end;
+        s.off = (uint64_t)(b - f->map);
+        (void)gps_parser_feed(&p, b, (uint32_t)(e - b));
+        b = e;
+    }
+
+    tally_t *t = &k->t;
+    t->bytes  = p.st.rx_bytes;
+    t->lines  = p.st.rx_lines;
+    t->ckerr  = p.st.rx_ckerr;
+    t->resync = p.st.rx_resync;
+    for(int i=0;i<GPS_ST_N;i++){ t->ok[i] = p.st.ok[i]; t->bad[i] = p.st.bad[i]; }
+}
+
+static void *worker(void *arg)
+{
+    (void)arg;
+    for(;;){
+        size_t i = atomic_fetch_add(&s_next, 1U);
+        if(i >= s_nchunks) break;
+        scan_chunk(&s_chunks[i]);
+    }
+    return NULL;
+}
+
+/* チャンク k を（ファイル順に）ファイルの集計 a へつなぐ */
+static void merge(tally_t *a, const tally_t *k)
+{
+    a->bytes += k->bytes; a->lines += k->lines; a->ckerr += k->ckerr; a->resync += k->resync;
+    for(int i=0;i<GPS_ST_N;i++){ a->ok[i] += k->ok[i]; a->bad[i] += k->bad[i]; }
+    a->fixes += k->fixes; a->pos += k->pos; a->dated += k->dated;
+    a->fix2d += k->fix2d; a->fix3d += k->fix3d;
+    a->hdop_sum += k->hdop_sum; a->hdop_n += k->hdop_n;
+    a->sat_sum  += k->sat_sum;  a->sat_n  += k->sat_n;
+    a->tz_changes += k->tz_changes;
+    a->gaps += k->gaps; a->backs += k->backs;
+
+    if(k->t_first == T_NONE) return;
+    if(a->t_first == T_NONE){
+        a->t_first = k->t_first; a->off_first = k->off_first; a->tz_first = k->tz_first;
+    }else{
+        step(a, k->off_first, a->t_last, k->t_first);      /* 境目を跨ぐ進み */
+        if(k->tz_first != a->tz_last) a->tz_changes++;
+    }
+    for(uint32_t i=0;i<k->n_ev && a->n_ev < s_ev_max;i++) a->ev[a->n_ev++] = k->ev[i];
+    a->t_last = k->t_last; a->tz_last = k->tz_last;
+}
+
+/* ==== 表示 =========================================================== */
+static const char *fmt_utc(int64_t t, char *buf, size_t n)
+{
+    civil_t c;
+    utc_to_local(t, 0, &c);
+    snprintf(buf, n, "%04d-%02d-%02d %02d:%02d:%02d", c.YYYY, c.MM, c.DD, c.hh, c.mm, c.ss);
+    return buf;
+}
+
+static const char *fmt_tz(int16_t m, char *buf, size_t n)
+{
+    int a = (m < 0) ? -m : m;
+    snprintf(buf, n, "%c%02d:%02d", (m < 0) ? '-' : '+', a / 60, a % 60);
+    return buf;
+}
+
+static double pct(uint64_t a, uint64_t b){ return b ? 100.0 * (double)a / (double)b : 0.0; }
+
+static void print_file(const file_t *f, const tally_t *t, int quick)
+{
+    char b0[32], b1[32];
+    if(quick){
+        printf("%s bytes=%llu lines=%llu ckerr=%.3f%% fixes=%llu gaps=%llu back=%llu\n", f->path,
+               (unsigned long long)t->bytes, (unsigned long long)t->lines, pct(t->ckerr, t->lines),
+               (unsigned long long)t->fixes, (unsigned long long)t->gaps, (unsigned long long)t->backs);
+        return;
+    }
+    printf("== %s  %llu bytes  %llu lines\n", f->path, (unsigned long long)t->bytes, (unsigned long long)t->lines);
+    printf("   checksum/format errors %llu (%.3f%%)  resync %llu\n",
+           (unsigned long long)t->ckerr, pct(t->ckerr, t->lines), (unsigned long long)t->resync);
+    printf("  ");
+    for(int i=0;i<GPS_ST_N;i++){
+        if(t->ok[i] || t->bad[i]) printf(" %s %llu/%llu", ST_NAME[i], (unsigned long long)t->ok[i], (unsigned long long)t->bad[i]);
+    }
+    printf("  (ok/bad)\n");
+    printf("   fixes %llu  position %llu  dated %llu  3D %llu  2D %llu",
+           (unsigned long long)t->fixes, (unsigned long long)t->pos, (unsigned long long)t->dated,
+           (unsigned long long)t->fix3d, (unsigned long long)t->fix2d);
+    if(t->hdop_n) printf("  HDOP avg %.2f", (double)t->hdop_sum / (double)t->hdop_n / 100.0);
+    if(t->sat_n)  printf("  sats avg %.1f", (double)t->sat_sum / (double)t->sat_n);
+    printf("\n");
+    if(t->t_first == T_NONE){
+        printf("   no dated time\n");
+        return;
+    }
+    printf("   UTC %s .. ", fmt_utc(t->t_first, b0, sizeof b0));
+    printf("%s (%lld s)  local %s", fmt_utc(t->t_last, b1, sizeof b1),
+           (long long)(t->t_last - t->t_first), fmt_tz(t->tz_first, b0, sizeof b0));
+    if(t->tz_changes) printf(" .. %s (%llu changes)", fmt_tz(t->tz_last, b1, sizeof b1), (unsigned long long)t->tz_changes);
+    printf("\n");
+    printf("   time gaps %llu (> %u s)  backward %llu\n",
+           (unsigned long long)t->gaps, s_gap_s, (unsigned long long)t->backs);
+    for(uint32_t i=0;i<t->n_ev;i++){
+        const event_t *e = &t->ev[i];
+        printf("     @%-12llu %s -> ", (unsigned long long)e->off, fmt_utc(e->t0, b0, sizeof b0));
+        printf("%s  %+lld s\n", fmt_utc(e->t1, b1, sizeof b1), (long long)(e->t1 - e->t0));
+    }
+    if(t->gaps + t->backs > t->n_ev) printf("     ... (raise -E to list more)\n");
+}
+
+/* ==== 入力 =========================================================== */
+static int map_file(file_t *f)
+{
+    int fd = open(f->path, O_RDONLY);
+    if(fd < 0){ fprintf(stderr, "%s: %s\n", f->path, strerror(errno)); return 0; }
+    struct stat sb;
+    if(fstat(fd, &sb) != 0){ fprintf(stderr, "%s: %s\n", f->path, strerror(errno)); close(fd); return 0; }
+    f->size = (uint64_t)sb.st_size;
+    f->map  = NULL;
+    if(f->size){
+        void *m = mmap(NULL, (size_t)f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(m == MAP_FAILED){ fprintf(stderr, "%s: %s\n", f->path, strerror(errno)); close(fd); return 0; }
+        (void)madvise(m, (size_t)f->size, MADV_SEQUENTIAL);
+        f->map = (const uint8_t*)m;
+    }
+    close(fd);
+    return 1;
+}
+
+/* "64M" / "512k" / "1G" / バイト数 */
+static uint64_t parse_size(const char *s)
+{
+    char *e;
+    unsigned long long v = strtoull(s, &e, 10);
+    switch(*e){
+    case 'k': case 'K': v <<= 10; break;
+    case 'm': case 'M': v <<= 20; break;
+    case 'g': case 'G': v <<= 30; break;
+    case '\0': break;
+    default: return 0;
+    }
+    return (uint64_t)v;
+}
+
+static void usage(void)
+{
+    fputs("usage: nmea_scan [-j threads] [-s chunk(k/M/G)] [-G gap_s] [-E events] [-q] file...\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    long     nthr  = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t chunk = 32ULL << 20;
+    int quick = 0, o;
+    while((o = getopt(argc, argv, "j:s:G:E:qh")) != -1){
+        switch(o){
+        case 'j': nthr = atol(optarg); break;
+        case 's': chunk = parse_size(optarg); break;
+        case 'G': s_gap_s = (uint32_t)atoi(optarg); break;
+        case 'E': s_ev_max = (uint32_t)atoi(optarg); break;
+        case 'q': quick = 1; break;
+        default:  usage();
+        }
+    }
+    if(optind >= argc || nthr < 1 || chunk == 0U) usage();
+
+    uint32_t nf = (uint32_t)(argc - optind);
+    s_files = (file_t*)calloc(nf, sizeof *s_files);
+    if(!s_files){ perror("calloc"); return 1; }
+    int rc = 0;
+
+    /* 行頭で切る。チャンクの終わりを次の '\n' の後ろまで延ばす */
+    size_t cap = 0;
+    for(uint32_t i=0;i<nf;i++){
+        file_t *f = &s_files[i];
+        f->path = argv[optind + (int)i];
+        f->ok   = map_file(f);
+        if(!f->ok){ rc = 1; continue; }
+        for(uint64_t lo = 0; lo < f->size; ){
+            uint64_t hi = lo + chunk;
+            if(hi >= f->size) hi = f->size;
+            else{
+                const uint8_t *nl = (const uint8_t*)memchr(f->map + hi, '\n', (size_t)(f->size - hi));
+                hi = nl ? (uint64_t)(nl - f->map) + 1U : f->size;
+            }
+            if(s_nchunks == cap){
+                cap = cap ? cap * 2U : 64U;
+                s_chunks = (chunk_t*)realloc(s_chunks, cap * sizeof *s_chunks);
+                if(!s_chunks){ perror("realloc"); return 1; }
+            }
+            chunk_t *k = &s_chunks[s_nchunks++];
+            k->file = i; k->lo = lo; k->hi = hi;
+            tally_init(&k->t);
+            lo = hi;
+        }
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if((size_t)nthr > s_nchunks) nthr = s_nchunks ? (long)s_nchunks : 1;
+    pthread_t *th = (pthread_t*)calloc((size_t)nthr, sizeof *th);
+    if(!th){ perror("calloc"); return 1; }
+    for(long i=0;i<nthr;i++){
+        if(pthread_create(&th[i], NULL, worker, NULL) != 0){ perror("pthread_create"); return 1; }
+    }
+    for(long i=0;i<nthr;i++) pthread_join(th[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    uint64_t total = 0;
+    size_t   c = 0;
+    for(uint32_t i=0;i<nf;i++){
+        const file_t *f = &s_files[i];
+        if(!f->ok) continue;
+        tally_t a;
+        tally_init(&a);
+        for(; c < s_nchunks && s_chunks[c].file == i; c++) merge(&a, &s_chunks[c].t);
+        print_file(f, &a, quick);
+        total += a.bytes;
+        free(a.ev);
+        if(f->map) munmap((void*)f->map, (size_t)f->size);
+    }
+
+    double sec = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    fprintf(stderr, "%u files, %.1f MB in %.3f s (%.0f MB/s, %ld threads, %zu chunks)\n",
+            nf, (double)total / 1e6, sec, sec > 0.0 ? (double)total / 1e6 / sec : 0.0, nthr, s_nchunks);
+    for(size_t i=0;i<s_nchunks;i++) free(s_chunks[i].t.ev);
+    free(s_chunks); free(s_files); free(th);
+    return rc;
+}
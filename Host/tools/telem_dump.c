@@ -0,0 +1,243 @@
+/* USART2（VCP）のバイナリテレメトリを復号して1行ずつ表示する（Linux）。
+   フレームと本文の形式は Core/Inc/telem.h。
+
+     telem_dump /dev/ttyACM0            38400bps 生モードで開いて読み続ける
+     telem_dump -b 115200 /dev/ttyACM0
+     telem_dump capture.bin             記録したバイト列（- で標準入力）
+     telem_dump -c ...                  CRC 不一致・欠番も表示
+
+   終了時（EOF か Ctrl-C）に受信フレーム数・CRC 不一致・seq の欠番を標準エラーへ */
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* telem.h と合わせる */
+#define TM_FIX   0x01U
+#define TM_GPS   0x02U
+#define TM_TIME  0x03U
+#define TM_DISP  0x04U
+#define TM_NMEA  0x05U
+#define TM_TEXT  0x06U
+#define TM_PROF  0x07U
+#define FRAME_MAX 256
+
+static volatile sig_atomic_t s_stop = 0;
+static void on_sig(int s){ (void)s; s_stop = 1; }
+
+static struct {
+    uint32_t frames, crc_bad, cobs_bad, short_bad, seq_gap;
+    int      have_seq;
+    uint8_t  seq;
+} s_st;
+static int s_verbose = 0;
+
+/* ==== 復号 =========================================================== */
+static uint16_t crc16(const uint8_t *p, size_t n)
+{
+    uint16_t c = 0xFFFFU;
+    while(n--){
+        c ^= (uint16_t)(*p++ << 8);
+        for(int b=0;b<8;b++) c = (c & 0x8000U) ? (uint16_t)((c << 1) ^ 0x1021U) : (uint16_t)(c << 1);
+    }
+    return c;
+}
+
+/* 区切りを除いた COBS 列を戻す。返値=長さ、-1=不正 */
+static int uncobs(const uint8_t *in, size_t n, uint8_t *out)
+{
+    size_t i = 0, o = 0;
+    while(i < n){
+        uint8_t code = in[i++];
+        if(code == 0U || i + code - 1U > n) return -1;
+        for(uint8_t k=1;k<code;k++) out[o++] = in[i++];
+        if(code != 0xFFU && i < n) out[o++] = 0U;
+    }
+    return (int)o;
+}
+
+static uint16_t u16(const uint8_t *p){ return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t u32(const uint8_t *p){ return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static int16_t  i16(const uint8_t *p){ return (int16_t)u16(p); }
+static int32_t  i32(const uint8_t *p){ return (int32_t)u32(p); }
+
+/* 度＋マイクロ分（同符号）。未取得は GPS_FX_INVALID */
+static void print_dm(const char *tag, int16_t deg, int32_t umin)
+{
+    if(umin == INT32_MIN){ printf(" %s=-", tag); return; }
+    int  neg = (deg < 0 || umin < 0);
+    long d = deg < 0 ? -(long)deg : deg, um = umin < 0 ? -(long)umin : umin;
+    printf(" %s=%s%ld°%ld.%06ld'", tag, neg ? "-" : "", d, um / 1000000L, um % 1000000L);
+}
+
+static void show(uint8_t type, const uint8_t *b, size_t n)
+{
+    static const char *const TK[5] = { "UNSYNC", "NMEA", "PPS", "HOLDOVER", "ESTIMATE" };
+    static const char *const SENT[7] = { "RMC", "GGA", "ZDA", "VTG", "GSA", "GSV", "GLL" };
+
+    switch(type){
+    case TM_FIX:
+        if(n < 47U) break;
+        printf("FIX  gen=%u tick=%u %04d-%02d-%02d %02d:%02d:%02d tz=%+d",
+               u32(b), u32(b+4), i16(b+32), (int8_t)b[34], (int8_t)b[35],
+               (int8_t)b[36], (int8_t)b[37], (int8_t)b[38], i16(b+39));
+        print_dm("lat", i16(b+8), i32(b+10));
+        print_dm("lon", i16(b+14), i32(b+16));
+        printf(" alt=%dmm spd=%dmm/s cog=%d fix=%d sat=%d/%d hdop=%d upd=0x%02X\n",
+               i32(b+20), i32(b+24), i32(b+28), (int8_t)b[41], (int8_t)b[42], (int8_t)b[43],
+               i16(b+44), b[46]);
+        return;
+    case TM_GPS:
+        if(n < 78U) break;
+        printf("GPS  bytes=%u lines=%u drop=%u ovf=%u resync=%u hwm=%u",
+               u32(b), u32(b+4), u32(b+8), u32(b+12), u32(b+16), u16(b+20));
+        for(int i=0;i<7;i++) printf(" %s=%u/%u", SENT[i], u32(b+22+8*i), u32(b+26+8*i));
+        putchar('\n');
+        return;
+    case TM_TIME:
+        if(n < 29U) break;
+        printf("TIME tick=%u state=%s sod=%d sub_us=%u ppb=%d pps=%u rej=%u relabel=%u",
+               u32(b), b[4] < 5U ? TK[b[4]] : "?", i32(b+5), u32(b+9), i32(b+13),
+               u32(b+17), u32(b+21), u32(b+25));
+        if(n >= 35U) printf(" busy=%u.%u%% wake=%u", u16(b+29) / 10U, u16(b+29) % 10U, u32(b+31));
+        putchar('\n');
+        return;
+    case TM_DISP:
+        if(n < 25U) break;
+        printf("DISP codes=");
+        for(int i=0;i<8;i++) printf("%03X%s", u16(b+2*i), i < 7 ? "," : "");
+        printf(" duty=");
+        for(int i=0;i<8;i++) printf("%u%s", b[16+i], i < 7 ? "," : "");
+        printf(" %s%s%s\n", (b[24] & 1U) ? "UTC" : "LOCAL", (b[24] & 2U) ? " ANIM" : "", (b[24] & 4U) ? " ACP" : "");
+        return;
+    case TM_NMEA:
+        printf("NMEA %.*s\n", (int)n, (const char*)b);
+        return;
+    case TM_TEXT:
+        fwrite(b, 1, n, stdout);
+        if(n == 0U || b[n-1] != '\n') putchar('\n');
+        return;
+    case TM_PROF:
+        if(n < 17U) break;
+        printf("PROF %-14.*s n=%u min=%u mean=%u max=%u\n", (int)(n - 17U), (const char*)b + 17,
+               u32(b+1), u32(b+5), u32(b+9), u32(b+13));
+        return;
+    default:
+        printf("?%02X  len=%zu\n", type, n);
+        return;
+    }
+    s_st.short_bad++;
+    if(s_verbose) printf("!short type=%02X len=%zu\n", type, n);
+}
+
+/* 区切り（0x00）までの1フレーム */
+static void frame(const uint8_t *enc, size_t n)
+{
+    uint8_t raw[FRAME_MAX];
+    if(n == 0U) return;
+    int m = (n < FRAME_MAX) ? uncobs(enc, n, raw) : -1;
+    if(m < 4){
+        s_st.cobs_bad++;
+        if(s_verbose) printf("!cobs len=%zu\n", n);
+        return;
+    }
+    uint16_t c = crc16(raw, (size_t)m - 2U);
+    if(c != u16(raw + m - 2)){
+        s_st.crc_bad++;
+        if(s_verbose) printf("!crc type=%02X len=%d\n", raw[0], m);
+        return;
+    }
+    s_st.frames++;
+    if(s_st.have_seq && raw[1] != (uint8_t)(s_st.seq + 1U)){
+        s_st.seq_gap += (uint8_t)(raw[1] - s_st.seq - 1U);
+        if(s_verbose) printf("!seq %u -> %u\n", s_st.seq, raw[1]);
+    }
+    s_st.seq = raw[1];
+    s_st.have_seq = 1;
+    show(raw[0], raw + 2, (size_t)m - 4U);
+    fflush(stdout);
+}
+
+/* ==== 入力 =========================================================== */
+static speed_t baud_const(long b)
+{
+    switch(b){
+    case 9600: return B9600;     case 19200: return B19200;   case 38400: return B38400;
+    case 57600: return B57600;   case 115200: return B115200; case 230400: return B230400;
+    default: return 0;
+    }
+}
+
+static int open_input(const char *path, long baud)
+{
+    if(strcmp(path, "-") == 0) return STDIN_FILENO;
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if(fd < 0){ perror(path); exit(2); }
+    if(isatty(fd)){
+        struct termios t;
+        speed_t sp = baud_const(baud);
+        if(!sp){ fprintf(stderr, "unsupported baud %ld\n", baud); exit(2); }
+        if(tcgetattr(fd, &t) != 0){ perror("tcgetattr"); exit(2); }
+        cfmakeraw(&t);
+        cfsetispeed(&t, sp);
+        cfsetospeed(&t, sp);
+        t.c_cflag |= CLOCAL | CREAD;
+        t.c_cc[VMIN] = 1; t.c_cc[VTIME] = 0;
+        if(tcsetattr(fd, TCSANOW, &t) != 0){ perror("tcsetattr"); exit(2); }
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+static void usage(void)
+{
+    fputs("usage: telem_dump [-b baud] [-c] <tty|file|->\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    long baud = 38400;
+    int o;
+    while((o = getopt(argc, argv, "b:ch")) != -1){
+        switch(o){
+        case 'b': baud = atol(optarg); break;
+        case 'c': s_verbose = 1; break;
+        default:  usage();
+        }
+    }
+    if(optind != argc - 1) usage();
+    int fd = open_input(argv[optind], baud);
+    int sync = !isatty(fd);                /* 端末は途中から読むので最初の区切りまで捨てる */
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = on_sig;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    uint8_t buf[512], enc[FRAME_MAX * 2];
+    size_t  el = 0;
+    while(!s_stop){
+        ssize_t r = read(fd, buf, sizeof buf);
+        if(r < 0){ if(errno == EINTR) continue; perror("read"); break; }
+        if(r == 0) break;
+        for(ssize_t i=0;i<r;i++){
+            if(buf[i] == 0U){
+                if(sync) frame(enc, el);
+                sync = 1; el = 0;
+            }else if(el < sizeof enc){
+                enc[el++] = buf[i];
+            }
+        }
+    }
+    fprintf(stderr, "frames=%u crc_bad=%u cobs_bad=%u short=%u seq_gap=%u\n",
+            s_st.frames, s_st.crc_bad, s_st.cobs_bad, s_st.short_bad, s_st.seq_gap);
+    return (s_st.crc_bad || s_st.cobs_bad) ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# 時差表 Core/Src/tz_table.c を生成する。
+#   python3 Host/tools/tzgen.py [-z /usr/share/zoneinfo] [-o Core/Src/tz_table.c] [Host/tools/tz_regions.txt]
+# 地域（矩形）は tz_regions.txt、各区域の規則は tzdata の TZif 末尾の POSIX TZ 文字列
+# （例 "CET-1CEST,M3.5.0,M10.5.0/3"）から取る。同じ規則の区域は1つの規則番号にまとめる。
+# 規則の切替日は Mm.w.d 形式のみ（Jn / n 形式は今の tzdata の末尾文字列には出ない）。
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.normpath(os.path.join(HERE, '..', '..'))
+
+
+def die(msg):
+    sys.exit('tzgen: ' + msg)
+
+
+def footer(zdir, zone):
+    """TZif の最後の行（POSIX TZ 文字列）"""
+    path = os.path.join(zdir, zone)
+    try:
+        data = open(path, 'rb').read()
+    except OSError as e:
+        die('%s: %s' % (zone, e))
+    if not data.startswith(b'TZif') or not data.endswith(b'\n'):
+        die('%s: not a TZif file with footer' % zone)
+    return data[:-1].rsplit(b'\n', 1)[1].decode('ascii')
+
+
+def hms_min(s):
+    """[+-]hh[:mm[:ss]] → 分"""
+    m = re.fullmatch(r'([+-]?)(\d+)(?::(\d+))?(?::(\d+))?', s)
+    if not m:
+        raise ValueError(s)
+    v = int(m.group(2)) * 60 + int(m.group(3) or 0)
+    if int(m.group(4) or 0):
+        raise ValueError('seconds in ' + s)
+    return -v if m.group(1) == '-' else v
+
+
+def parse_posix(tz):
+    """→ (std_min, dst_min, start, end)。分は東が正。start/end = (月, 週, 曜日, 分) か None"""
+    name = r'(?:<[^>]+>|[A-Za-z]{3,})'
+    off = r'([+-]?\d+(?::\d+){0,2})'
+    m = re.fullmatch(name + off + r'(?:' + name + r'(?:' + off + r')?(?:,([^,]+),([^,]+)))?', tz)
+    if not m:
+        raise ValueError(tz)
+    std = -hms_min(m.group(1))
+    if m.group(3) is None:
+        return std, std, None, None
+    dst = -hms_min(m.group(2)) if m.group(2) else std + 60
+
+    def when(s):
+        w = re.fullmatch(r'M(\d+)\.(\d)\.(\d)(?:/(.+))?', s)
+        if not w:
+            raise ValueError('unsupported rule ' + s)
+        mon, week, wday = int(w.group(1)), int(w.group(2)), int(w.group(3))
+        if not (1 <= mon <= 12 and 1 <= week <= 5 and wday <= 6):
+            raise ValueError(s)
+        return mon, week, wday, hms_min(w.group(4)) if w.group(4) else 120
+
+    return std, dst, when(m.group(3)), when(m.group(4))
+
+
+def cdeg(s):
+    return int(round(float(s) * 100))
+
+
+def read_regions(path):
+    boxes = []
+    for n, line in enumerate(open(path, encoding='utf-8'), 1):
+        line = line.split('#', 1)[0].split()
+        if not line:
+            continue
+        if len(line) != 5:
+            die('%s:%d: expected "zone lat0 lat1 lon0 lon1"' % (path, n))
+        zone, lat0, lat1, lon0, lon1 = line[0], *map(cdeg, line[1:])
+        if not (-9000 <= lat0 < lat1 <= 9000 and -18000 <= lon0 < lon1 <= 18000):
+            die('%s:%d: bad box' % (path, n))
+        boxes.append((zone, lat0, lat1, lon0, lon1))
+    return boxes
+
+
+def tzdata_version(zdir):
+    try:
+        for line in open(os.path.join(zdir, 'tzdata.zi'), encoding='ascii'):
+            if line.startswith('# version '):
+                return line.split()[2]
+    except OSError:
+        pass
+    return 'unknown'
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('-z', '--zoneinfo', default='/usr/share/zoneinfo')
+    ap.add_argument('-o', '--output', default=os.path.join(ROOT, 'Core', 'Src', 'tz_table.c'))
+    ap.add_argument('regions', nargs='?', default=os.path.join(HERE, 'tz_regions.txt'))
+    a = ap.parse_args()
+
+    boxes = read_regions(a.regions)
+    rules, names, rule_of = [], [], {}       # 規則（重複なし）・代表名・区域→規則番号
+    for zone, *_ in boxes:
+        if zone in rule_of:
+            continue
+        posix = footer(a.zoneinfo, zone)
+        try:
+            r = parse_posix(posix)
+        except ValueError as e:
+            die('%s: %s: %s' % (zone, posix, e))
+        if r not in rules:
+            rules.append(r)
+            names.append((zone, posix))
+        rule_of[zone] = rules.index(r)
+    # 代表名は矩形の多い区域（同数なら先に出たもの）
+    count = {}
+    for zone, *_ in boxes:
+        count[zone] = count.get(zone, 0) + 1
+    for zone in sorted(rule_of, key=lambda z: -count[z]):
+        i = rule_of[zone]
+        if count[zone] > count[names[i][0]]:
+            names[i] = (zone, names[i][1])
+    if len(rules) > 254:
+        die('too many rules')
+
+    def when_c(w):
+        return '{ 0,0,0,    0 }' if w is None else '{%2d,%d,%d,%5d }' % w
+
+    out = []
+    out.append('/* 生成ファイル（Host/tools/tzgen.py、tzdata %s）。手で直さず tz_regions.txt を直して再生成する */'
+               % tzdata_version(a.zoneinfo))
+    out.append('#include "tz.h"')
+    out.append('')
+    out.append('/* 標準時差・夏時間の時差 [分、東+]、夏時間の始まり・終わり {月, 第n週(5=最終), 曜日(0=日), 現地時刻[分]} */')
+    out.append('const tz_rule_t TZ_RULES[] = {')
+    for i, ((std, dst, s, e), (zone, posix)) in enumerate(zip(rules, names)):
+        out.append('    { %4d, %4d, %s, %s },   /* %2d %-22s %s */' % (std, dst, when_c(s), when_c(e), i, zone, posix))
+    out.append('};')
+    out.append('')
+    out.append('#if TZ_WITH_NAMES')
+    out.append('const char *const TZ_NAMES[] = {')
+    for zone, _ in names:
+        out.append('    "%s",' % zone)
+    out.append('};')
+    out.append('#endif')
+    out.append('')
+    out.append('/* 南端, 北端, 西端, 東端 [0.01度], 規則番号。先頭から照合する */')
+    out.append('const tz_box_t TZ_BOXES[] = {')
+    for zone, lat0, lat1, lon0, lon1 in boxes:
+        out.append('    { %6d, %6d, %6d, %6d, %3d },   /* %s */' % (lat0, lat1, lon0, lon1, rule_of[zone], zone))
+    out.append('};')
+    out.append('')
+    out.append('const uint8_t  TZ_N_RULES = %d;' % len(rules))
+    out.append('const uint16_t TZ_N_BOXES = %d;' % len(boxes))
+    text = '\r\n'.join(out) + '\r\n'
+
+    with open(a.output, 'w', encoding='utf-8', newline='') as f:
+        f.write(text)
+    print('%s: %d rules, %d boxes' % (os.path.relpath(a.output), len(rules), len(boxes)))
+
+
+if __name__ == '__main__':
+    main()